@@ -1,10 +1,149 @@
 #include "AssetCompiler.h"
 #include "Core/common/string_utils.h"
 #include "Core/logging/logging.h"
+#include "Core/common/hash.hpp"
 #include "Runtime/System/FileSystem.h"
 #include "ShaderCompiler/shaderc.h"
+#include "BlockEncoder.h"
+#include "MeshOptimizer.h"
+#include "Runtime/System/Application.h"
+#include "Runtime/Threading/ThreadPool.h"
+#include "Runtime/Rendering/Mesh.h"
+#include "Graphics/graphics.h"
+#include "Graphics/src/image.h"
+#include "Graphics/bx/crtimpl.h"
 
-void ShaderCompiler::compile(const fs::path& absoluteKey)
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+typedef unsigned char stbi_uc;
+extern "C" stbi_uc *stbi_load_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp);
+extern "C" void stbi_image_free(void *retval_from_stbi_load);
+
+namespace
+{
+	std::uint64_t hashFile(const fs::path& path, std::uint64_t hash)
+	{
+		std::ifstream stream(path.string(), std::ios::in | std::ios::binary);
+		if (!stream)
+		{
+			static const char missing[] = "<missing>";
+			return core::fnv1a64(missing, sizeof(missing), hash);
+		}
+
+		const std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		return core::fnv1a64(content.data(), content.size(), hash);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : readDepends ()
+	/// <summary>
+	/// Reads the includes from the makefile style depends file shaderc writes
+	/// next to its output.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<std::string> readDepends(const fs::path& path)
+	{
+		std::vector<std::string> depends;
+		std::ifstream stream(path.string(), std::ios::in);
+		const std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+		const auto separator = content.find(" : ");
+		if (separator == std::string::npos)
+			return depends;
+
+		std::istringstream tokens(content.substr(separator + 3));
+		std::string token;
+		while (tokens >> token)
+		{
+			if (token != "\\")
+				depends.push_back(token);
+		}
+		return depends;
+	}
+
+	std::uint64_t readStamp(const fs::path& path)
+	{
+		std::uint64_t stamp = 0;
+		std::ifstream stream(path.string(), std::ios::in);
+		stream >> std::hex >> stamp;
+		return stamp;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : compileTarget ()
+	/// <summary>
+	/// Compiles the shader for one platform unless the hash of its flags,
+	/// source, varyings and includes matches the one of the last build.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void compileTarget(const std::vector<std::string>& args, const fs::path& input, const fs::path& varying,
+		const fs::path& output, bool glslOptimizer, bool force)
+	{
+		auto logger = logging::get("Log");
+		const std::string strOutput = output.string();
+		fs::path depends = output;
+		depends += ".d";
+		fs::path stamp = output;
+		stamp.replace_extension(".hash");
+
+		std::uint64_t hash = core::fnv1a64_basis;
+		for (const auto& arg : args)
+			hash = core::fnv1a64(arg.c_str(), arg.size() + 1, hash);
+		hash = hashFile(input, hash);
+		hash = hashFile(varying, hash);
+
+		auto hashDepends = [&depends](std::uint64_t hash)
+		{
+			for (const auto& include : readDepends(depends))
+				hash = hashFile(include, hash);
+			return hash;
+		};
+
+		if (!force && fs::exists(output, std::error_code{}) && readStamp(stamp) == hashDepends(hash))
+			return;
+
+		std::vector<const char*> argv;
+		for (const auto& arg : args)
+			argv.push_back(arg.c_str());
+
+		int result = EXIT_FAILURE;
+		if (glslOptimizer)
+		{
+			//glsl-optimizer is not thread safe
+			static std::mutex mtx;
+			std::lock_guard<std::mutex> lock(mtx);
+			result = compileShader(int(argv.size()), argv.data());
+		}
+		else
+		{
+			result = compileShader(int(argv.size()), argv.data());
+		}
+
+		if (result == EXIT_FAILURE)
+		{
+			fs::remove(stamp, std::error_code{});
+			logger->error().write("Failed to compile shader: {0}", strOutput.c_str());
+			return;
+		}
+
+		// the includes may have changed with the source, they are read from the new depends file
+		std::ofstream stream(stamp.string(), std::ios::out | std::ios::trunc);
+		stream << std::hex << hashDepends(hash);
+		logger->info().write("Successfully compiled shader: {0}", strOutput.c_str());
+	}
+}
+
+void ShaderCompiler::compile(const fs::path& absoluteKey, bool force)
 {
 	fs::path input = absoluteKey;
 	std::string strInput = input.string();
@@ -17,101 +156,889 @@ void ShaderCompiler::compile(const fs::path& absoluteKey)
 	bool fs = string_utils::beginsWith(file, "fs_");
 	bool cs = string_utils::beginsWith(file, "cs_");
 	fs::path supported[] = { "dx9", "dx11", "glsl", "metal" };
-	
+
+	const std::string strInclude = fs::resolve_protocol("engine://Tools/include").string();
+	const fs::path varying = dir / "varying.def.sc";
+	const std::string strVarying = varying.string();
+
+	// the platforms are independent, only the ones using the glsl optimizer wait for each other
+	auto& threadPool = Singleton<Application>::getInstance().getThreadPool();
+	auto parent = threadPool.createJob([]() {});
 	for (int i = 0; i < 4; ++i)
 	{
 		fs::path output = dir / "runtime";
 		fs::create_directory(output, std::error_code{});
 
-		output = output / supported[i] / fs::path(file + ext);
+		output = output / supported[i];
 		fs::create_directory(output, std::error_code{});
-		std::string strOutput = output.string();
-
-		const char* args_array[18];
-		args_array[0] = "-f";
-		args_array[1] = strInput.c_str();
-		args_array[2] = "-o";
-		args_array[3] = strOutput.c_str();
-		args_array[4] = "--depends";
-		args_array[5] = "-i";
-		fs::path include = fs::resolve_protocol("engine://Tools/include");
-		std::string strInclude = include.string();
-		args_array[6] = strInclude.c_str();
-		args_array[7] = "--varyingdef";
-		fs::path varying = dir / "varying.def.sc";
-		std::string strVarying = varying.string();
-		args_array[8] = strVarying.c_str();
-		args_array[9] = "--platform";
-
-		if(i < 2)
-		{
-			args_array[10] = "windows";
-			args_array[11] = "--profile";
+		output = output / fs::path(file + ext);
+
+		std::vector<std::string> args =
+		{
+			"-f", strInput,
+			"-o", output.string(),
+			"--depends",
+			"-i", strInclude,
+			"--varyingdef", strVarying,
+			"--platform",
+		};
+
+		if (i < 2)
+		{
+			args.push_back("windows");
+			args.push_back("--profile");
 
 			if (vs)
-				args_array[12] = "vs_4_0";
+				args.push_back("vs_4_0");
 			else if (fs)
-				args_array[12] = "ps_4_0";
+				args.push_back("ps_4_0");
 			else if (cs)
-				args_array[12] = "cs_5_0";
+				args.push_back("cs_5_0");
 		}
 		else if (i == 2)
 		{
-			args_array[10] = "linux";
-			args_array[11] = "--profile";
+			args.push_back("linux");
+			args.push_back("--profile");
 
 			if (vs || fs)
-				args_array[12] = "120";
+				args.push_back("120");
 			else if (cs)
-				args_array[12] = "430";
+				args.push_back("430");
 		}
 		else if (i == 3)
 		{
-			args_array[10] = "osx";
-			args_array[11] = "--profile";
-			args_array[12] = "metal";
+			args.push_back("osx");
+			args.push_back("--profile");
+			args.push_back("metal");
 		}
-		args_array[13] = "--type";
+		args.push_back("--type");
 		if (vs)
-			args_array[14] = "vertex";
+			args.push_back("vertex");
 		else if (fs)
-			args_array[14] = "fragment";
+			args.push_back("fragment");
 		else if (cs)
-			args_array[14] = "compute";
+			args.push_back("compute");
 
-		args_array[15] = "-O";
-		args_array[16] = "3";
-		args_array[17] = "--disasm";
+		args.push_back("-O");
+		args.push_back("3");
+		args.push_back("--disasm");
 
-		auto logger = logging::get("Log");
-		
-		
-		if (i >= 2)
+		const fs::path source = strInput;
+		const bool glslOptimizer = i >= 2;
+		threadPool.run(threadPool.createChildJob(parent, [args, source, varying, output, glslOptimizer, force]()
 		{
-			//glsl shader compilation is not thread safe-
-			static std::mutex mtx;
-			std::lock_guard<std::mutex> lock(mtx);
-			if (compileShader(18, args_array) == EXIT_FAILURE)
+			compileTarget(args, source, varying, output, glslOptimizer, force);
+		}));
+	}
+	threadPool.run(parent);
+	threadPool.wait(parent);
+}
+
+bool ShaderCompiler::dependsOn(const fs::path& absoluteKey, const fs::path& include)
+{
+	const fs::path dir = absoluteKey.parent_path() / "runtime";
+	const std::string depends = absoluteKey.filename().replace_extension().string() + ".asset.d";
+	static const char* supported[] = { "dx9", "dx11", "glsl", "metal" };
+	for (const auto platform : supported)
+	{
+		for (const auto& dependency : readDepends(dir / platform / depends))
+		{
+			std::error_code err;
+			if (fs::equivalent(dependency, include, err))
+				return true;
+		}
+	}
+	return false;
+}
+
+namespace
+{
+	struct TextureMip
+	{
+		std::uint32_t width = 0;
+		std::uint32_t height = 0;
+		std::vector<std::uint8_t> rgba;
+	};
+
+	bool isNormalMap(const std::string& file)
+	{
+		static const std::string suffixes[] = { "_n", "_normal", "_nrm", "_nor" };
+		const auto name = string_utils::toLower(file);
+		for (const auto& suffix : suffixes)
+		{
+			if (string_utils::endsWith(name, suffix))
+				return true;
+		}
+		return false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : downsampleClamped ()
+	/// <summary>
+	/// Box filter for mips where one side already reached a single pixel,
+	/// which the 2x2 filters of the image library skip.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename T>
+	void downsampleClamped(const T* src, std::uint32_t width, std::uint32_t height, T* dst)
+	{
+		const std::uint32_t dstWidth = std::max(1u, width / 2);
+		const std::uint32_t dstHeight = std::max(1u, height / 2);
+		const float rounding = std::is_integral<T>::value ? 0.5f : 0.0f;
+		for (std::uint32_t y = 0; y < dstHeight; ++y)
+		{
+			const std::uint32_t y0 = std::min(y * 2, height - 1);
+			const std::uint32_t y1 = std::min(y * 2 + 1, height - 1);
+			for (std::uint32_t x = 0; x < dstWidth; ++x)
 			{
-				logger->error().write("Failed to compile shader: {0}", strOutput.c_str());
+				const std::uint32_t x0 = std::min(x * 2, width - 1);
+				const std::uint32_t x1 = std::min(x * 2 + 1, width - 1);
+				for (std::uint32_t c = 0; c < 4; ++c)
+				{
+					const float sum = float(src[(y0 * width + x0) * 4 + c]) + float(src[(y0 * width + x1) * 4 + c])
+						+ float(src[(y1 * width + x0) * 4 + c]) + float(src[(y1 * width + x1) * 4 + c]);
+					dst[(y * dstWidth + x) * 4 + c] = T(sum * 0.25f + rounding);
+				}
 			}
+		}
+	}
+
+	std::vector<TextureMip> buildColorMips(std::vector<std::uint8_t> image, std::uint32_t width, std::uint32_t height)
+	{
+		std::vector<TextureMip> mips(1);
+		mips[0].width = width;
+		mips[0].height = height;
+		mips[0].rgba = std::move(image);
+
+		while (mips.back().width > 1 || mips.back().height > 1)
+		{
+			const auto& src = mips.back();
+			TextureMip mip;
+			mip.width = std::max(1u, src.width / 2);
+			mip.height = std::max(1u, src.height / 2);
+			mip.rgba.resize(mip.width * mip.height * 4);
+			if (src.width >= 2 && src.height >= 2)
+				gfx::imageRgba8Downsample2x2(src.width, src.height, src.width * 4, src.rgba.data(), mip.rgba.data());
 			else
+				downsampleClamped(src.rgba.data(), src.width, src.height, mip.rgba.data());
+			mips.push_back(std::move(mip));
+		}
+		return mips;
+	}
+
+	std::vector<TextureMip> buildNormalMips(const std::vector<std::uint8_t>& image, std::uint32_t width, std::uint32_t height)
+	{
+		// normals are filtered as unit vectors and packed again per mip
+		std::vector<float> normals(image.size());
+		for (std::size_t i = 0; i < image.size(); ++i)
+			normals[i] = image[i] / 255.0f * 2.0f - 1.0f;
+
+		std::vector<TextureMip> mips;
+		while (true)
+		{
+			TextureMip mip;
+			mip.width = width;
+			mip.height = height;
+			mip.rgba.resize(normals.size());
+			for (std::size_t i = 0; i < normals.size(); ++i)
 			{
-				logger->info().write("Successfully compiled shader: {0}", strOutput.c_str());
+				const float value = (i % 4) == 3 ? 1.0f : normals[i];
+				mip.rgba[i] = std::uint8_t(std::min(std::max(value * 0.5f + 0.5f, 0.0f), 1.0f) * 255.0f + 0.5f);
 			}
+			mips.push_back(std::move(mip));
+
+			if (width == 1 && height == 1)
+				break;
+
+			const std::uint32_t nextWidth = std::max(1u, width / 2);
+			const std::uint32_t nextHeight = std::max(1u, height / 2);
+			std::vector<float> next(nextWidth * nextHeight * 4, 1.0f);
+			if (width >= 2 && height >= 2)
+			{
+				gfx::imageRgba32fDownsample2x2NormalMap(width, height, width * 16, normals.data(), next.data());
+			}
+			else
+			{
+				downsampleClamped(normals.data(), width, height, next.data());
+				for (std::size_t i = 0; i < next.size(); i += 4)
+				{
+					const float length = std::sqrt(next[i] * next[i] + next[i + 1] * next[i + 1] + next[i + 2] * next[i + 2]);
+					for (std::size_t c = 0; c < 3 && length > 0.0f; ++c)
+						next[i + c] /= length;
+				}
+			}
+			normals = std::move(next);
+			width = nextWidth;
+			height = nextHeight;
 		}
-		else
+		return mips;
+	}
+}
+
+void TextureCompiler::compile(const fs::path& absoluteKey)
+{
+	fs::path input = absoluteKey;
+	std::string strInput = input.string();
+	std::string file = input.filename().replace_extension().string();
+	fs::path dir = input.remove_filename();
+
+	static const std::string ext = ".asset";
+
+	fs::path output = dir / "runtime";
+	fs::create_directory(output, std::error_code{});
+	output = output / fs::path(file + ext);
+	std::string strOutput = output.string();
+
+	auto logger = logging::get("Log");
+
+	std::ifstream stream(strInput, std::ios::in | std::ios::binary);
+	std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	int width = 0;
+	int height = 0;
+	int components = 0;
+	stbi_uc* pixels = data.empty() ? nullptr : stbi_load_from_memory(data.data(), int(data.size()), &width, &height, &components, 4);
+	if (!pixels)
+	{
+		logger->error().write("Failed to compile texture: {0}", strInput.c_str());
+		return;
+	}
+	std::vector<std::uint8_t> image(pixels, pixels + width * height * 4);
+	stbi_image_free(pixels);
+
+	const bool normalMap = isNormalMap(file);
+	Format selected = format;
+	if (selected == Format::Auto)
+	{
+		bool alpha = false;
+		for (std::size_t i = 3; i < image.size() && !alpha; i += 4)
+			alpha = image[i] < 255;
+
+		// BC7 would suit alpha better, but dx9 cannot sample it
+		selected = normalMap ? Format::BC5 : alpha ? Format::BC3 : Format::BC1;
+	}
+
+	const auto mips = normalMap
+		? buildNormalMips(image, std::uint32_t(width), std::uint32_t(height))
+		: buildColorMips(std::move(image), std::uint32_t(width), std::uint32_t(height));
+
+	gfx::TextureFormat::Enum textureFormat = gfx::TextureFormat::RGBA8;
+	std::uint32_t blockBytes = 0;
+	void (*encode)(const std::uint8_t*, std::uint8_t*) = nullptr;
+	switch (selected)
+	{
+	case Format::BC1: textureFormat = gfx::TextureFormat::BC1; blockBytes = 8; encode = bc::encodeBC1; break;
+	case Format::BC3: textureFormat = gfx::TextureFormat::BC3; blockBytes = 16; encode = bc::encodeBC3; break;
+	case Format::BC5: textureFormat = gfx::TextureFormat::BC5; blockBytes = 16; encode = bc::encodeBC5; break;
+	case Format::BC7: textureFormat = gfx::TextureFormat::BC7; blockBytes = 16; encode = bc::encodeBC7; break;
+	default: break;
+	}
+
+	// mip sizes follow the ktx writer, which pads every mip to whole blocks
+	struct Band
+	{
+		const TextureMip* mip;
+		std::uint32_t blocksX;
+		std::uint32_t blockRow0;
+		std::uint32_t blockRow1;
+		std::size_t offset;
+	};
+	std::vector<Band> bands;
+	std::size_t size = 0;
+
+	auto& threadPool = Singleton<Application>::getInstance().getThreadPool();
+	const std::uint32_t workers = std::uint32_t(threadPool.getWorkerCount());
+	std::uint32_t paddedWidth = std::uint32_t(width);
+	std::uint32_t paddedHeight = std::uint32_t(height);
+	for (const auto& mip : mips)
+	{
+		if (!encode)
 		{
-			if (compileShader(18, args_array) == EXIT_FAILURE)
+			size += mip.rgba.size();
+			continue;
+		}
+
+		paddedWidth = std::max(4u, (paddedWidth + 3) / 4 * 4);
+		paddedHeight = std::max(4u, (paddedHeight + 3) / 4 * 4);
+		const std::uint32_t blocksX = paddedWidth / 4;
+		const std::uint32_t blocksY = paddedHeight / 4;
+		const std::uint32_t count = std::max(1u, std::min(workers + 1, blocksY));
+		for (std::uint32_t band = 0; band < count; ++band)
+		{
+			const std::uint32_t row0 = blocksY * band / count;
+			const std::uint32_t row1 = blocksY * (band + 1) / count;
+			bands.push_back({ &mip, blocksX, row0, row1, size + std::size_t(row0) * blocksX * blockBytes });
+		}
+		size += std::size_t(blocksX) * blocksY * blockBytes;
+		paddedWidth >>= 1;
+		paddedHeight >>= 1;
+	}
+
+	std::vector<std::uint8_t> encoded(size);
+	if (!encode)
+	{
+		std::size_t offset = 0;
+		for (const auto& mip : mips)
+		{
+			std::copy(mip.rgba.begin(), mip.rgba.end(), encoded.begin() + offset);
+			offset += mip.rgba.size();
+		}
+	}
+	else
+	{
+		auto parent = threadPool.createJob([]() {});
+		for (const auto& band : bands)
+		{
+			threadPool.run(threadPool.createChildJob(parent, [&encoded, band, blockBytes, encode]()
 			{
-				logger->error().write("Failed to compile shader: {0}", strOutput.c_str());
+				const auto& mip = *band.mip;
+				std::uint8_t block[64];
+				std::uint8_t* dst = encoded.data() + band.offset;
+				for (std::uint32_t by = band.blockRow0; by < band.blockRow1; ++by)
+				{
+					for (std::uint32_t bx = 0; bx < band.blocksX; ++bx, dst += blockBytes)
+					{
+						// blocks past the edge of small mips repeat the last pixel
+						for (std::uint32_t i = 0; i < 16; ++i)
+						{
+							const std::uint32_t x = std::min(bx * 4 + i % 4, mip.width - 1);
+							const std::uint32_t y = std::min(by * 4 + i / 4, mip.height - 1);
+							std::copy_n(&mip.rgba[(y * mip.width + x) * 4], 4, &block[i * 4]);
+						}
+						encode(block, dst);
+					}
+				}
+			}));
+		}
+		threadPool.run(parent);
+		threadPool.wait(parent);
+	}
+
+	bx::Error err;
+	bx::CrtFileWriter writer;
+	if (writer.open(strOutput.c_str(), false, &err))
+	{
+		gfx::imageWriteKtx(&writer, textureFormat, false, width, height, 0, std::uint8_t(mips.size()), encoded.data(), &err);
+		writer.close();
+	}
+
+	if (!err.isOk())
+	{
+		logger->error().write("Failed to compile texture: {0}", strOutput.c_str());
+	}
+	else
+	{
+		logger->info().write("Successfully compiled texture: {0}", strOutput.c_str());
+	}
+}
+
+#define BGFX_CHUNK_MAGIC_VB  BX_MAKEFOURCC('V', 'B', ' ', 0x1)
+#define BGFX_CHUNK_MAGIC_IB  BX_MAKEFOURCC('I', 'B', ' ', 0x0)
+#define MESH_CHUNK_MAGIC_VB32 BX_MAKEFOURCC('V', 'B', ' ', 0x2)
+#define MESH_CHUNK_MAGIC_IB32 BX_MAKEFOURCC('I', 'B', ' ', 0x1)
+#define BGFX_CHUNK_MAGIC_PRI BX_MAKEFOURCC('P', 'R', 'I', 0x0)
+#define MESH_CHUNK_MAGIC_BOUNDS BX_MAKEFOURCC('B', 'N', 'D', 0x0)
+#define MESH_CHUNK_MAGIC_LOD BX_MAKEFOURCC('L', 'O', 'D', 0x0)
+
+namespace
+{
+	struct MeshVertex
+	{
+		float position[3] = {};
+		float normal[3] = {};
+		float texcoord[2] = {};
+		float tangent[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+	};
+
+	struct MeshSubset
+	{
+		std::string name;
+		std::vector<std::uint32_t> indices;
+	};
+
+	struct MeshGroup
+	{
+		std::string material;
+		std::vector<MeshVertex> vertices;
+		std::vector<MeshSubset> subsets;
+	};
+
+	/// The vertex and index buffer of a group
+	struct MeshPart
+	{
+		std::string material;
+		std::vector<MeshVertex> vertices;
+		/// Barycentric coordinate of every vertex for the wireframe shader
+		std::vector<std::uint8_t> corners;
+		std::vector<std::uint32_t> indices;
+		std::vector<Subset> subsets;
+	};
+
+	void normalize(float* v, std::size_t count)
+	{
+		float length = 0.0f;
+		for (std::size_t c = 0; c < count; ++c)
+			length += v[c] * v[c];
+		length = std::sqrt(length);
+		for (std::size_t c = 0; c < count && length > 0.0f; ++c)
+			v[c] /= length;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : readObj ()
+	/// <summary>
+	/// Reads the triangles of a wavefront obj file, one group per material
+	/// and one subset per object or group name. Faces are triangulated as
+	/// fans and corners with the same attributes share a vertex. Fails on
+	/// malformed or out of range face indices.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool readObj(const fs::path& path, std::vector<MeshGroup>& groups)
+	{
+		std::ifstream stream(path.string(), std::ios::in);
+		if (!stream)
+			return false;
+
+		std::vector<float> positions;
+		std::vector<float> texcoords;
+		std::vector<float> normals;
+		std::vector<std::map<std::array<int, 3>, std::uint32_t>> lookups;
+		// position of every vertex, for normals the file does not have
+		std::vector<std::vector<int>> vertexPositions;
+
+		std::size_t group = 0;
+		std::string subset;
+		auto currentSubset = [&]() -> MeshSubset&
+		{
+			if (groups.empty())
+			{
+				groups.emplace_back();
+				lookups.emplace_back();
+				vertexPositions.emplace_back();
+			}
+			auto& subsets = groups[group].subsets;
+			if (subsets.empty() || subsets.back().name != subset)
+			{
+				subsets.emplace_back();
+				subsets.back().name = subset;
+			}
+			return subsets.back();
+		};
+
+		auto resolve = [](int index, std::size_t count)
+		{
+			// obj indices start at 1, negative ones count back from the last element
+			return index < 0 ? int(count) + index : index - 1;
+		};
+
+		std::string line;
+		while (std::getline(stream, line))
+		{
+			std::istringstream tokens(line);
+			std::string type;
+			tokens >> type;
+			if (type == "v")
+			{
+				float x = 0.0f, y = 0.0f, z = 0.0f;
+				tokens >> x >> y >> z;
+				positions.insert(positions.end(), { x, y, z });
+			}
+			else if (type == "vt")
+			{
+				float u = 0.0f, v = 0.0f;
+				tokens >> u >> v;
+				texcoords.insert(texcoords.end(), { u, v });
+			}
+			else if (type == "vn")
+			{
+				float x = 0.0f, y = 0.0f, z = 0.0f;
+				tokens >> x >> y >> z;
+				normals.insert(normals.end(), { x, y, z });
+			}
+			else if (type == "g" || type == "o")
+			{
+				std::getline(tokens >> std::ws, subset);
+			}
+			else if (type == "usemtl")
+			{
+				std::string material;
+				std::getline(tokens >> std::ws, material);
+				auto it = std::find_if(groups.begin(), groups.end(), [&material](const MeshGroup& g) { return g.material == material; });
+				if (it == groups.end())
+				{
+					groups.emplace_back();
+					groups.back().material = material;
+					lookups.emplace_back();
+					vertexPositions.emplace_back();
+					it = groups.end() - 1;
+				}
+				group = std::size_t(it - groups.begin());
+			}
+			else if (type == "f")
+			{
+				auto& target = currentSubset();
+				auto& mesh = groups[group];
+				std::vector<std::uint32_t> corners;
+				std::string corner;
+				while (tokens >> corner)
+				{
+					std::array<int, 3> key = { -1, -1, -1 };
+					std::istringstream parts(corner);
+					std::string part;
+					for (std::size_t k = 0; k < 3 && std::getline(parts, part, '/'); ++k)
+					{
+						if (part.empty())
+							continue;
+
+						// a malformed index fails the compile, this runs on the watcher thread
+						char* end = nullptr;
+						const long long index = std::strtoll(part.c_str(), &end, 10);
+						if (end == part.c_str() || *end != '\0' ||
+							index < std::numeric_limits<int>::min() || index > std::numeric_limits<int>::max())
+							return false;
+
+						key[k] = resolve(int(index), k == 0 ? positions.size() / 3 : k == 1 ? texcoords.size() / 2 : normals.size() / 3);
+					}
+					if (key[0] < 0 || std::size_t(key[0]) >= positions.size() / 3)
+						return false;
+					if (std::size_t(key[1]) >= texcoords.size() / 2)
+						key[1] = -1;
+					if (std::size_t(key[2]) >= normals.size() / 3)
+						key[2] = -1;
+
+					auto inserted = lookups[group].emplace(key, std::uint32_t(mesh.vertices.size()));
+					if (inserted.second)
+					{
+						MeshVertex vertex;
+						std::copy_n(&positions[key[0] * 3], 3, vertex.position);
+						if (key[1] >= 0)
+							std::copy_n(&texcoords[key[1] * 2], 2, vertex.texcoord);
+						if (key[2] >= 0)
+							std::copy_n(&normals[key[2] * 3], 3, vertex.normal);
+						mesh.vertices.push_back(vertex);
+						vertexPositions[group].push_back(key[2] >= 0 ? -1 : key[0]);
+					}
+					corners.push_back(inserted.first->second);
+				}
+
+				for (std::size_t k = 2; k < corners.size(); ++k)
+					target.indices.insert(target.indices.end(), { corners[0], corners[k - 1], corners[k] });
+			}
+		}
+
+		for (std::size_t g = 0; g < groups.size(); ++g)
+		{
+			auto& mesh = groups[g];
+
+			// smooth normals around the positions of vertices without one
+			std::vector<float> smooth(positions.size(), 0.0f);
+			std::vector<float> tangents(mesh.vertices.size() * 3, 0.0f);
+			std::vector<float> bitangents(mesh.vertices.size() * 3, 0.0f);
+			for (const auto& subset : mesh.subsets)
+			{
+				for (std::size_t i = 0; i + 2 < subset.indices.size(); i += 3)
+				{
+					const auto& v0 = mesh.vertices[subset.indices[i]];
+					const auto& v1 = mesh.vertices[subset.indices[i + 1]];
+					const auto& v2 = mesh.vertices[subset.indices[i + 2]];
+					float e0[3], e1[3];
+					for (std::size_t c = 0; c < 3; ++c)
+					{
+						e0[c] = v1.position[c] - v0.position[c];
+						e1[c] = v2.position[c] - v0.position[c];
+					}
+					const float faceNormal[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+
+					const float du0 = v1.texcoord[0] - v0.texcoord[0];
+					const float dv0 = v1.texcoord[1] - v0.texcoord[1];
+					const float du1 = v2.texcoord[0] - v0.texcoord[0];
+					const float dv1 = v2.texcoord[1] - v0.texcoord[1];
+					const float det = du0 * dv1 - du1 * dv0;
+					const float r = std::abs(det) > 1e-12f ? 1.0f / det : 0.0f;
+
+					for (std::size_t k = 0; k < 3; ++k)
+					{
+						const auto v = subset.indices[i + k];
+						const int position = vertexPositions[g][v];
+						for (std::size_t c = 0; c < 3; ++c)
+						{
+							if (position >= 0)
+								smooth[position * 3 + c] += faceNormal[c];
+							tangents[v * 3 + c] += (e0[c] * dv1 - e1[c] * dv0) * r;
+							bitangents[v * 3 + c] += (e1[c] * du0 - e0[c] * du1) * r;
+						}
+					}
+				}
+			}
+
+			for (std::size_t v = 0; v < mesh.vertices.size(); ++v)
+			{
+				auto& vertex = mesh.vertices[v];
+				const int position = vertexPositions[g][v];
+				if (position >= 0)
+					std::copy_n(&smooth[position * 3], 3, vertex.normal);
+				normalize(vertex.normal, 3);
+
+				// gram-schmidt against the normal, the sign tells the bitangent direction
+				const float* n = vertex.normal;
+				float* t = &tangents[v * 3];
+				const float d = n[0] * t[0] + n[1] * t[1] + n[2] * t[2];
+				for (std::size_t c = 0; c < 3; ++c)
+					t[c] -= n[c] * d;
+				if (t[0] * t[0] + t[1] * t[1] + t[2] * t[2] < 1e-12f)
+				{
+					const float axis[3] = { std::abs(n[0]) < 0.9f ? 1.0f : 0.0f, std::abs(n[0]) < 0.9f ? 0.0f : 1.0f, 0.0f };
+					const float a = n[0] * axis[0] + n[1] * axis[1];
+					for (std::size_t c = 0; c < 3; ++c)
+						t[c] = axis[c] - n[c] * a;
+				}
+				normalize(t, 3);
+
+				const float* b = &bitangents[v * 3];
+				const float cross[3] = { n[1] * t[2] - n[2] * t[1], n[2] * t[0] - n[0] * t[2], n[0] * t[1] - n[1] * t[0] };
+				const float handedness = cross[0] * b[0] + cross[1] * b[1] + cross[2] * b[2] < 0.0f ? -1.0f : 1.0f;
+				vertex.tangent[0] = t[0];
+				vertex.tangent[1] = t[1];
+				vertex.tangent[2] = t[2];
+				vertex.tangent[3] = handedness;
+			}
+		}
+
+		groups.erase(std::remove_if(groups.begin(), groups.end(), [](const MeshGroup& g) { return g.vertices.empty(); }), groups.end());
+		return !groups.empty();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : buildPart ()
+	/// <summary>
+	/// Optimizes the subsets of a group for the vertex cache and builds the
+	/// part drawn for them. Every triangle corner gets its own barycentric
+	/// coordinate, vertices are duplicated where triangles disagree. Part
+	/// vertices are numbered in the order the triangles first use them, so
+	/// vertex fetches walk the buffer forward.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void buildPart(const MeshGroup& group, std::vector<std::vector<std::uint32_t>> subsetIndices, MeshPart& part)
+	{
+		const std::size_t vertexCount = group.vertices.size();
+		const std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+		part.material = group.material;
+
+		// part vertex of every vertex and barycentric corner
+		std::vector<std::uint32_t> remap(vertexCount * 3, none);
+
+		for (std::size_t s = 0; s < group.subsets.size(); ++s)
+		{
+			auto& indices = subsetIndices[s];
+			meshopt::optimizeVertexCache(indices, vertexCount);
+
+			Subset subset;
+			subset.name = group.subsets[s].name;
+			subset.m_startIndex = std::uint32_t(part.indices.size());
+
+			for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+			{
+				// the corner assignment that reuses the most existing vertices
+				static const std::uint8_t permutations[6][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 0, 2, 1 }, { 2, 1, 0 }, { 1, 0, 2 } };
+				std::size_t best = 0;
+				int bestReused = -1;
+				for (std::size_t p = 0; p < 6; ++p)
+				{
+					int reused = 0;
+					for (std::size_t k = 0; k < 3; ++k)
+						reused += remap[indices[i + k] * 3 + permutations[p][k]] != none;
+					if (reused > bestReused)
+					{
+						best = p;
+						bestReused = reused;
+					}
+				}
+
+				for (std::size_t k = 0; k < 3; ++k)
+				{
+					const std::uint32_t slot = indices[i + k] * 3 + permutations[best][k];
+					if (remap[slot] == none)
+					{
+						remap[slot] = std::uint32_t(part.vertices.size());
+						part.vertices.push_back(group.vertices[indices[i + k]]);
+						part.corners.push_back(permutations[best][k]);
+					}
+					part.indices.push_back(remap[slot]);
+				}
+			}
+
+			subset.m_numIndices = std::uint32_t(part.indices.size()) - subset.m_startIndex;
+			subset.m_startVertex = 0;
+			subset.m_numVertices = std::uint32_t(part.vertices.size());
+			part.subsets.push_back(subset);
+		}
+	}
+
+	bool writeMesh(const fs::path& path, const std::vector<MeshPart>& parts, const math::bbox& bounds, std::uint8_t lods)
+	{
+		gfx::VertexDecl decl;
+		decl.begin()
+			.add(gfx::Attrib::Position, 3, gfx::AttribType::Float)
+			.add(gfx::Attrib::Normal, 4, gfx::AttribType::Uint8, true, true)
+			.add(gfx::Attrib::Tangent, 4, gfx::AttribType::Uint8, true, true)
+			.add(gfx::Attrib::Color1, 4, gfx::AttribType::Uint8, true)
+			.add(gfx::Attrib::TexCoord0, 2, gfx::AttribType::Half)
+			.end();
+
+		bx::Error err;
+		bx::CrtFileWriter writer;
+		if (!writer.open(path.string().c_str(), false, &err))
+			return false;
+
+		// bounds first, so the reader does not have to scan the vertices
+		gfx::write(&writer, std::uint32_t(MESH_CHUNK_MAGIC_BOUNDS), &err);
+		gfx::write(&writer, &bounds.min, sizeof(float) * 3, &err);
+		gfx::write(&writer, &bounds.max, sizeof(float) * 3, &err);
+
+		if (lods > 0)
+		{
+			gfx::write(&writer, std::uint32_t(MESH_CHUNK_MAGIC_LOD), &err);
+			gfx::write(&writer, lods, &err);
+		}
+
+		std::vector<std::uint8_t> vertices;
+		for (const auto& part : parts)
+		{
+			vertices.assign(part.vertices.size() * decl.getStride(), 0);
+			for (std::size_t v = 0; v < part.vertices.size(); ++v)
+			{
+				const auto& vertex = part.vertices[v];
+				const float position[4] = { vertex.position[0], vertex.position[1], vertex.position[2], 1.0f };
+				const float normal[4] = { vertex.normal[0], vertex.normal[1], vertex.normal[2], 0.0f };
+				float corner[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				corner[part.corners[v]] = 1.0f;
+				const float texcoord[4] = { vertex.texcoord[0], vertex.texcoord[1], 0.0f, 0.0f };
+				gfx::vertexPack(position, false, gfx::Attrib::Position, decl, vertices.data(), std::uint32_t(v));
+				gfx::vertexPack(normal, true, gfx::Attrib::Normal, decl, vertices.data(), std::uint32_t(v));
+				gfx::vertexPack(vertex.tangent, true, gfx::Attrib::Tangent, decl, vertices.data(), std::uint32_t(v));
+				gfx::vertexPack(corner, true, gfx::Attrib::Color1, decl, vertices.data(), std::uint32_t(v));
+				gfx::vertexPack(texcoord, false, gfx::Attrib::TexCoord0, decl, vertices.data(), std::uint32_t(v));
+			}
+
+			// the 16 bit chunks bgfx tools write are kept for every part that fits them
+			const bool index32 = part.vertices.size() > std::numeric_limits<std::uint16_t>::max();
+			gfx::write(&writer, std::uint32_t(index32 ? MESH_CHUNK_MAGIC_VB32 : BGFX_CHUNK_MAGIC_VB), &err);
+			gfx::write(&writer, decl, &err);
+			if (index32)
+				gfx::write(&writer, std::uint32_t(part.vertices.size()), &err);
+			else
+				gfx::write(&writer, std::uint16_t(part.vertices.size()), &err);
+			gfx::write(&writer, vertices.data(), std::int32_t(vertices.size()), &err);
+
+			gfx::write(&writer, std::uint32_t(index32 ? MESH_CHUNK_MAGIC_IB32 : BGFX_CHUNK_MAGIC_IB), &err);
+			gfx::write(&writer, std::uint32_t(part.indices.size()), &err);
+			if (index32)
+			{
+				gfx::write(&writer, part.indices.data(), std::int32_t(part.indices.size() * sizeof(std::uint32_t)), &err);
 			}
 			else
 			{
-				logger->info().write("Successfully compiled shader: {0}", strOutput.c_str());
+				const std::vector<std::uint16_t> indices(part.indices.begin(), part.indices.end());
+				gfx::write(&writer, indices.data(), std::int32_t(indices.size() * sizeof(std::uint16_t)), &err);
+			}
+
+			gfx::write(&writer, std::uint32_t(BGFX_CHUNK_MAGIC_PRI), &err);
+			gfx::write(&writer, std::uint16_t(part.material.size()), &err);
+			gfx::write(&writer, part.material.data(), std::int32_t(part.material.size()), &err);
+			gfx::write(&writer, std::uint16_t(part.subsets.size()), &err);
+			for (const auto& subset : part.subsets)
+			{
+				gfx::write(&writer, std::uint16_t(subset.name.size()), &err);
+				gfx::write(&writer, subset.name.data(), std::int32_t(subset.name.size()), &err);
+				gfx::write(&writer, subset.m_startIndex, &err);
+				gfx::write(&writer, subset.m_numIndices, &err);
+				gfx::write(&writer, subset.m_startVertex, &err);
+				gfx::write(&writer, subset.m_numVertices, &err);
 			}
 		}
-		
+
+		writer.close();
+		return err.isOk();
+	}
+}
+
+void MeshCompiler::compile(const fs::path& absoluteKey)
+{
+	fs::path input = absoluteKey;
+	std::string strInput = input.string();
+	std::string file = input.filename().replace_extension().string();
+	fs::path dir = input.remove_filename();
+
+	static const std::string ext = ".asset";
+
+	fs::path output = dir / "runtime";
+	fs::create_directory(output, std::error_code{});
+
+	auto logger = logging::get("Log");
+
+	std::vector<MeshGroup> groups;
+	if (!readObj(absoluteKey, groups))
+	{
+		logger->error().write("Failed to compile mesh: {0}", strInput.c_str());
+		return;
+	}
+
+	math::bbox bounds;
+	bounds.reset();
+	std::vector<std::vector<float>> positions(groups.size());
+	std::size_t triangles = 0;
+	for (std::size_t g = 0; g < groups.size(); ++g)
+	{
+		for (const auto& vertex : groups[g].vertices)
+		{
+			bounds.addPoint(math::vec3(vertex.position[0], vertex.position[1], vertex.position[2]));
+			positions[g].insert(positions[g].end(), vertex.position, vertex.position + 3);
+		}
+		for (const auto& subset : groups[g].subsets)
+			triangles += subset.indices.size() / 3;
+	}
+
+	// every lod simplifies the subsets of the original mesh, until one no longer gets smaller
+	std::vector<std::vector<MeshPart>> lods;
+	std::size_t previous = triangles;
+	for (std::uint32_t lod = 0; lod <= lodCount; ++lod)
+	{
+		const float ratio = std::pow(lodRatio, float(lod));
+		std::vector<MeshPart> parts;
+		std::size_t count = 0;
+		for (std::size_t g = 0; g < groups.size(); ++g)
+		{
+			std::vector<std::vector<std::uint32_t>> subsetIndices;
+			for (const auto& subset : groups[g].subsets)
+			{
+				const auto target = std::size_t(float(subset.indices.size() / 3) * ratio);
+				subsetIndices.push_back(lod == 0 ? subset.indices : meshopt::simplify(positions[g], subset.indices, target));
+				count += subsetIndices.back().size() / 3;
+			}
+			MeshPart part;
+			buildPart(groups[g], std::move(subsetIndices), part);
+			if (!part.indices.empty())
+				parts.push_back(std::move(part));
+		}
+
+		if (lod > 0 && (count == 0 || float(count) > float(previous) * 0.8f))
+			break;
+
+		lods.push_back(std::move(parts));
+		previous = count;
+	}
+
+	for (std::size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		const std::string name = lod == 0 ? file : file + "_lod" + std::to_string(lod);
+		const fs::path path = output / fs::path(name + ext);
+		const std::string strOutput = path.string();
+		const auto extraLods = lod == 0 ? std::uint8_t(lods.size() - 1) : std::uint8_t(0);
+		if (!writeMesh(path, lods[lod], bounds, extraLods))
+		{
+			logger->error().write("Failed to compile mesh: {0}", strOutput.c_str());
+			return;
+		}
+		logger->info().write("Successfully compiled mesh: {0}", strOutput.c_str());
 	}
-	
 }
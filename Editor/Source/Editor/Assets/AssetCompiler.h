@@ -1,7 +1,43 @@
 #pragma once
 #include "Runtime/System/FileSystem.h"
+#include <cstdint>
 
 struct ShaderCompiler
 {
+	/// Compiles the shader for every platform whose output is out of date,
+	/// or for all of them when forced. The platforms are built in parallel.
+	void compile(const fs::path& absoluteKey, bool force = false);
+
+	/// Whether the last build of the shader, for any platform, included the
+	/// file. Read from the depends files shaderc writes next to the outputs.
+	static bool dependsOn(const fs::path& absoluteKey, const fs::path& include);
+};
+
+struct TextureCompiler
+{
+	enum class Format
+	{
+		/// BC5 for normal maps, BC3 with alpha and BC1 otherwise
+		Auto,
+		BC1,
+		BC3,
+		BC5,
+		BC7,
+		RGBA8,
+	};
+
 	void compile(const fs::path& absoluteKey);
-};
\ No newline at end of file
+
+	/// Format of the cooked texture
+	Format format = Format::Auto;
+};
+
+struct MeshCompiler
+{
+	void compile(const fs::path& absoluteKey);
+
+	/// Simplified lods cooked next to the mesh as <name>_lod<n>
+	std::uint32_t lodCount = 3;
+	/// Triangles of every lod relative to the one before
+	float lodRatio = 0.5f;
+};
@@ -0,0 +1,329 @@
+#include "BlockEncoder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+namespace bc
+{
+namespace
+{
+	typedef float Pixels[16][4];
+
+	void load(const std::uint8_t* rgba, Pixels& pixels)
+	{
+		for (int i = 0; i < 16; ++i)
+			for (int c = 0; c < 4; ++c)
+				pixels[i][c] = static_cast<float>(rgba[i * 4 + c]);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : fitLine ()
+	/// <summary>
+	/// Fits a line through the first N channels of the pixels along their
+	/// principal axis and returns the two ends of the pixels projected on it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<int N>
+	void fitLine(const Pixels& pixels, float (&low)[4], float (&high)[4])
+	{
+		float mean[N] = {};
+		for (int i = 0; i < 16; ++i)
+			for (int c = 0; c < N; ++c)
+				mean[c] += pixels[i][c] / 16.0f;
+
+		float covariance[N][N] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int a = 0; a < N; ++a)
+				for (int b = 0; b < N; ++b)
+					covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+		}
+
+		// power iteration converges to the axis of the largest spread
+		float axis[N];
+		std::fill(axis, axis + N, 1.0f);
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[N] = {};
+			float largest = 0.0f;
+			for (int a = 0; a < N; ++a)
+			{
+				for (int b = 0; b < N; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				largest = std::max(largest, std::abs(next[a]));
+			}
+			if (largest == 0.0f)
+				break;
+			for (int a = 0; a < N; ++a)
+				axis[a] = next[a] / largest;
+		}
+
+		float length = 0.0f;
+		for (int a = 0; a < N; ++a)
+			length += axis[a] * axis[a];
+		length = std::sqrt(length);
+		for (int a = 0; a < N; ++a)
+			axis[a] = length > 0.0f ? axis[a] / length : 0.0f;
+
+		float tmin = 0.0f;
+		float tmax = 0.0f;
+		for (int i = 0; i < 16; ++i)
+		{
+			float t = 0.0f;
+			for (int c = 0; c < N; ++c)
+				t += (pixels[i][c] - mean[c]) * axis[c];
+			tmin = std::min(tmin, t);
+			tmax = std::max(tmax, t);
+		}
+
+		for (int c = 0; c < 4; ++c)
+		{
+			low[c] = c < N ? std::min(std::max(mean[c] + axis[c] * tmin, 0.0f), 255.0f) : 255.0f;
+			high[c] = c < N ? std::min(std::max(mean[c] + axis[c] * tmax, 0.0f), 255.0f) : 255.0f;
+		}
+	}
+
+	template<int N>
+	int distance(const float* a, const int* b)
+	{
+		float result = 0.0f;
+		for (int c = 0; c < N; ++c)
+			result += (a[c] - b[c]) * (a[c] - b[c]);
+		return static_cast<int>(result);
+	}
+
+	std::uint16_t pack565(const float* color)
+	{
+		const int r = std::min(std::max(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0), 31);
+		const int g = std::min(std::max(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0), 63);
+		const int b = std::min(std::max(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0), 31);
+		return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void unpack565(std::uint16_t value, int* color)
+	{
+		const int r = (value >> 11) & 31;
+		const int g = (value >> 5) & 63;
+		const int b = value & 31;
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : encodeColor ()
+	/// <summary>
+	/// BC1 color block in four color mode, shared by BC1 and BC3.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void encodeColor(const std::uint8_t* rgba, std::uint8_t* block)
+	{
+		Pixels pixels;
+		load(rgba, pixels);
+
+		float low[4];
+		float high[4];
+		fitLine<3>(pixels, low, high);
+
+		std::uint16_t color0 = pack565(high);
+		std::uint16_t color1 = pack565(low);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		int palette[4][3];
+		unpack565(color0, palette[0]);
+		unpack565(color1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		std::uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				int best = 0;
+				int bestDistance = distance<3>(pixels[i], palette[0]);
+				for (int p = 1; p < 4; ++p)
+				{
+					const int d = distance<3>(pixels[i], palette[p]);
+					if (d < bestDistance)
+					{
+						best = p;
+						bestDistance = d;
+					}
+				}
+				indices |= static_cast<std::uint32_t>(best) << (2 * i);
+			}
+		}
+
+		block[0] = color0 & 0xff;
+		block[1] = color0 >> 8;
+		block[2] = color1 & 0xff;
+		block[3] = color1 >> 8;
+		for (int b = 0; b < 4; ++b)
+			block[4 + b] = (indices >> (8 * b)) & 0xff;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : encodeChannel ()
+	/// <summary>
+	/// BC4 block of a single channel in eight value mode, shared by BC3, BC4
+	/// and BC5.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void encodeChannel(const std::uint8_t* rgba, int channel, std::uint8_t* block)
+	{
+		int low = 255;
+		int high = 0;
+		for (int i = 0; i < 16; ++i)
+		{
+			low = std::min(low, static_cast<int>(rgba[i * 4 + channel]));
+			high = std::max(high, static_cast<int>(rgba[i * 4 + channel]));
+		}
+
+		block[0] = static_cast<std::uint8_t>(high);
+		block[1] = static_cast<std::uint8_t>(low);
+
+		std::uint64_t indices = 0;
+		if (high > low)
+		{
+			const int range = high - low;
+			for (int i = 0; i < 16; ++i)
+			{
+				// step 0 is the low end, step 7 the high end
+				const int step = ((rgba[i * 4 + channel] - low) * 14 + range) / (2 * range);
+				const int index = step == 7 ? 0 : step == 0 ? 1 : 8 - step;
+				indices |= static_cast<std::uint64_t>(index) << (3 * i);
+			}
+		}
+
+		for (int b = 0; b < 6; ++b)
+			block[2 + b] = (indices >> (8 * b)) & 0xff;
+	}
+
+	struct BitWriter
+	{
+		void write(std::uint32_t value, std::uint32_t bits)
+		{
+			for (std::uint32_t b = 0; b < bits; ++b, ++offset)
+			{
+				if ((value >> b) & 1)
+					data[offset >> 3] |= 1 << (offset & 7);
+			}
+		}
+
+		std::uint8_t* data;
+		std::uint32_t offset;
+	};
+}
+
+void encodeBC1(const std::uint8_t* rgba, std::uint8_t* block)
+{
+	encodeColor(rgba, block);
+}
+
+void encodeBC3(const std::uint8_t* rgba, std::uint8_t* block)
+{
+	encodeChannel(rgba, 3, block);
+	encodeColor(rgba, block + 8);
+}
+
+void encodeBC4(const std::uint8_t* rgba, std::uint8_t* block)
+{
+	encodeChannel(rgba, 0, block);
+}
+
+void encodeBC5(const std::uint8_t* rgba, std::uint8_t* block)
+{
+	encodeChannel(rgba, 0, block);
+	encodeChannel(rgba, 1, block + 8);
+}
+
+void encodeBC7(const std::uint8_t* rgba, std::uint8_t* block)
+{
+	static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	Pixels pixels;
+	load(rgba, pixels);
+
+	float ends[2][4];
+	fitLine<4>(pixels, ends[0], ends[1]);
+
+	// 7 bit endpoints, each with its own shared lowest bit
+	int endpoints[2][4];
+	int pbits[2];
+	for (int e = 0; e < 2; ++e)
+	{
+		float bestError = -1.0f;
+		for (int pbit = 0; pbit < 2; ++pbit)
+		{
+			int quantized[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c)
+			{
+				quantized[c] = std::min(std::max(static_cast<int>(std::floor((ends[e][c] - pbit) / 2.0f + 0.5f)), 0), 127);
+				const float value = static_cast<float>((quantized[c] << 1) | pbit);
+				error += (value - ends[e][c]) * (value - ends[e][c]);
+			}
+			if (bestError < 0.0f || error < bestError)
+			{
+				bestError = error;
+				pbits[e] = pbit;
+				std::copy(quantized, quantized + 4, endpoints[e]);
+			}
+		}
+	}
+
+	int palette[16][4];
+	for (int c = 0; c < 4; ++c)
+	{
+		const int value0 = (endpoints[0][c] << 1) | pbits[0];
+		const int value1 = (endpoints[1][c] << 1) | pbits[1];
+		for (int i = 0; i < 16; ++i)
+			palette[i][c] = ((64 - weights[i]) * value0 + weights[i] * value1 + 32) >> 6;
+	}
+
+	int indices[16];
+	for (int i = 0; i < 16; ++i)
+	{
+		indices[i] = 0;
+		int bestDistance = distance<4>(pixels[i], palette[0]);
+		for (int p = 1; p < 16; ++p)
+		{
+			const int d = distance<4>(pixels[i], palette[p]);
+			if (d < bestDistance)
+			{
+				indices[i] = p;
+				bestDistance = d;
+			}
+		}
+	}
+
+	// the highest bit of the first index is implied to be zero
+	if (indices[0] & 8)
+	{
+		std::swap(endpoints[0], endpoints[1]);
+		std::swap(pbits[0], pbits[1]);
+		for (int i = 0; i < 16; ++i)
+			indices[i] = 15 - indices[i];
+	}
+
+	std::memset(block, 0, 16);
+	BitWriter writer = { block, 0 };
+	writer.write(1 << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writer.write(endpoints[0][c], 7);
+		writer.write(endpoints[1][c], 7);
+	}
+	writer.write(pbits[0], 1);
+	writer.write(pbits[1], 1);
+	writer.write(indices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		writer.write(indices[i], 4);
+}
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+// Block compression encoders. Every function encodes one 4x4 block given as
+// 16 rgba8 pixels, row by row, into the block layout the gpu expects.
+//-----------------------------------------------------------------------------
+namespace bc
+{
+	/// Opaque color, 8 bytes per block
+	void encodeBC1(const std::uint8_t* rgba, std::uint8_t* block);
+
+	/// Color with smooth alpha, 16 bytes per block
+	void encodeBC3(const std::uint8_t* rgba, std::uint8_t* block);
+
+	/// The red channel only, 8 bytes per block
+	void encodeBC4(const std::uint8_t* rgba, std::uint8_t* block);
+
+	/// The red and green channels, used for tangent space normals. 16 bytes per block
+	void encodeBC5(const std::uint8_t* rgba, std::uint8_t* block);
+
+	/// Color with alpha in higher quality than BC3, 16 bytes per block.
+	/// Only mode 6 is used, a single subset with 4 bit indices.
+	void encodeBC7(const std::uint8_t* rgba, std::uint8_t* block);
+}
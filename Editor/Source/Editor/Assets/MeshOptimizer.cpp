@@ -0,0 +1,314 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+namespace meshopt
+{
+namespace
+{
+	const std::uint32_t CacheSize = 32;
+
+	float vertexScore(int cachePosition, std::uint32_t liveTriangles)
+	{
+		if (liveTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			// the vertices of the last triangle get a fixed score so it is not emitted twice in a row
+			if (cachePosition < 3)
+				score = 0.75f;
+			else
+				score = std::pow(1.0f - float(cachePosition - 3) / float(CacheSize - 3), 1.5f);
+		}
+
+		// vertices with few triangles left are finished first
+		return score + 2.0f / std::sqrt(float(liveTriangles));
+	}
+
+	struct Quadric
+	{
+		void add(const double* plane, double weight)
+		{
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < 4; ++i)
+				for (std::size_t j = i; j < 4; ++j)
+					values[k++] += plane[i] * plane[j] * weight;
+		}
+
+		double error(const float* p) const
+		{
+			const double v[4] = { p[0], p[1], p[2], 1.0 };
+			double result = 0.0;
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < 4; ++i)
+				for (std::size_t j = i; j < 4; ++j)
+					result += values[k++] * v[i] * v[j] * (i == j ? 1.0 : 2.0);
+			return result;
+		}
+
+		/// Upper triangle of the symmetric 4x4 matrix
+		double values[10] = {};
+	};
+}
+
+void optimizeVertexCache(std::vector<std::uint32_t>& indices, std::size_t vertexCount)
+{
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// triangles using every vertex, the live ones are kept at the front
+	std::vector<std::uint32_t> offsets(vertexCount + 1, 0);
+	for (std::size_t i = 0; i < triangleCount * 3; ++i)
+		offsets[indices[i] + 1]++;
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<std::uint32_t> live(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		live[v] = offsets[v + 1] - offsets[v];
+
+	std::vector<std::uint32_t> adjacency(triangleCount * 3);
+	std::vector<std::uint32_t> fill(offsets.begin(), offsets.end() - 1);
+	for (std::size_t t = 0; t < triangleCount; ++t)
+		for (std::size_t k = 0; k < 3; ++k)
+			adjacency[fill[indices[t * 3 + k]]++] = std::uint32_t(t);
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; ++v)
+		vertexScores[v] = vertexScore(-1, live[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	for (std::size_t t = 0; t < triangleCount; ++t)
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+	auto updateScore = [&](std::uint32_t v, int cachePosition)
+	{
+		const float score = vertexScore(cachePosition, live[v]);
+		const float delta = score - vertexScores[v];
+		vertexScores[v] = score;
+		cachePositions[v] = cachePosition;
+		for (std::uint32_t i = offsets[v]; i < offsets[v] + live[v]; ++i)
+			triangleScores[adjacency[i]] += delta;
+	};
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<std::uint32_t> result;
+	result.reserve(triangleCount * 3);
+
+	std::uint32_t cache[CacheSize + 3];
+	std::size_t cacheCount = 0;
+	std::size_t cursor = 0;
+	std::size_t best = triangleCount;
+
+	while (result.size() < triangleCount * 3)
+	{
+		if (best == triangleCount)
+		{
+			// nothing in the cache has triangles left, continue with the next one in the input
+			while (emitted[cursor])
+				++cursor;
+			best = cursor;
+		}
+
+		const std::size_t t = best;
+		emitted[t] = true;
+
+		std::uint32_t next[CacheSize + 3];
+		std::size_t nextCount = 0;
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			const std::uint32_t v = indices[t * 3 + k];
+			result.push_back(v);
+
+			auto begin = adjacency.begin() + offsets[v];
+			auto end = begin + live[v];
+			auto it = std::find(begin, end, std::uint32_t(t));
+			if (it != end)
+			{
+				*it = *(end - 1);
+				live[v]--;
+			}
+
+			if (std::find(next, next + nextCount, v) == next + nextCount)
+				next[nextCount++] = v;
+		}
+		const std::size_t triangleVertices = nextCount;
+		for (std::size_t i = 0; i < cacheCount; ++i)
+		{
+			if (std::find(next, next + triangleVertices, cache[i]) == next + triangleVertices)
+				next[nextCount++] = cache[i];
+		}
+
+		// vertices pushed out of the cache lose their cache score
+		for (std::size_t i = CacheSize; i < nextCount; ++i)
+			updateScore(next[i], -1);
+
+		cacheCount = std::min<std::size_t>(nextCount, CacheSize);
+		std::copy(next, next + cacheCount, cache);
+		for (std::size_t i = 0; i < cacheCount; ++i)
+			updateScore(cache[i], int(i));
+
+		best = triangleCount;
+		float bestScore = -std::numeric_limits<float>::max();
+		for (std::size_t i = 0; i < cacheCount; ++i)
+		{
+			const std::uint32_t v = cache[i];
+			for (std::uint32_t a = offsets[v]; a < offsets[v] + live[v]; ++a)
+			{
+				if (triangleScores[adjacency[a]] > bestScore)
+				{
+					best = adjacency[a];
+					bestScore = triangleScores[best];
+				}
+			}
+		}
+	}
+
+	indices.swap(result);
+}
+
+std::vector<std::uint32_t> simplify(const std::vector<float>& positions, const std::vector<std::uint32_t>& indices, std::size_t targetTriangles)
+{
+	const std::size_t vertexCount = positions.size() / 3;
+	if (indices.size() / 3 <= targetTriangles)
+		return indices;
+
+	std::vector<bool> used(vertexCount, false);
+	float lower[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+	float upper[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max() };
+	for (auto index : indices)
+	{
+		used[index] = true;
+		for (std::size_t c = 0; c < 3; ++c)
+		{
+			lower[c] = std::min(lower[c], positions[index * 3 + c]);
+			upper[c] = std::max(upper[c], positions[index * 3 + c]);
+		}
+	}
+
+	const float extent = std::max(upper[0] - lower[0], std::max(upper[1] - lower[1], upper[2] - lower[2]));
+	if (!(extent > 0.0f))
+		return indices;
+
+	std::vector<std::uint32_t> clusters(vertexCount, 0);
+	auto clusterize = [&](std::uint32_t resolution)
+	{
+		std::unordered_map<std::uint64_t, std::uint32_t> cells;
+		const float scale = float(resolution) / extent;
+		for (std::size_t v = 0; v < vertexCount; ++v)
+		{
+			if (!used[v])
+				continue;
+
+			std::uint64_t key = 0;
+			for (std::size_t c = 0; c < 3; ++c)
+			{
+				const auto cell = std::min(std::uint32_t((positions[v * 3 + c] - lower[c]) * scale), resolution - 1);
+				key = key * resolution + cell;
+			}
+			clusters[v] = cells.emplace(key, std::uint32_t(cells.size())).first->second;
+		}
+		return cells.size();
+	};
+
+	auto countTriangles = [&]()
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < indices.size(); i += 3)
+		{
+			const auto a = clusters[indices[i]];
+			const auto b = clusters[indices[i + 1]];
+			const auto c = clusters[indices[i + 2]];
+			if (a != b && b != c && a != c)
+				count++;
+		}
+		return count;
+	};
+
+	// the finest grid that gets under the target
+	std::uint32_t low = 1;
+	std::uint32_t high = 1024;
+	std::uint32_t resolution = 1;
+	while (low <= high)
+	{
+		const std::uint32_t middle = (low + high) / 2;
+		clusterize(middle);
+		if (countTriangles() <= targetTriangles)
+		{
+			resolution = middle;
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+	const auto clusterCount = clusterize(resolution);
+
+	// plane quadrics of the triangles around every cluster, weighted by area
+	std::vector<Quadric> quadrics(clusterCount);
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		const float* p0 = &positions[indices[i] * 3];
+		const float* p1 = &positions[indices[i + 1] * 3];
+		const float* p2 = &positions[indices[i + 2] * 3];
+		const double e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		const double e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		double plane[4] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0], 0.0 };
+		const double area = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (area <= 0.0)
+			continue;
+
+		for (std::size_t c = 0; c < 3; ++c)
+			plane[c] /= area;
+		plane[3] = -(plane[0] * p0[0] + plane[1] * p0[1] + plane[2] * p0[2]);
+
+		for (std::size_t k = 0; k < 3; ++k)
+			quadrics[clusters[indices[i + k]]].add(plane, area);
+	}
+
+	std::vector<std::uint32_t> representatives(clusterCount, 0);
+	std::vector<double> errors(clusterCount, std::numeric_limits<double>::max());
+	for (std::size_t v = 0; v < vertexCount; ++v)
+	{
+		if (!used[v])
+			continue;
+
+		const auto cluster = clusters[v];
+		const double error = quadrics[cluster].error(&positions[v * 3]);
+		if (error < errors[cluster])
+		{
+			errors[cluster] = error;
+			representatives[cluster] = std::uint32_t(v);
+		}
+	}
+
+	std::vector<std::uint32_t> result;
+	std::set<std::array<std::uint32_t, 3>> triangles;
+	for (std::size_t i = 0; i < indices.size(); i += 3)
+	{
+		std::array<std::uint32_t, 3> triangle =
+		{
+			representatives[clusters[indices[i]]],
+			representatives[clusters[indices[i + 1]]],
+			representatives[clusters[indices[i + 2]]],
+		};
+		if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[0] == triangle[2])
+			continue;
+
+		// the same triangle can be produced many times, rotated but with the same winding
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		if (triangles.insert(triangle).second)
+			result.insert(result.end(), triangle.begin(), triangle.end());
+	}
+	return result;
+}
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Optimization passes of the mesh cooker. Indices are triangle lists and
+// positions are packed as x, y, z floats per vertex.
+//-----------------------------------------------------------------------------
+namespace meshopt
+{
+	/// Reorders the triangles so that consecutive triangles reuse vertices
+	/// still in the post transform cache (Forsyth's linear speed algorithm).
+	void optimizeVertexCache(std::vector<std::uint32_t>& indices, std::size_t vertexCount);
+
+	/// Reduces the triangles to at most targetTriangles by clustering the
+	/// referenced vertices on a grid. Every cluster collapses onto its vertex
+	/// with the smallest quadric error, so the result only references
+	/// existing vertices and keeps their attributes.
+	std::vector<std::uint32_t> simplify(const std::vector<float>& positions, const std::vector<std::uint32_t>& indices, std::size_t targetTriangles);
+}
@@ -6,6 +6,8 @@
 #include "Runtime/System/MessageBox.h"
 #include "Runtime/System/FileSystem.h"
 #include "Runtime/Assets/AssetManager.h"
+#include "Runtime/Assets/TextureStreamer.h"
+#include "Runtime/Rendering/ShaderCache.h"
 #include "Runtime/System/Watchdog.h"
 #include "Runtime/Rendering/Material.h"
 #include "Runtime/Rendering/Texture.h"
@@ -13,6 +15,7 @@
 #include "Runtime/Rendering/Shader.h"
 #include "Runtime/Threading/ThreadPool.h"
 #include "Runtime/Ecs/Prefab.h"
+#include "Runtime/Ecs/Systems/RenderingSystem.h"
 #include "Console/ConsoleLog.h"
 #include "Assets/AssetCompiler.h"
 template<typename T>
@@ -63,6 +66,52 @@ void watchAssets(const fs::path& protocol, bool reloadAsync)
 	});
 }
 
+void compileShadersIncluding(const fs::path& dir, const fs::path& include)
+{
+	auto& pool = Singleton<Application>::getInstance().getThreadPool();
+
+	fs::directory_iterator end;
+	for (fs::directory_iterator it(dir, std::error_code{}); it != end; ++it)
+	{
+		const auto shader = it->path();
+		if (shader.extension() != ".sc" || string_utils::endsWith(shader.string(), "def.sc"))
+			continue;
+
+		if (!ShaderCompiler::dependsOn(shader, include))
+			continue;
+
+		pool.enqueue_with_callback([shader]()
+		{
+			ShaderCompiler compiler;
+			compiler.compile(shader);
+		}, []() {});
+	}
+}
+
+void watchShaderIncludes(const fs::path& protocol, const std::vector<fs::path>& shaderProtocols)
+{
+	const fs::path dir = fs::resolve_protocol(protocol);
+	static const std::string ext = "*.sh";
+	const fs::path watchDir = dir / ext;
+
+	std::vector<fs::path> shaderDirs;
+	for (const auto& shaderProtocol : shaderProtocols)
+		shaderDirs.push_back(fs::resolve_protocol(shaderProtocol));
+
+	wd::watch(watchDir, false, [shaderDirs](const std::vector<wd::Entry>& entries)
+	{
+		for (auto& entry : entries)
+		{
+			if (entry.state == wd::Entry::Removed)
+				continue;
+
+			// only the shaders whose last build read the header are rebuilt
+			for (const auto& shaderDir : shaderDirs)
+				compileShadersIncluding(shaderDir, entry.path);
+		}
+	});
+}
+
 void watchRawShaders(const fs::path& protocol, bool reloadAsync)
 {
 	auto& app = Singleton<Application>::getInstance();
@@ -71,15 +120,38 @@ void watchRawShaders(const fs::path& protocol, bool reloadAsync)
 	static const std::string ext = "*.sc";
 	const fs::path watchDir = dir / ext;
 
+	// headers next to the shaders, eg. shaderlib.sh
+	watchShaderIncludes(protocol, { protocol });
+
 	wd::watch(watchDir, false, [&app, reloadAsync](const std::vector<wd::Entry>& entries)
 	{
 		for (auto& entry : entries)
 		{
 			const auto& p = entry.path;
-			if(string_utils::endsWith(p.string(), "def.sc"))
-				continue;
-
 			auto& pool = app.getThreadPool();
+
+			if (string_utils::endsWith(p.string(), "def.sc"))
+			{
+				// every shader of the directory uses the varyings, the ones
+				// that are still up to date are skipped by the compiler
+				if (entry.state == wd::Entry::Removed)
+					continue;
+
+				fs::directory_iterator end;
+				for (fs::directory_iterator it(p.parent_path(), std::error_code{}); it != end; ++it)
+				{
+					const auto shader = it->path();
+					if (shader.extension() != ".sc" || string_utils::endsWith(shader.string(), "def.sc"))
+						continue;
+
+					pool.enqueue_with_callback([shader]()
+					{
+						ShaderCompiler compiler;
+						compiler.compile(shader);
+					}, []() {});
+				}
+				continue;
+			}
 	
 			if (entry.state == wd::Entry::Removed)
 			{
@@ -104,6 +176,47 @@ void watchRawShaders(const fs::path& protocol, bool reloadAsync)
 }
 
 
+template<typename Compiler>
+void watchRawAssets(const fs::path& protocol, const std::vector<std::string>& extensions)
+{
+	auto& app = Singleton<Application>::getInstance();
+
+	const fs::path dir = fs::resolve_protocol(protocol);
+	const fs::path watchDir = dir / "*";
+
+	wd::watch(watchDir, false, [&app, extensions](const std::vector<wd::Entry>& entries)
+	{
+		for (auto& entry : entries)
+		{
+			const auto& p = entry.path;
+			const auto ext = string_utils::toLower(p.extension().string());
+			if (std::find(std::begin(extensions), std::end(extensions), ext) == std::end(extensions))
+				continue;
+
+			auto& pool = app.getThreadPool();
+
+			if (entry.state == wd::Entry::Removed)
+			{
+				//removed
+			}
+			else
+			{
+				//created or modified
+				if (fs::is_regular_file(p, std::error_code{}))
+				{
+					auto callback = []() {};
+					pool.enqueue_with_callback([p]()
+					{
+						Compiler compiler;
+						compiler.compile(p);
+					}, callback);
+
+				}
+			}
+		}
+	});
+}
+
 
 bool EditorApp::initUI()
 {
@@ -255,6 +368,87 @@ bool EditorApp::initApplication()
 		logVersion
 	);
 
+	std::function<void()> logAssets = [this, logger]()
+	{
+		auto& manager = getAssetManager();
+		auto toMegabytes = [](std::uint64_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+		for (const auto& residency : manager.getResidency())
+		{
+			logger->info().write("{0}: {1} loaded, {2} referenced, cpu {3:.2f} MB, gpu {4:.2f} MB, budget {5:.2f} MB",
+				residency.name, residency.count, residency.referenced,
+				toMegabytes(residency.cpuBytes), toMegabytes(residency.gpuBytes), toMegabytes(residency.budget));
+		}
+		logger->info().write("Total budget {0:.2f} MB", toMegabytes(manager.getBudget()));
+
+		const auto& mips = getTextureStreamer().getStats();
+		logger->info().write("Streamed textures: {0} ({1} at their tail, {2} loading), resident {3:.2f} MB of {4:.2f} MB, {5} mip loads, {6} mip drops",
+			mips.textures, mips.tails, mips.loading, toMegabytes(mips.residentBytes), toMegabytes(mips.fullBytes), mips.upgrades, mips.downgrades);
+
+		const auto shaders = getShaderCache().getStats();
+		logger->info().write("Shader cache: {0} programs, {1:.2f} MB, {2} hits, {3} misses, {4} writes, {5} evictions",
+			shaders.entries, toMegabytes(shaders.bytes), shaders.hits, shaders.misses, shaders.writes, shaders.evictions);
+	};
+	mConsoleLog->registerCommand(
+		"assets",
+		"Prints the loaded assets and their memory per storage.",
+		{ },
+		{ },
+		logAssets
+	);
+
+	std::function<void(std::string, float)> setAssetBudget = [this, logger](std::string storage, float megabytes)
+	{
+		auto& manager = getAssetManager();
+		const auto bytes = static_cast<std::uint64_t>(std::max(megabytes, 0.0f) * 1024.0f * 1024.0f);
+		if (storage == "all")
+			manager.setBudget(bytes);
+		else if (!manager.setBudget(storage, bytes))
+			logger->error().write("Unknown asset storage {0}", storage);
+	};
+	mConsoleLog->registerCommand(
+		"asset_budget",
+		"Sets the memory budget in MB of an asset storage or of all storages together. 0 means unlimited.",
+		{ "storage", "megabytes" },
+		{ },
+		setAssetBudget
+	);
+
+	std::function<void(int)> setOcclusion = [this, logger](int enabled)
+	{
+		auto rendering = getWorld().systems.system<RenderingSystem>();
+		if (!rendering)
+			return;
+
+		rendering->setOcclusionCulling(enabled != 0);
+		logger->info().write("Occlusion culling {0}", enabled != 0 ? "enabled" : "disabled");
+	};
+	mConsoleLog->registerCommand(
+		"occlusion",
+		"Enables (1) or disables (0) the cpu occlusion culling of models behind occluder models.",
+		{ "enabled" },
+		{ },
+		setOcclusion
+	);
+
+	std::function<void()> logOcclusion = [this, logger]()
+	{
+		auto rendering = getWorld().systems.system<RenderingSystem>();
+		if (!rendering)
+			return;
+
+		const auto& stats = rendering->getOcclusionStats();
+		logger->info().write("Occlusion culling {0}: {1} occluders, {2} triangles, {3} tested, {4} culled",
+			rendering->getOcclusionCulling() ? "enabled" : "disabled",
+			stats.occluders, stats.triangles, stats.tested, stats.culled);
+	};
+	mConsoleLog->registerCommand(
+		"occlusion_stats",
+		"Prints the occluder, tested and culled counts of the last frame.",
+		{ },
+		{ },
+		logOcclusion
+	);
+
 	if (!initUI()) { shutDown(); return false; }
 
 	if (!initDocks()) { shutDown(); return false; }
@@ -310,8 +504,10 @@ void EditorApp::openProject(const fs::path& projectPath)
 	fs::add_path_protocol("data:", fs::resolve_protocol("app://data"));
 	wd::unwatchAll();
 	watchAssets<Texture>("data://textures", true);
+	watchRawAssets<TextureCompiler>("data://textures", { ".png", ".tga", ".jpg", ".jpeg", ".bmp" });
 	watchAssets<Texture>("editor_data://icons", true);
 	watchAssets<Mesh>("data://meshes", true);
+	watchRawAssets<MeshCompiler>("data://meshes", { ".obj" });
 	watchAssets<Prefab>("data://prefabs", true);
 	watchAssets<Material>("data://materials", false);
 	watchAssets<Shader>("engine_data://shaders", true);
@@ -319,6 +515,7 @@ void EditorApp::openProject(const fs::path& projectPath)
 
 	watchAssets<Shader>("editor_data://shaders", true);
 	watchRawShaders("editor_data://shaders", true);
+	watchShaderIncludes("engine://Tools/include", { "engine_data://shaders", "editor_data://shaders" });
 	
 	auto& world = getWorld();
 	world.reset();
@@ -9,6 +9,7 @@
 #include "Runtime/Ecs/Components/LightComponent.h"
 #include "Runtime/Ecs/World.h"
 #include "Runtime/Ecs/Utils.h"
+#include "Runtime/Ecs/SceneLoader.h"
 #include "Runtime/System/FileSystem.h"
 #include "Runtime/System/Timer.h"
 #include "Runtime/Rendering/RenderPass.h"
@@ -112,12 +113,23 @@ void loadEditorCamera()
 	editState.camera = outData;
 }
 
+// scene being loaded by openScene, owned by the scene loader
+std::weak_ptr<SceneLoad> sSceneLoad;
+
+void cancelSceneLoad()
+{
+	// a pending scene must not merge into the world that replaces it
+	if (auto load = sSceneLoad.lock())
+		load->cancel();
+	sSceneLoad.reset();
+}
 
 auto createNewScene()
 {
 	auto& app = Singleton<EditorApp>::getInstance();
 	auto& world = app.getWorld();
 	auto& editState = app.getEditState();
+	cancelSceneLoad();
 	world.reset();
 	loadEditorCamera();
 	defaultScene();
@@ -128,22 +140,26 @@ auto openScene()
 {
 	auto& app = Singleton<EditorApp>::getInstance();
 	auto& world = app.getWorld();
-	auto& editState = app.getEditState();
 	std::string path;
 	if (openFileDialog("scene", fs::resolve_protocol("data://scenes").string(), path))
 	{
+		cancelSceneLoad();
 		world.reset();
 		loadEditorCamera();
 
-		Timer timer;
-		std::vector<Entity> outData;
-		if (ecs::utils::loadData(path, outData))
+		// the scene is deserialized on a worker and merged over the next frames
+		auto timer = std::make_shared<Timer>();
+		sSceneLoad = app.getSceneLoader().load(path, [timer, path](SceneLoad& load)
 		{
-			auto time = timer.getTime(true);
+			if (load.getState() != SceneLoad::State::Merged)
+				return;
+
+			auto& editState = Singleton<EditorApp>::getInstance().getEditState();
+			auto time = timer->getTime(true);
 			std::string log_msg = "Scene loading time : " + std::to_string(time);
 			logging::get("Log")->info(log_msg.c_str());
 			editState.scene = path;
-		}
+		});
 	}
 }
 
@@ -180,6 +196,25 @@ void saveSceneAs()
 	}
 }
 
+void buildAssetPack()
+{
+	Timer timer;
+	AssetPackWriter writer;
+	writer.addDirectory("engine_data:", fs::resolve_protocol("engine_data://"));
+	writer.addDirectory("data:", fs::resolve_protocol("data://"));
+
+	const auto path = fs::resolve_protocol("app://data.pack");
+	if (!writer.write(path))
+	{
+		logging::get("Log")->error().write("Failed to write asset pack {0}", path.string());
+		return;
+	}
+
+	auto time = timer.getTime(true);
+	std::string log_msg = "Asset pack with " + std::to_string(writer.size()) + " assets built in : " + std::to_string(time);
+	logging::get("Log")->info(log_msg.c_str());
+}
+
 
 MainEditorWindow::MainEditorWindow()
 {
@@ -273,6 +308,11 @@ void MainEditorWindow::onMenuBar()
 			saveSceneAs();
 		}
 		gui::Separator();
+		if (gui::MenuItem("Build Asset Pack", nullptr, false, editState.project != ""))
+		{
+			buildAssetPack();
+		}
+		gui::Separator();
 
 		if (gui::MenuItem("Quit", "Alt+F4"))
 		{
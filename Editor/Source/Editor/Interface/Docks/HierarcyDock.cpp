@@ -8,10 +8,35 @@
 #include "Runtime/Input/InputContext.h"
 #include "Runtime/System/FileSystem.h"
 #include "Runtime/Rendering/Mesh.h"
+#include "Runtime/Assets/AssetManager.h"
 #include "Runtime/Ecs/Components/ModelComponent.h"
 namespace Docks
 {
 
+	//-----------------------------------------------------------------------------
+	//  Name : createModel ()
+	/// <summary>
+	/// Model of a dropped mesh together with the simplified lods the mesh
+	/// cooker wrote next to it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Model createModel(AssetHandle<Mesh> mesh)
+	{
+		auto& app = Singleton<EditorApp>::getInstance();
+		auto& manager = app.getAssetManager();
+
+		Model model;
+		model.setLod(mesh, 0);
+		for (std::uint32_t lod = 1; mesh && lod <= mesh->lods; ++lod)
+		{
+			// a missing lod gets the shared empty request, which never becomes ready
+			const auto& request = manager.load<Mesh>(mesh.id() + "_lod" + std::to_string(lod), false);
+			if (request.isReady())
+				model.setLod(request.asset, lod);
+		}
+		return model;
+	}
+
 	void checkContextMenu(ecs::Entity entity)
 	{
 		auto& app = Singleton<EditorApp>::getInstance();
@@ -107,8 +132,7 @@ namespace Docks
 						if (dragged.is_type<AssetHandle<Mesh>>())
 						{
 							auto mesh = dragged.get_value<AssetHandle<Mesh>>();
-							Model model;		
-							model.setLod(mesh, 0);
+							auto model = createModel(mesh);
 
 							auto object = world.entities.create();
 							//Add component and configure it.
@@ -151,8 +175,7 @@ namespace Docks
 						if (dragged.is_type<AssetHandle<Mesh>>())
 						{
 							auto mesh = dragged.get_value<AssetHandle<Mesh>>();
-							Model model;
-							model.setLod(mesh, 0);
+							auto model = createModel(mesh);
 
 							auto object = world.entities.create();
 							//Add component and configure it.
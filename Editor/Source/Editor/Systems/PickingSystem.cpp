@@ -2,6 +2,7 @@
 #include "Runtime/ecs/Components/TransformComponent.h"
 #include "Runtime/ecs/Components/CameraComponent.h"
 #include "Runtime/ecs/Components/ModelComponent.h"
+#include "Runtime/ecs/Systems/SpatialSystem.h"
 #include "Runtime/Assets/AssetManager.h"
 #include "Runtime/Rendering/RenderPass.h"
 #include "Runtime/Rendering/Camera.h"
@@ -160,17 +161,24 @@ void PickingSystem::frameRender(ecs::EntityManager &entities, ecs::EventManager
 		// View rect and transforms for picking pass
 		gfx::setViewTransform(pass.id, &pickView, &pickProj);
 
-		entities.each<TransformComponent, ModelComponent>([this, &pass, &camera, dt](
-			ecs::Entity e,
-			TransformComponent& transformComponent,
-			ModelComponent& modelComponent
-			)
+		auto spatial = world.systems.system<SpatialSystem>();
+		if (!spatial)
+			return;
+
+		// only what the narrow picking frustum sees can be picked
+		const math::frustum pickFrustum(pickView, pickProj, gfx::getCaps()->homogeneousDepth);
+		spatial->queryFrustum(pickFrustum, [this, &entities, &pass, &pickFrustum](ecs::Entity e, unsigned int)
 		{
-			auto& model = modelComponent.getModel();
+			const auto transformComponent = entities.component<TransformComponent>(e.id()).lock();
+			const auto modelComponent = entities.component<ModelComponent>(e.id()).lock();
+			if (!transformComponent || !modelComponent)
+				return;
+
+			auto& model = modelComponent->getModel();
 			if (!model.isValid())
 				return;
 
-			const auto& worldTransform = transformComponent.getTransform();
+			const auto& worldTransform = transformComponent->getTransform();
 		
 			auto material = model.getMaterialForGroup({});
 			if (!material)
@@ -180,11 +188,10 @@ void PickingSystem::frameRender(ecs::EntityManager &entities, ecs::EventManager
 			if (!hMesh)
 				return;
 
-			const auto& frustum = camera.getFrustum();
 			const auto& bounds = hMesh->aabb;
 
 			// Test the bounding box of the mesh
-			if (!math::frustum::testOBB(frustum, bounds, worldTransform))
+			if (!math::frustum::testOBB(pickFrustum, bounds, worldTransform))
 				return;
 
 			auto entityIndex = e.id().index();
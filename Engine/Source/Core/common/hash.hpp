@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace core
+{
+	/// 32 bit FNV-1a offset basis and prime.
+	const std::uint32_t fnv1a_basis = 2166136261u;
+	const std::uint32_t fnv1a_prime = 16777619u;
+
+	/// FNV-1a hash of a null terminated string, usable in constant expressions.
+	constexpr std::uint32_t fnv1a(const char* str, std::uint32_t hash = fnv1a_basis)
+	{
+		return *str ? fnv1a(str + 1, (hash ^ std::uint32_t(std::uint8_t(*str))) * fnv1a_prime) : hash;
+	}
+
+	/// FNV-1a hash of a buffer.
+	inline std::uint32_t fnv1a(const void* data, std::size_t size, std::uint32_t hash = fnv1a_basis)
+	{
+		auto bytes = static_cast<const std::uint8_t*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+			hash = (hash ^ bytes[i]) * fnv1a_prime;
+		return hash;
+	}
+
+	/// 64 bit FNV-1a offset basis and prime.
+	const std::uint64_t fnv1a64_basis = 14695981039346656037ull;
+	const std::uint64_t fnv1a64_prime = 1099511628211ull;
+
+	/// 64 bit FNV-1a hash of a buffer, for content hashes where 32 bits collide too easily.
+	inline std::uint64_t fnv1a64(const void* data, std::size_t size, std::uint64_t hash = fnv1a64_basis)
+	{
+		auto bytes = static_cast<const std::uint8_t*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+			hash = (hash ^ bytes[i]) * fnv1a64_prime;
+		return hash;
+	}
+}
@@ -0,0 +1,402 @@
+#include "bvh.h"
+#include "Core/common/assert.hpp"
+#include <algorithm>
+
+namespace math
+{
+namespace
+{
+	inline bbox combine(const bbox& a, const bbox& b)
+	{
+		return bbox(glm::min(a.min, b.min), glm::max(a.max, b.max));
+	}
+
+	inline float surfaceArea(const bbox& b)
+	{
+		const vec3 d = b.max - b.min;
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	inline bool contains(const bbox& outer, const bbox& inner)
+	{
+		return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+			inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+	}
+}
+
+const int bvh::nullNode;
+
+bvh::bvh( float margin )
+	: mMargin(margin)
+{
+}
+
+std::vector<bvh::stack_entry>& bvh::getStack()
+{
+	static thread_local std::vector<stack_entry> stack;
+	return stack;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : allocateNode () (Private)
+/// <summary>
+/// Takes a node from the free list, growing the node pool if needed.
+/// </summary>
+//-----------------------------------------------------------------------------
+int bvh::allocateNode( )
+{
+	if (mFreeList == nullNode)
+	{
+		mNodes.emplace_back();
+		return static_cast<int>(mNodes.size()) - 1;
+	}
+
+	const int index = mFreeList;
+	mFreeList = mNodes[index].parent;
+	mNodes[index] = node();
+	return index;
+}
+
+void bvh::freeNode( int index )
+{
+	auto& n = mNodes[index];
+	n.parent = mFreeList;
+	n.child1 = nullNode;
+	n.child2 = nullNode;
+	n.height = -1;
+	mFreeList = index;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : insert ()
+/// <summary>
+/// Creates a leaf for the bounds and returns its proxy id.
+/// </summary>
+//-----------------------------------------------------------------------------
+int bvh::insert( const bbox & bounds, std::uint64_t userData )
+{
+	const int leaf = allocateNode();
+	auto& n = mNodes[leaf];
+	n.bounds = bounds;
+	n.bounds.inflate(mMargin);
+	n.userData = userData;
+	n.height = 0;
+
+	insertLeaf(leaf);
+	++mLeafCount;
+	return leaf;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : remove ()
+/// <summary>
+/// Destroys a leaf created by insert.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::remove( int proxy )
+{
+	Expects(proxy >= 0 && proxy < static_cast<int>(mNodes.size()) && mNodes[proxy].isLeaf() && mNodes[proxy].height == 0);
+
+	removeLeaf(proxy);
+	freeNode(proxy);
+	--mLeafCount;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : update ()
+/// <summary>
+/// Moves a leaf. The tree is only modified if the new bounds leave the fat
+/// bounds of the leaf. Returns true if the leaf was reinserted.
+/// </summary>
+//-----------------------------------------------------------------------------
+bool bvh::update( int proxy, const bbox & bounds )
+{
+	Expects(proxy >= 0 && proxy < static_cast<int>(mNodes.size()) && mNodes[proxy].isLeaf() && mNodes[proxy].height == 0);
+
+	if (contains(mNodes[proxy].bounds, bounds))
+		return false;
+
+	removeLeaf(proxy);
+	mNodes[proxy].bounds = bounds;
+	mNodes[proxy].bounds.inflate(mMargin);
+	insertLeaf(proxy);
+	return true;
+}
+
+void bvh::clear( )
+{
+	mNodes.clear();
+	mRoot = nullNode;
+	mFreeList = nullNode;
+	mLeafCount = 0;
+}
+
+std::uint64_t bvh::getUserData( int proxy ) const
+{
+	return mNodes[proxy].userData;
+}
+
+const bbox & bvh::getFatBounds( int proxy ) const
+{
+	return mNodes[proxy].bounds;
+}
+
+int bvh::getHeight( ) const
+{
+	return mRoot == nullNode ? 0 : mNodes[mRoot].height;
+}
+
+//-----------------------------------------------------------------------------
+//  Name : insertLeaf () (Private)
+/// <summary>
+/// Finds the sibling with the lowest surface area cost and walks back up
+/// refitting and rebalancing the ancestors.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::insertLeaf( int leaf )
+{
+	if (mRoot == nullNode)
+	{
+		mRoot = leaf;
+		mNodes[leaf].parent = nullNode;
+		return;
+	}
+
+	const bbox leafBounds = mNodes[leaf].bounds;
+	int index = mRoot;
+	while (!mNodes[index].isLeaf())
+	{
+		const auto& n = mNodes[index];
+		const int child1 = n.child1;
+		const int child2 = n.child2;
+
+		const float area = surfaceArea(n.bounds);
+		const float combinedArea = surfaceArea(combine(n.bounds, leafBounds));
+
+		// cost of creating a new parent for this node and the new leaf
+		const float cost = 2.0f * combinedArea;
+		// minimum cost of pushing the leaf further down the tree
+		const float inheritanceCost = 2.0f * (combinedArea - area);
+
+		auto descendCost = [this, &leafBounds, inheritanceCost](int child)
+		{
+			const auto& c = mNodes[child];
+			const float newArea = surfaceArea(combine(c.bounds, leafBounds));
+			return c.isLeaf() ? newArea + inheritanceCost : (newArea - surfaceArea(c.bounds)) + inheritanceCost;
+		};
+
+		const float cost1 = descendCost(child1);
+		const float cost2 = descendCost(child2);
+
+		if (cost < cost1 && cost < cost2)
+			break;
+
+		index = cost1 < cost2 ? child1 : child2;
+	}
+
+	const int sibling = index;
+	const int oldParent = mNodes[sibling].parent;
+	const int newParent = allocateNode();
+	{
+		auto& p = mNodes[newParent];
+		p.parent = oldParent;
+		p.bounds = combine(leafBounds, mNodes[sibling].bounds);
+		p.height = mNodes[sibling].height + 1;
+		p.child1 = sibling;
+		p.child2 = leaf;
+	}
+
+	if (oldParent != nullNode)
+	{
+		if (mNodes[oldParent].child1 == sibling)
+			mNodes[oldParent].child1 = newParent;
+		else
+			mNodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		mRoot = newParent;
+	}
+	mNodes[sibling].parent = newParent;
+	mNodes[leaf].parent = newParent;
+
+	index = mNodes[leaf].parent;
+	while (index != nullNode)
+	{
+		index = balance(index);
+
+		auto& n = mNodes[index];
+		n.height = 1 + std::max(mNodes[n.child1].height, mNodes[n.child2].height);
+		n.bounds = combine(mNodes[n.child1].bounds, mNodes[n.child2].bounds);
+
+		index = n.parent;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : removeLeaf () (Private)
+/// <summary>
+/// Detaches a leaf, replacing its parent by its sibling.
+/// </summary>
+//-----------------------------------------------------------------------------
+void bvh::removeLeaf( int leaf )
+{
+	if (leaf == mRoot)
+	{
+		mRoot = nullNode;
+		return;
+	}
+
+	const int parent = mNodes[leaf].parent;
+	const int grandParent = mNodes[parent].parent;
+	const int sibling = mNodes[parent].child1 == leaf ? mNodes[parent].child2 : mNodes[parent].child1;
+
+	if (grandParent != nullNode)
+	{
+		if (mNodes[grandParent].child1 == parent)
+			mNodes[grandParent].child1 = sibling;
+		else
+			mNodes[grandParent].child2 = sibling;
+		mNodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		int index = grandParent;
+		while (index != nullNode)
+		{
+			index = balance(index);
+
+			auto& n = mNodes[index];
+			n.bounds = combine(mNodes[n.child1].bounds, mNodes[n.child2].bounds);
+			n.height = 1 + std::max(mNodes[n.child1].height, mNodes[n.child2].height);
+
+			index = n.parent;
+		}
+	}
+	else
+	{
+		mRoot = sibling;
+		mNodes[sibling].parent = nullNode;
+		freeNode(parent);
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : balance () (Private)
+/// <summary>
+/// Performs a left or right rotation if node A is imbalanced and returns
+/// the new root of the subtree.
+/// </summary>
+//-----------------------------------------------------------------------------
+int bvh::balance( int iA )
+{
+	auto* A = &mNodes[iA];
+	if (A->isLeaf() || A->height < 2)
+		return iA;
+
+	const int iB = A->child1;
+	const int iC = A->child2;
+	auto* B = &mNodes[iB];
+	auto* C = &mNodes[iC];
+
+	const int balanceFactor = C->height - B->height;
+
+	// rotate C up
+	if (balanceFactor > 1)
+	{
+		const int iF = C->child1;
+		const int iG = C->child2;
+		auto* F = &mNodes[iF];
+		auto* G = &mNodes[iG];
+
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+
+		if (C->parent != nullNode)
+		{
+			if (mNodes[C->parent].child1 == iA)
+				mNodes[C->parent].child1 = iC;
+			else
+				mNodes[C->parent].child2 = iC;
+		}
+		else
+		{
+			mRoot = iC;
+		}
+
+		if (F->height > G->height)
+		{
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->bounds = combine(B->bounds, G->bounds);
+			C->bounds = combine(A->bounds, F->bounds);
+			A->height = 1 + std::max(B->height, G->height);
+			C->height = 1 + std::max(A->height, F->height);
+		}
+		else
+		{
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->bounds = combine(B->bounds, F->bounds);
+			C->bounds = combine(A->bounds, G->bounds);
+			A->height = 1 + std::max(B->height, F->height);
+			C->height = 1 + std::max(A->height, G->height);
+		}
+
+		return iC;
+	}
+
+	// rotate B up
+	if (balanceFactor < -1)
+	{
+		const int iD = B->child1;
+		const int iE = B->child2;
+		auto* D = &mNodes[iD];
+		auto* E = &mNodes[iE];
+
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+
+		if (B->parent != nullNode)
+		{
+			if (mNodes[B->parent].child1 == iA)
+				mNodes[B->parent].child1 = iB;
+			else
+				mNodes[B->parent].child2 = iB;
+		}
+		else
+		{
+			mRoot = iB;
+		}
+
+		if (D->height > E->height)
+		{
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->bounds = combine(C->bounds, E->bounds);
+			B->bounds = combine(A->bounds, D->bounds);
+			A->height = 1 + std::max(C->height, E->height);
+			B->height = 1 + std::max(A->height, D->height);
+		}
+		else
+		{
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->bounds = combine(C->bounds, D->bounds);
+			B->bounds = combine(A->bounds, E->bounds);
+			A->height = 1 + std::max(C->height, D->height);
+			B->height = 1 + std::max(A->height, E->height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "math_types.h"
+#include "bbox.h"
+#include "frustum.h"
+#include <cstdint>
+#include <vector>
+
+namespace math
+{
+using namespace glm;
+
+//-----------------------------------------------------------------------------
+// Main class declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : bvh (Class)
+/// <summary>
+/// Dynamic bounding volume hierarchy. Leaves store enlarged ("fat") bounds
+/// so small movements do not touch the tree, and the tree is kept balanced
+/// with rotations on insertion and removal. Queries visit O(log n) nodes
+/// for well distributed objects.
+/// </summary>
+//-----------------------------------------------------------------------------
+class bvh
+{
+public:
+	//-------------------------------------------------------------------------
+	// Constructors & Destructors
+	//-------------------------------------------------------------------------
+	bvh						( float margin = 0.1f );
+
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	int						insert				( const bbox & bounds, std::uint64_t userData );
+	void					remove				( int proxy );
+	bool					update				( int proxy, const bbox & bounds );
+	void					clear				( );
+	std::uint64_t			getUserData			( int proxy ) const;
+	const bbox &			getFatBounds		( int proxy ) const;
+	int						getHeight			( ) const;
+	std::size_t				getCount			( ) const { return mLeafCount; }
+
+	//-------------------------------------------------------------------------
+	// Public Query Methods
+	//-------------------------------------------------------------------------
+	//-----------------------------------------------------------------------------
+	//  Name : queryFrustum ()
+	/// <summary>
+	/// Calls callback(userData, frustumBits) for every leaf whose fat bounds
+	/// are inside or intersect the frustum. Bit i of frustumBits is set if
+	/// the fat bounds are completely inside plane i, such planes are not
+	/// tested again below the node that passed them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryFrustum( const frustum & f, F && callback ) const
+	{
+		if (mRoot == nullNode)
+			return;
+
+		// callbacks may run nested queries, which work above this base
+		auto& stack = getStack();
+		const auto base = stack.size();
+		stack.push_back({ mRoot, 0 });
+		while (stack.size() > base)
+		{
+			const auto entry = stack.back();
+			stack.pop_back();
+
+			const auto& n = mNodes[entry.node];
+			unsigned int frustumBits = entry.frustumBits;
+			if (frustumBits != 0x3F)
+			{
+				int lastOutside = -1;
+				if (f.classifyAABB(n.bounds, frustumBits, lastOutside) == VolumeQuery::Outside)
+					continue;
+			}
+
+			if (n.isLeaf())
+			{
+				callback(n.userData, frustumBits);
+			}
+			else
+			{
+				stack.push_back({ n.child1, frustumBits });
+				stack.push_back({ n.child2, frustumBits });
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : queryAABB ()
+	/// <summary>
+	/// Calls callback(userData) for every leaf whose fat bounds overlap the
+	/// box.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryAABB( const bbox & bounds, F && callback ) const
+	{
+		query([&bounds](const bbox& nodeBounds)
+		{
+			return nodeBounds.intersect(bounds);
+		}, callback);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : querySphere ()
+	/// <summary>
+	/// Calls callback(userData) for every leaf whose fat bounds overlap the
+	/// sphere.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void querySphere( const vec3 & center, float radius, F && callback ) const
+	{
+		const float radiusSq = radius * radius;
+		query([&center, radiusSq](const bbox& nodeBounds)
+		{
+			const vec3 closest = nodeBounds.closestPoint(center);
+			const vec3 delta = closest - center;
+			return dot(delta, delta) <= radiusSq;
+		}, callback);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : queryRay ()
+	/// <summary>
+	/// Calls callback(userData) for every leaf whose fat bounds are hit by the
+	/// segment from origin to origin + direction * maxDistance.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryRay( const vec3 & origin, const vec3 & direction, float maxDistance, F && callback ) const
+	{
+		const vec3 velocity = direction * maxDistance;
+		query([&origin, &velocity](const bbox& nodeBounds)
+		{
+			float t = 0.0f;
+			return nodeBounds.containsPoint(origin) || nodeBounds.intersect(origin, velocity, t, true);
+		}, callback);
+	}
+
+private:
+	static const int nullNode = -1;
+
+	struct node
+	{
+		bool isLeaf() const { return child1 == nullNode; }
+
+		/// Fat bounds for leaves, union of the children otherwise.
+		bbox			bounds;
+		/// User data of leaves.
+		std::uint64_t	userData = 0;
+		/// Parent node, or next free node while on the free list.
+		int				parent = nullNode;
+		int				child1 = nullNode;
+		int				child2 = nullNode;
+		/// Leaves are 0, free nodes -1.
+		int				height = -1;
+	};
+
+	struct stack_entry
+	{
+		int node;
+		/// Frustum planes the node is known to be completely inside of.
+		unsigned int frustumBits;
+	};
+
+	//-------------------------------------------------------------------------
+	// Private Methods
+	//-------------------------------------------------------------------------
+	template<typename Test, typename F>
+	void query( Test && test, F && callback ) const
+	{
+		if (mRoot == nullNode)
+			return;
+
+		// callbacks may run nested queries, which work above this base
+		auto& stack = getStack();
+		const auto base = stack.size();
+		stack.push_back({ mRoot, 0 });
+		while (stack.size() > base)
+		{
+			const auto& n = mNodes[stack.back().node];
+			stack.pop_back();
+
+			if (!test(n.bounds))
+				continue;
+
+			if (n.isLeaf())
+			{
+				callback(n.userData);
+			}
+			else
+			{
+				stack.push_back({ n.child1, 0 });
+				stack.push_back({ n.child2, 0 });
+			}
+		}
+	}
+
+	int						allocateNode		( );
+	void					freeNode			( int index );
+	void					insertLeaf			( int leaf );
+	void					removeLeaf			( int leaf );
+	int						balance				( int index );
+	static std::vector<stack_entry>& getStack	( );
+
+	//-------------------------------------------------------------------------
+	// Private Variables
+	//-------------------------------------------------------------------------
+	std::vector<node>		mNodes;
+	int						mRoot = nullNode;
+	int						mFreeList = nullNode;
+	std::size_t				mLeafCount = 0;
+	float					mMargin = 0.1f;
+};
+
+}
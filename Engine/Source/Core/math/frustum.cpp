@@ -1,6 +1,8 @@
 #include "frustum.h" 
+#include "mathfu/vectorial/simd4f.h"
 
 #include <xutility>
+#include <cfloat>
 
 namespace math
 {
@@ -835,4 +837,219 @@ namespace math
 		return true;
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : testBatch ()
+	/// <summary>
+	/// Tests every box of the batch against the frustum, four boxes per
+	/// iteration, and sets bit i of the visible mask if box i is inside or
+	/// intersecting. Planes a box is known to be inside of are not tested
+	/// for it, and the plane that rejected a box last time is tested first.
+	/// The rejecting plane of every box is written back to the batch.
+	/// Returns the number of visible boxes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t frustum::testBatch(cull_batch & batch, std::vector<std::uint32_t> & visible) const
+	{
+		const std::size_t count = batch.mCount;
+		visible.assign((count + 31) / 32, 0);
+		if (count == 0)
+			return 0;
+
+		simd4f planeX[6], planeY[6], planeZ[6], planeD[6];
+		for (size_t i = 0; i < 6; i++)
+		{
+			planeX[i] = simd4f_splat(planes[i].data.x);
+			planeY[i] = simd4f_splat(planes[i].data.y);
+			planeZ[i] = simd4f_splat(planes[i].data.z);
+			planeD[i] = simd4f_splat(planes[i].data.w);
+		}
+
+		const simd4f zero = simd4f_zero();
+		auto abs4 = [zero](simd4f v)
+		{
+			return simd4f_max(v, simd4f_sub(zero, v));
+		};
+
+		std::size_t visibleCount = 0;
+		const std::size_t groups = batch.getGroupCount();
+		for (std::size_t group = 0; group < groups; ++group)
+		{
+			const std::size_t base = group * 4;
+			const std::size_t lanes = std::min<std::size_t>(4, count - base);
+
+			const simd4f cx = simd4f_uload4(&batch.mCenter[0][base]);
+			const simd4f cy = simd4f_uload4(&batch.mCenter[1][base]);
+			const simd4f cz = simd4f_uload4(&batch.mCenter[2][base]);
+			simd4f axis[9];
+			for (size_t i = 0; i < 9; i++)
+				axis[i] = simd4f_uload4(&batch.mAxis[i][base]);
+
+			// signed distance of the point of each box nearest to the inside
+			// of the plane, positive means the whole box is outside
+			auto nearDistance = [&](simd4f px, simd4f py, simd4f pz, simd4f pd)
+			{
+				const simd4f distance = simd4f_madd(cz, pz, simd4f_madd(cy, py, simd4f_madd(cx, px, pd)));
+				const simd4f rx = abs4(simd4f_madd(axis[2], pz, simd4f_madd(axis[1], py, simd4f_mul(axis[0], px))));
+				const simd4f ry = abs4(simd4f_madd(axis[5], pz, simd4f_madd(axis[4], py, simd4f_mul(axis[3], px))));
+				const simd4f rz = abs4(simd4f_madd(axis[8], pz, simd4f_madd(axis[7], py, simd4f_mul(axis[6], px))));
+				return simd4f_sub(distance, simd4f_add(rx, simd4f_add(ry, rz)));
+			};
+
+			// the plane that rejected a box last time usually does again, a
+			// group whose boxes all stay behind their own plane is done
+			float lastX[4], lastY[4], lastZ[4], lastD[4];
+			bool coherent = true;
+			for (size_t lane = 0; lane < 4 && coherent; ++lane)
+			{
+				// padding lanes repeat the first box
+				const std::size_t index = base + (lane < lanes ? lane : 0);
+				const int last = batch.mLastOutside[index];
+				coherent = last >= 0 && ((batch.mFrustumBits[index] >> last) & 0x1) == 0x0;
+				if (coherent)
+				{
+					lastX[lane] = planes[last].data.x;
+					lastY[lane] = planes[last].data.y;
+					lastZ[lane] = planes[last].data.z;
+					lastD[lane] = planes[last].data.w;
+				}
+			}
+			if (coherent)
+			{
+				float result[4];
+				simd4f_ustore4(nearDistance(simd4f_uload4(lastX), simd4f_uload4(lastY), simd4f_uload4(lastZ), simd4f_uload4(lastD)), result);
+				bool allOutside = true;
+				for (size_t lane = 0; lane < lanes; ++lane)
+					allOutside &= result[lane] > 0.0f;
+				if (allOutside)
+					continue;
+			}
+
+			// planes every box of the group is inside of are skipped
+			unsigned int groupBits = 0x3F;
+			for (size_t lane = 0; lane < lanes; ++lane)
+				groupBits &= batch.mFrustumBits[base + lane];
+
+			float distances[6][4];
+			for (size_t i = 0; i < 6; i++)
+			{
+				if (((groupBits >> i) & 0x1) == 0x0)
+					simd4f_ustore4(nearDistance(planeX[i], planeY[i], planeZ[i], planeD[i]), distances[i]);
+			}
+
+			for (size_t lane = 0; lane < lanes; ++lane)
+			{
+				const std::size_t index = base + lane;
+				const unsigned int frustumBits = batch.mFrustumBits[index];
+				int outside = -1;
+				for (size_t i = 0; i < 6 && outside < 0; i++)
+				{
+					if (((frustumBits >> i) & 0x1) == 0x0 && distances[i][lane] > 0.0f)
+						outside = (int)i;
+				}
+
+				batch.mLastOutside[index] = static_cast<std::int8_t>(outside);
+				if (outside < 0)
+				{
+					visible[index / 32] |= std::uint32_t(1) << (index % 32);
+					++visibleCount;
+				}
+			}
+		}
+
+		return visibleCount;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////
+	// cull_batch Member Functions
+	///////////////////////////////////////////////////////////////////////////////
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Removes every box.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cull_batch::clear()
+	{
+		for (auto & component : mCenter)
+			component.clear();
+		for (auto & component : mAxis)
+			component.clear();
+		mFrustumBits.clear();
+		mLastOutside.clear();
+		mCount = 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : reserve ()
+	/// <summary>
+	/// Reserves storage for count boxes.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cull_batch::reserve(std::size_t count)
+	{
+		const std::size_t padded = (count + 3) & ~std::size_t(3);
+		for (auto & component : mCenter)
+			component.reserve(padded);
+		for (auto & component : mAxis)
+			component.reserve(padded);
+		mFrustumBits.reserve(padded);
+		mLastOutside.reserve(padded);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Adds a world space axis aligned box and returns its index. Planes
+	/// whose bit is set in frustumBits are known to contain the box,
+	/// lastOutside is the plane that rejected it last time or -1.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t cull_batch::add(const bbox & bounds, unsigned int frustumBits, int lastOutside)
+	{
+		const vec3 extents = (bounds.max - bounds.min) * 0.5f;
+		return push(bounds.getCenter(), vec3(extents.x, 0.0f, 0.0f), vec3(0.0f, extents.y, 0.0f), vec3(0.0f, 0.0f, extents.z), frustumBits, lastOutside);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Adds an object space box with its world transform and returns its
+	/// index. The box is tested as an oriented box, like frustum::testOBB.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t cull_batch::add(const bbox & bounds, const transform_t & t, unsigned int frustumBits, int lastOutside)
+	{
+		const vec3 extents = (bounds.max - bounds.min) * 0.5f;
+		return push(t.transformCoord(bounds.getCenter()), t.xAxis() * extents.x, t.yAxis() * extents.y, t.zAxis() * extents.z, frustumBits, lastOutside);
+	}
+
+	std::size_t cull_batch::push(const vec3 & center, const vec3 & axisX, const vec3 & axisY, const vec3 & axisZ, unsigned int frustumBits, int lastOutside)
+	{
+		const std::size_t index = mCount++;
+
+		// grow a whole group at a time, padding lanes are empty boxes
+		if (index % 4 == 0)
+		{
+			for (auto & component : mCenter)
+				component.resize(index + 4, 0.0f);
+			for (auto & component : mAxis)
+				component.resize(index + 4, 0.0f);
+			mFrustumBits.resize(index + 4, 0);
+			mLastOutside.resize(index + 4, -1);
+		}
+
+		mFrustumBits[index] = static_cast<std::uint8_t>(frustumBits & 0x3F);
+		mLastOutside[index] = static_cast<std::int8_t>(lastOutside);
+
+		const vec3 * axes[3] = { &axisX, &axisY, &axisZ };
+		for (size_t component = 0; component < 3; ++component)
+		{
+			mCenter[component][index] = center[component];
+			for (size_t axis = 0; axis < 3; ++axis)
+				mAxis[axis * 3 + component][index] = (*axes[axis])[component];
+		}
+
+		return index;
+	}
+
 }
\ No newline at end of file
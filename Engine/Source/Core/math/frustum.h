@@ -7,6 +7,8 @@
 #include "transform.h"
 #include "bbox.h"
 #include "bbox_extruded.h"
+#include <cstdint>
+#include <vector>
 
 namespace math
 {
@@ -15,6 +17,54 @@ using namespace glm;
 //-----------------------------------------------------------------------------
 // Main class declarations
 //-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : cull_batch (Class)
+/// <summary>
+/// Oriented boxes laid out as structure of arrays for batched frustum tests.
+/// Every box is stored as its world space center and its three half axes,
+/// and the arrays are padded to a multiple of four boxes so the kernel can
+/// test four boxes per iteration. Each box also carries the planes it is
+/// known to be inside of and the plane that rejected it last time, which
+/// the caller keeps per object between frames.
+/// </summary>
+//-----------------------------------------------------------------------------
+class cull_batch
+{
+public:
+	//-------------------------------------------------------------------------
+	// Public Methods
+	//-------------------------------------------------------------------------
+	void							clear				( );
+	void							reserve				( std::size_t count );
+	std::size_t						add					( const bbox & bounds, unsigned int frustumBits = 0, int lastOutside = -1 );
+	std::size_t						add					( const bbox & bounds, const transform_t & t, unsigned int frustumBits = 0, int lastOutside = -1 );
+	int								getLastOutside		( std::size_t index ) const { return mLastOutside[index]; }
+	std::size_t						size				( ) const { return mCount; }
+	std::size_t						getGroupCount		( ) const { return (mCount + 3) / 4; }
+
+private:
+	friend class frustum;
+
+	//-------------------------------------------------------------------------
+	// Private Methods
+	//-------------------------------------------------------------------------
+	std::size_t						push				( const vec3 & center, const vec3 & axisX, const vec3 & axisY, const vec3 & axisZ, unsigned int frustumBits, int lastOutside );
+
+	//-------------------------------------------------------------------------
+	// Private Variables
+	//-------------------------------------------------------------------------
+	/// World space centers, one array per component.
+	std::vector<float>	mCenter[3];
+	/// Half axes scaled by the extents, mAxis[axis * 3 + component].
+	std::vector<float>	mAxis[9];
+	/// Planes each box is known to be completely inside of, one bit per plane.
+	std::vector<std::uint8_t> mFrustumBits;
+	/// Plane that rejected each box, -1 if none. Updated by testBatch.
+	std::vector<std::int8_t> mLastOutside;
+	/// Number of boxes.
+	std::size_t			mCount = 0;
+};
+
 //-----------------------------------------------------------------------------
 //  Name : frustum (Class)
 /// <summary>
@@ -49,6 +99,7 @@ public:
     bool							testSweptSphere		( const vec3 & center, float radius, const vec3 & sweepDirection ) const;
     bool							testFrustum			( const frustum & frustum ) const;
     bool							testLine			( const vec3 & v1, const vec3 & v2 ) const;
+	std::size_t						testBatch			( cull_batch & batch, std::vector<std::uint32_t> & visible ) const;
     frustum             &			mul					( const transform_t & t );
     //-------------------------------------------------------------------------
 	// Public Static Functions
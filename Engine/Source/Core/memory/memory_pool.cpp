@@ -1,5 +1,7 @@
 #include "memory_pool.hpp"
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 namespace core
 {
@@ -40,33 +42,48 @@ namespace core
 		return static_cast<void*>(block);
 	}
 
-	void MemoryPool::free(void* block)
+	size_t MemoryPool::find_chunk(const void* block) const
 	{
-		// find block index of the element
-		size_t index = invalid;
-		size_t offset = _chunk_entries_size * _block_size;
+		// the last chunk starting at or before the block
+		const auto address = reinterpret_cast<uintptr_t>(block);
+		auto it = std::upper_bound(_chunk_ranges.begin(), _chunk_ranges.end(), address,
+			[](uintptr_t value, const std::pair<uintptr_t, size_t>& range) { return value < range.first; });
+		if (it == _chunk_ranges.begin())
+			return invalid;
 
-		for (size_t i = 0; i < _chunks.size(); ++i)
-		{
-			if ((size_t)block >= (size_t)_chunks[i] && (size_t)block < (size_t)_chunks[i] + offset)
-			{
-				index = i*_chunk_entries_size + ((size_t)block - (size_t)_chunks[i]) / _block_size;
-				break;
-			}
-		}
+		--it;
+		if (address >= it->first + _chunk_entries_size * _block_size)
+			return invalid;
 
-		if (index == invalid)
+		return it->second;
+	}
+
+	bool MemoryPool::owns(const void* block) const
+	{
+		return find_chunk(block) != invalid;
+	}
+
+	bool MemoryPool::free(void* block)
+	{
+		// find block index of the element
+		const size_t chunk = find_chunk(block);
+		if (chunk == invalid)
 		{
 			//LOGW("try to free block which does NOT belongs to this memory pool.");
-			return;
+			return false;
 		}
 
+		const size_t index = chunk*_chunk_entries_size + ((uintptr_t)block - (uintptr_t)_chunks[chunk]) / _block_size;
+
+#ifndef NDEBUG
 		memset(block, 0xCC, _block_size);
+#endif
 
 		// recycle this memory block, add it to the first of free list
 		*(size_t*)block = _first_free_block;
 		_first_free_block = index;
 		_available++;
+		return true;
 	}
 
 	void MemoryPool::free_all()
@@ -76,6 +93,7 @@ namespace core
 			::free(chunk);
 
 		_chunks.clear();
+		_chunk_ranges.clear();
 		_available = 0;
 		_first_free_block = invalid;
 	}
@@ -83,11 +101,13 @@ namespace core
 	size_t MemoryPool::grow()
 	{
 		auto chunk = static_cast<uint8_t*>(::malloc(_chunk_entries_size*_block_size));
-		memset(chunk, 0xCC, _chunk_entries_size*_block_size);
-
 		if (chunk == nullptr)
 			return invalid;
 
+#ifndef NDEBUG
+		memset(chunk, 0xCC, _chunk_entries_size*_block_size);
+#endif
+
 		auto iterator = chunk;
 		auto offset = _chunk_entries_size * _chunks.size();
 		for (size_t i = 1; i < _chunk_entries_size; ++i, iterator += _block_size)
@@ -95,6 +115,8 @@ namespace core
 		*(size_t*)iterator = invalid;
 
 		_available += _chunk_entries_size;
+		const auto range = std::make_pair(reinterpret_cast<uintptr_t>(chunk), _chunks.size());
+		_chunk_ranges.insert(std::upper_bound(_chunk_ranges.begin(), _chunk_ranges.end(), range), range);
 		_chunks.push_back(chunk);
 		return offset;
 	}
@@ -3,6 +3,8 @@
 #include <vector>
 #include <type_traits>
 #include <limits>
+#include <cstdint>
+#include <utility>
 
 namespace core
 {
@@ -19,8 +21,10 @@ namespace core
 
 		// accquire a unused block of memory
 		void* malloc();
-		// recycle the memory to pool
-		void free(void*);
+		// recycle the memory to pool, returns false if the block does not belong to it
+		bool free(void*);
+		// returns true if the block was dealt out by this pool
+		bool owns(const void*) const;
 		// destruct all objects and frees all chunks allocated
 		void free_all();
 
@@ -33,8 +37,11 @@ namespace core
 		constexpr const static size_t invalid = std::numeric_limits<size_t>::max();
 
 		size_t grow();
+		size_t find_chunk(const void*) const;
 
 		std::vector<uint8_t*> _chunks;
+		// chunk start addresses sorted in ascending order with their chunk index
+		std::vector<std::pair<uintptr_t, size_t>> _chunk_ranges;
 
 		size_t _available;
 		size_t _first_free_block;
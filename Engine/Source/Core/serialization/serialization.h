@@ -19,6 +19,13 @@ friend class serialization::access;\
 template<typename Archive> friend void SAVE_FUNCTION_NAME(Archive & ar, T const &);\
 template<typename Archive> friend void LOAD_FUNCTION_NAME(Archive & ar, T &);
 
+// for types with a CEREAL_CLASS_VERSION, use SAVE_VERSIONED and LOAD_VERSIONED
+#define SERIALIZABLE_VERSIONED(T) \
+public:\
+friend class serialization::access;\
+template<typename Archive> friend void SAVE_FUNCTION_NAME(Archive & ar, T const &, std::uint32_t const);\
+template<typename Archive> friend void LOAD_FUNCTION_NAME(Archive & ar, T &, std::uint32_t const);
+
 
 #define SERIALIZE(cls) \
 template<typename Archive> inline \
@@ -32,3 +39,17 @@ void SAVE_FUNCTION_NAME(Archive & ar, cls const & obj)
 template<typename Archive> inline \
 void LOAD_FUNCTION_NAME(Archive & ar, cls & obj)
 
+// the deleted overloads hide the unversioned functions of a base class, cereal
+// would find both otherwise
+#define SAVE_VERSIONED(cls) \
+template<typename Archive> \
+void SAVE_FUNCTION_NAME(Archive & ar, cls const & obj) = delete; \
+template<typename Archive> inline \
+void SAVE_FUNCTION_NAME(Archive & ar, cls const & obj, std::uint32_t const version)
+
+#define LOAD_VERSIONED(cls) \
+template<typename Archive> \
+void LOAD_FUNCTION_NAME(Archive & ar, cls & obj) = delete; \
+template<typename Archive> inline \
+void LOAD_FUNCTION_NAME(Archive & ar, cls & obj, std::uint32_t const version)
+
@@ -1,19 +1,62 @@
 #pragma once
 
 #include <functional>
+#include <algorithm>
 #include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <vector>
 
 #include "Core/common/type_traits.hpp"
 #include "Core/common/string_utils.h"
 #include "Core/events/delegate.hpp"
 #include "../System/FileSystem.h"
 #include "LoadRequest.hpp"
+#include "AssetPack.h"
 
 
 /// aliases
 template<typename T>
 using RequestContainer = std::unordered_map<std::string, LoadRequest<T>>;
 
+struct Storage;
+
+struct AssetSize
+{
+	/// Bytes kept in system memory
+	std::uint64_t cpu = 0;
+	/// Bytes kept in video memory
+	std::uint64_t gpu = 0;
+};
+
+struct AssetResidency
+{
+	/// Name of the storage
+	std::string name;
+	/// Loaded assets
+	std::size_t count = 0;
+	/// Assets held by an AssetHandle outside of the storage
+	std::size_t referenced = 0;
+	/// Measured memory of the loaded assets
+	std::uint64_t cpuBytes = 0;
+	std::uint64_t gpuBytes = 0;
+	/// Budget of the storage in bytes, 0 if unlimited
+	std::uint64_t budget = 0;
+};
+
+struct EvictionCandidate
+{
+	/// Storage holding the asset
+	Storage* storage;
+	/// Key of the asset in the storage
+	const std::string* key;
+	/// Last frame the asset was requested or referenced
+	std::uint32_t lastUsedFrame;
+	/// Memory freed by evicting it
+	std::uint64_t bytes;
+};
+
 struct Storage
 {
 	//-----------------------------------------------------------------------------
@@ -46,6 +89,34 @@ struct Storage
 	//-----------------------------------------------------------------------------
 	virtual void clear(const std::string& protocol) = 0;
 
+	//-----------------------------------------------------------------------------
+	//  Name : collect (virtual )
+	/// <summary>
+	/// Measures the loaded assets and refreshes the last used frame of the
+	/// referenced ones. Assets nothing but the storage holds are added to
+	/// the candidates when given.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual AssetResidency collect(std::uint32_t frame, std::vector<EvictionCandidate>* candidates) = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : evict (virtual )
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void evict(const std::string& key) = 0;
+
+	/// Name shown in the residency info
+	std::string name;
+	/// Budget in bytes, 0 if unlimited
+	std::uint64_t budget = 0;
+	/// Measured memory of the loaded assets, kept up to date as assets are
+	/// loaded and erased
+	std::uint64_t cpuBytes = 0;
+	std::uint64_t gpuBytes = 0;
 };
 
 template<typename T>
@@ -72,6 +143,8 @@ struct TStorage : Storage
 	void clear()
 	{
 		container.clear();
+		cpuBytes = 0;
+		gpuBytes = 0;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -90,11 +163,122 @@ struct TStorage : Storage
 			const auto& id = pair.first;
 			if (string_utils::beginsWith(id, protocol, true))
 			{
-				container.erase(id);
+				erase(id);
 			}
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : collect ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	AssetResidency collect(std::uint32_t frame, std::vector<EvictionCandidate>* candidates)
+	{
+		AssetResidency residency;
+		residency.name = name;
+		residency.budget = budget;
+		for (auto& pair : container)
+		{
+			auto& request = pair.second;
+			// still loading
+			if (!request.isReady())
+				continue;
+
+			if (!request.measured)
+				account(request);
+
+			residency.count++;
+			residency.cpuBytes += request.cpuBytes;
+			residency.gpuBytes += request.gpuBytes;
+
+			// the storage holds one reference, any other keeps the asset resident
+			if (request.asset.use_count() > 1)
+			{
+				request.lastUsedFrame = frame;
+				residency.referenced++;
+			}
+			// embedded assets can not be loaded again, pending loads still reference the request
+			else if (candidates && pair.first.find("embedded") == std::string::npos && !request.isLoading())
+			{
+				const auto bytes = request.cpuBytes + request.gpuBytes;
+				if (bytes > 0)
+					candidates->push_back({ this, &pair.first, request.lastUsedFrame, bytes });
+			}
+		}
+		return residency;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : evict ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void evict(const std::string& key)
+	{
+		erase(key);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : erase ()
+	/// <summary>
+	/// Removes the request and takes its memory off the storage totals.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void erase(const std::string& key)
+	{
+		auto it = container.find(key);
+		if (it == std::end(container))
+			return;
+
+		unaccount(it->second);
+		container.erase(it);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : account ()
+	/// <summary>
+	/// Measures the current data of the request and adds it to the storage
+	/// totals in place of the data it had before. Installed as the
+	/// request's onSetData.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void account(LoadRequest<T>& request)
+	{
+		unaccount(request);
+		if (!request.isReady())
+			return;
+
+		const auto size = measure(*request.asset.get());
+		request.cpuBytes = size.cpu;
+		request.gpuBytes = size.gpu;
+		request.measured = true;
+		cpuBytes += size.cpu;
+		gpuBytes += size.gpu;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : unaccount ()
+	/// <summary>
+	/// Takes the measured memory of the request off the storage totals.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void unaccount(LoadRequest<T>& request)
+	{
+		if (!request.measured)
+			return;
+
+		cpuBytes -= request.cpuBytes;
+		gpuBytes -= request.gpuBytes;
+		request.measured = false;
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : loadFromMemoryDefault ()
 	/// <summary>
@@ -125,6 +309,16 @@ struct TStorage : Storage
 	//-----------------------------------------------------------------------------
 	static void saveToFileDefault(const fs::path&, const AssetHandle<T>&) {}
 
+	//-----------------------------------------------------------------------------
+	//  Name : measureDefault ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static AssetSize measureDefault(const T&) { return {}; }
+
 	/// key, data, size, outRequest
 	delegate<void(const std::string&, const std::uint8_t*, std::uint32_t, LoadRequest<T>&)> loadFromMemory = loadFromMemoryDefault;
 
@@ -134,6 +328,9 @@ struct TStorage : Storage
 	/// absolutKey, asset
 	delegate<void(const fs::path&, const AssetHandle<T>&)> saveToFile = saveToFileDefault;
 
+	/// asset, returns its memory
+	delegate<AssetSize(const T&)> measure = measureDefault;
+
 	/// Storage container
 	std::unordered_map<std::string, LoadRequest<T>> container;
 	/// Sub directory
@@ -155,6 +352,18 @@ inline fs::path getAbsoluteKey(const std::string& toLowerKey, T storage)
 	return absoluteKey;
 };
 
+template<typename T>
+inline std::string getPackKey(const std::string& toLowerKey, T storage)
+{
+	// same layout as getAbsoluteKey, but without touching the file system
+	const auto separator = toLowerKey.find_last_of("/\\");
+	const auto dir = toLowerKey.substr(0, separator + 1);
+	const auto file = toLowerKey.substr(separator + 1);
+
+	static const std::string ext = ".asset";
+	return AssetPack::normalizeKey(dir + "/" + storage->subdir.generic_string() + "/" + storage->platform.generic_string() + "/" + file + ext);
+};
+
 
 class AssetManager
 {
@@ -230,7 +439,95 @@ public:
 	//-----------------------------------------------------------------------------
 	void shutdown()
 	{
+		unmountPacks();
+	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : mountPack ()
+	/// <summary>
+	/// Maps a pack built by the AssetPackWriter. Assets found in a mounted
+	/// pack are read from it instead of from loose files, packs mounted
+	/// later take precedence.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool mountPack(const fs::path& path)
+	{
+		auto pack = std::make_shared<AssetPack>();
+		if (!pack->open(path))
+			return false;
+
+		std::lock_guard<std::mutex> lock(mPacksMutex);
+		mPacks.push_back(pack);
+		mHasPacks = true;
+		return true;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : unmountPacks ()
+	/// <summary>
+	/// Readers still using a pack keep its mapping alive.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void unmountPacks()
+	{
+		std::lock_guard<std::mutex> lock(mPacksMutex);
+		mPacks.clear();
+		mHasPacks = false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : hasPacks ()
+	/// <summary>
+	/// True if any pack is mounted. Lets readers skip the pack lookup.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool hasPacks() const
+	{
+		return mHasPacks;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : setOccluderMesh ()
+	/// <summary>
+	/// Marks a mesh as part of an occluder. Only such meshes keep a cpu copy
+	/// of their triangles for the occlusion buffer. Main thread only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setOccluderMesh(const std::string& key)
+	{
+		mOccluderMeshes.insert(string_utils::toLower(key));
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : isOccluderMesh ()
+	/// <summary>
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isOccluderMesh(const std::string& key) const
+	{
+		return mOccluderMeshes.find(string_utils::toLower(key)) != mOccluderMeshes.end();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : findPacked ()
+	/// <summary>
+	/// Looks a normalized pack key up in the mounted packs. Returns the pack
+	/// holding it and sets the entry, or null. Safe to call from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<AssetPack> findPacked(const std::string& packKey, const AssetPack::Entry*& entry) const
+	{
+		if (!mHasPacks)
+			return nullptr;
+
+		std::lock_guard<std::mutex> lock(mPacksMutex);
+		for (auto it = mPacks.rbegin(); it != mPacks.rend(); ++it)
+		{
+			entry = (*it)->find(packKey);
+			if (entry)
+				return *it;
+		}
+		return nullptr;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -267,6 +564,136 @@ public:
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : setBudget ()
+	/// <summary>
+	/// Sets the budget in bytes for all storages together, 0 for unlimited.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setBudget(std::uint64_t bytes)
+	{
+		mBudget = bytes;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : setBudget ()
+	/// <summary>
+	/// Sets the budget in bytes of a single storage, 0 for unlimited.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename T>
+	void setBudget(std::uint64_t bytes)
+	{
+		getStorage<T>()->budget = bytes;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : setBudget ()
+	/// <summary>
+	/// Sets the budget of the storage with the given name. Returns false if
+	/// there is no such storage.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool setBudget(const std::string& name, std::uint64_t bytes)
+	{
+		const auto toLowerName = string_utils::toLower(name);
+		for (auto& pair : storages)
+		{
+			if (string_utils::toLower(pair.second->name) == toLowerName)
+			{
+				pair.second->budget = bytes;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : getBudget ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint64_t getBudget() const
+	{
+		return mBudget;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : getResidency ()
+	/// <summary>
+	/// Returns the loaded assets and their memory per storage.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<AssetResidency> getResidency()
+	{
+		std::vector<AssetResidency> result;
+		for (auto& pair : storages)
+			result.push_back(pair.second->collect(mFrame, nullptr));
+		return result;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Called once per frame. When a storage or the total is over budget,
+	/// assets that nothing but the storage holds are evicted, least recently
+	/// used first, until the budgets are met or no such asset is left.
+	/// The assets are only looked at while a budget is exceeded, the totals
+	/// are kept by the storages.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(std::uint32_t frame)
+	{
+		mFrame = frame;
+
+		auto used = [](const Storage* storage)
+		{
+			return storage->cpuBytes + storage->gpuBytes;
+		};
+
+		bool overBudget = false;
+		std::uint64_t total = 0;
+		for (auto& pair : storages)
+		{
+			const auto storage = pair.second.get();
+			total += used(storage);
+			overBudget |= storage->budget != 0 && used(storage) > storage->budget;
+		}
+		overBudget |= mBudget != 0 && total > mBudget;
+		if (!overBudget)
+			return;
+
+		mCandidates.clear();
+		for (auto& pair : storages)
+			pair.second->collect(frame, &mCandidates);
+
+		auto isOverBudget = [this, &used, &total](Storage* storage)
+		{
+			return (mBudget != 0 && total > mBudget)
+				|| (storage->budget != 0 && used(storage) > storage->budget);
+		};
+
+		std::sort(mCandidates.begin(), mCandidates.end(), [](const EvictionCandidate& a, const EvictionCandidate& b)
+		{
+			return a.lastUsedFrame < b.lastUsedFrame;
+		});
+
+		for (const auto& candidate : mCandidates)
+		{
+			if (!isOverBudget(candidate.storage))
+				continue;
+
+			// the key is owned by the entry being erased
+			const std::string key = *candidate.key;
+			candidate.storage->evict(key);
+			total -= candidate.bytes;
+		}
+		mCandidates.clear();
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : createAssetFromMemory ()
 	/// <summary>
@@ -283,7 +710,7 @@ public:
 	{
 		auto storage = getStorage<T>();
 		const std::string toLowerKey = string_utils::toLower(key);
-		return createAssetFromMemoryImpl<T>(toLowerKey, data, size, storage->container, storage->loadFromMemory);
+		return createAssetFromMemoryImpl<T>(toLowerKey, data, size, *storage, storage->loadFromMemory);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -308,6 +735,9 @@ public:
 
 		fs::rename(absoluteKey, absoluteNewKey, std::error_code{});
 
+		// the replaced asset no longer counts, the renamed one keeps its measure
+		if (toLowerNewKey != toLowerKey)
+			storage->erase(toLowerNewKey);
 		storage->container[toLowerNewKey] = storage->container[toLowerKey];
 		storage->container[toLowerNewKey].asset.link->id = toLowerNewKey;
 		storage->container.erase(toLowerKey);
@@ -331,7 +761,7 @@ public:
 		auto& request = storage->container[toLowerKey];
 		request.asset.link->asset.reset();
 		request.asset.link->id.clear();
-		storage->container.erase(toLowerKey);
+		storage->erase(toLowerKey);
 	}
 
 	//-----------------------------------------------------------------------------
@@ -354,7 +784,7 @@ public:
 		auto& request = storage->container[toLowerKey];
 		request.asset.link->asset.reset();
 		request.asset.link->id.clear();
-		storage->container.erase(toLowerKey);
+		storage->erase(toLowerKey);
 	}
 	//-----------------------------------------------------------------------------
 	//  Name : load ()
@@ -375,16 +805,38 @@ public:
 		//if embedded resource
 		if (toLowerKey.find("embedded") != std::string::npos)
 		{
-			return findOrCreateAssetImpl<T>(toLowerKey, storage->container);
+			return findOrCreateAssetImpl<T>(toLowerKey, *storage);
 		}
 		else
 		{
+			// packed assets are passed to the readers by their pack key
+			const auto packKey = getPackKey(toLowerKey, storage);
+			const AssetPack::Entry* entry = nullptr;
+			if (findPacked(packKey, entry))
+				return loadAssetFromFileImpl<T>(toLowerKey, packKey, async, force, false, *storage, storage->loadFromFile);
+
 			const fs::path absoluteKey = getAbsoluteKey(toLowerKey, storage);
-			return loadAssetFromFileImpl<T>(toLowerKey, absoluteKey, async, force, storage->container, storage->loadFromFile);
+			return loadAssetFromFileImpl<T>(toLowerKey, absoluteKey, async, force, true, *storage, storage->loadFromFile);
 
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : setPriority ()
+	/// <summary>
+	/// Changes the priority of a streamed load, i.e. by distance to the
+	/// camera. Can be called every frame, does nothing once the asset exists.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename T>
+	void setPriority(const std::string& key, float priority)
+	{
+		auto storage = getStorage<T>();
+		auto it = storage->container.find(string_utils::toLower(key));
+		if (it != std::end(storage->container))
+			it->second.setPriority(priority);
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : save ()
 	/// <summary>
@@ -417,17 +869,20 @@ private:
 		const fs::path& absoluteKey,
 		bool async,
 		bool force,
-		RequestContainer<T>& container,
+		bool checkExists,
+		TStorage<T>& storage,
 		F&& loadFunc
 	)
 	{
-
+		auto& container = storage.container;
 		auto it = container.find(key);
 		if (it != std::end(container))
 		{
 			auto& request = it->second;
+			request.lastUsedFrame = mFrame;
 
-			if (force)
+			// streamed loads nobody wanted were dropped, dispatch them again
+			if (force || request.isCancelled())
 			{
 				loadFunc(key, absoluteKey, async, request);
 			}
@@ -438,14 +893,15 @@ private:
 
 			return request;
 		}
-		else if (!fs::exists(absoluteKey, std::error_code{}))
+		else if (checkExists && !fs::exists(absoluteKey, std::error_code{}))
 		{
 			static LoadRequest<T> emptyRequest;
 			return emptyRequest;
 		}
 		else
 		{
-			auto& request = findOrCreateAssetImpl(key, container);
+			auto& request = findOrCreateAssetImpl(key, storage);
+			request.lastUsedFrame = mFrame;
 			//Dispatch the loading
 			loadFunc(key, absoluteKey, async, request);
 
@@ -466,11 +922,11 @@ private:
 		const std::string& key,
 		const std::uint8_t* data,
 		const std::uint32_t& size,
-		RequestContainer<T>& container,
+		TStorage<T>& storage,
 		F&& loadFunc
 	)
 	{
-
+		auto& container = storage.container;
 		auto it = container.find(key);
 		if (it != std::end(container))
 		{
@@ -480,7 +936,7 @@ private:
 		}
 		else
 		{
-			auto& request = findOrCreateAssetImpl(key, container);
+			auto& request = findOrCreateAssetImpl(key, storage);
 			//Dispatch the loading
 			loadFunc(key, data, size, request);
 
@@ -500,13 +956,30 @@ private:
 	template<typename T>
 	LoadRequest<T>& findOrCreateAssetImpl(
 		const std::string& key,
-		RequestContainer<T>& container
+		TStorage<T>& storage
 	)
 	{
-		auto& request = container[key];
+		auto& request = storage.container[key];
+		// the storage measures the data as it arrives
+		if (!request.onSetData)
+			request.onSetData = delegate<void(LoadRequest<T>&)>(&storage, &TStorage<T>::account);
 		return request;
 	}
 
 	/// Different storages
 	std::unordered_map<core::TypeInfo::index_t, std::shared_ptr<Storage>> storages;
+	/// Mounted packs in mount order
+	std::vector<std::shared_ptr<AssetPack>> mPacks;
+	/// Guards mPacks, readers look assets up from worker threads
+	mutable std::mutex mPacksMutex;
+	/// Is any pack mounted, read without the lock
+	std::atomic<bool> mHasPacks{ false };
+	/// Meshes whose triangles are kept on the cpu, see setOccluderMesh
+	std::unordered_set<std::string> mOccluderMeshes;
+	/// Budget of all storages together in bytes, 0 if unlimited
+	std::uint64_t mBudget = 0;
+	/// Frame of the last update
+	std::uint32_t mFrame = 0;
+	/// Assets that can be evicted, kept to reuse the memory
+	std::vector<EvictionCandidate> mCandidates;
 };
@@ -0,0 +1,203 @@
+#include "AssetPack.h"
+#include "Core/common/hash.hpp"
+#include "Core/common/string_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static_assert(sizeof(AssetPack::Header) == 40, "pack header layout changed");
+static_assert(sizeof(AssetPack::Entry) == 40, "pack entry layout changed");
+
+std::string AssetPack::normalizeKey(const std::string& key)
+{
+	std::string result;
+	result.reserve(key.size());
+	for (auto c : string_utils::toLower(key))
+	{
+		if (c == '\\')
+			c = '/';
+		if (c == '/' && !result.empty() && result.back() == '/')
+			continue;
+		result.push_back(c);
+	}
+	return result;
+}
+
+bool AssetPack::open(const fs::path& path)
+{
+	auto file = std::make_shared<fs::mapped_file>();
+	if (!file->open(path) || file->size() < sizeof(Header))
+		return false;
+
+	const auto data = file->data();
+	const auto size = file->size();
+	Header header;
+	std::memcpy(&header, data, sizeof(Header));
+	if (std::memcmp(header.magic, "PACK", 4) != 0 || header.version != Version)
+		return false;
+
+	const auto indexSize = std::uint64_t(header.entryCount) * sizeof(Entry);
+	if (header.indexOffset % alignof(Entry) != 0
+		|| header.indexOffset + indexSize > size
+		|| header.stringsOffset + header.stringsSize > size)
+		return false;
+
+	mEntries = reinterpret_cast<const Entry*>(data + header.indexOffset);
+	mEntryCount = header.entryCount;
+	mStrings = reinterpret_cast<const char*>(data + header.stringsOffset);
+
+	for (std::size_t i = 0; i < mEntryCount; ++i)
+	{
+		const auto& entry = mEntries[i];
+		if (entry.offset + entry.size > size
+			|| std::uint64_t(entry.keyOffset) + entry.keySize > header.stringsSize)
+		{
+			mEntries = nullptr;
+			mEntryCount = 0;
+			mStrings = nullptr;
+			return false;
+		}
+	}
+
+	mPath = path;
+	mFile = std::move(file);
+	return true;
+}
+
+const AssetPack::Entry* AssetPack::find(const std::string& key) const
+{
+	const auto hash = core::fnv1a(static_cast<const void*>(key.data()), key.size());
+	const auto end = mEntries + mEntryCount;
+	auto it = std::lower_bound(mEntries, end, hash, [](const Entry& entry, std::uint32_t value)
+	{
+		return entry.hash < value;
+	});
+
+	// keys with the same hash are next to each other
+	for (; it != end && it->hash == hash; ++it)
+	{
+		if (it->keySize == key.size() && std::memcmp(mStrings + it->keyOffset, key.data(), key.size()) == 0)
+			return it;
+	}
+	return nullptr;
+}
+
+const std::uint8_t* AssetPack::getData(const Entry& entry) const
+{
+	if (entry.compression != Compression::None)
+		return nullptr;
+
+	return mFile->data() + entry.offset;
+}
+
+void AssetPackWriter::add(const std::string& key, const fs::path& file)
+{
+	mFiles.emplace_back(AssetPack::normalizeKey(key), file);
+}
+
+void AssetPackWriter::addDirectory(const std::string& protocol, const fs::path& directory, const std::string& extension)
+{
+	std::error_code err;
+	const auto root = fs::absolute(directory);
+	const auto rootSize = root.generic_string().size();
+	for (fs::recursive_directory_iterator it(root, err), end; !err && it != end; it.increment(err))
+	{
+		const auto& path = it->path();
+		if (!fs::is_regular_file(it->status()) || string_utils::toLower(path.extension().string()) != extension)
+			continue;
+
+		const auto relative = path.generic_string().substr(rootSize);
+		add(protocol + "/" + relative, path);
+	}
+}
+
+bool AssetPackWriter::write(const fs::path& path) const
+{
+	struct Item
+	{
+		std::uint32_t hash;
+		std::size_t order;
+		const std::string* key;
+		const fs::path* file;
+	};
+
+	std::vector<Item> items;
+	items.reserve(mFiles.size());
+	for (std::size_t i = 0; i < mFiles.size(); ++i)
+	{
+		const auto& key = mFiles[i].first;
+		items.push_back({ core::fnv1a(static_cast<const void*>(key.data()), key.size()), i, &key, &mFiles[i].second });
+	}
+
+	// sorted by hash for the lookup, the last file added for a key wins
+	std::sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+	{
+		if (a.hash != b.hash)
+			return a.hash < b.hash;
+		if (*a.key != *b.key)
+			return *a.key < *b.key;
+		return a.order > b.order;
+	});
+	items.erase(std::unique(items.begin(), items.end(), [](const Item& a, const Item& b)
+	{
+		return *a.key == *b.key;
+	}), items.end());
+
+	auto align = [](std::uint64_t offset)
+	{
+		return (offset + AssetPack::Alignment - 1) / AssetPack::Alignment * AssetPack::Alignment;
+	};
+
+	std::vector<AssetPack::Entry> entries(items.size());
+	std::string strings;
+	for (std::size_t i = 0; i < items.size(); ++i)
+	{
+		auto& entry = entries[i];
+		std::memset(&entry, 0, sizeof(entry));
+		entry.hash = items[i].hash;
+		entry.keyOffset = static_cast<std::uint32_t>(strings.size());
+		entry.keySize = static_cast<std::uint16_t>(items[i].key->size());
+		entry.compression = AssetPack::Compression::None;
+		strings += *items[i].key;
+	}
+
+	AssetPack::Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "PACK", 4);
+	header.version = AssetPack::Version;
+	header.entryCount = static_cast<std::uint32_t>(entries.size());
+	header.indexOffset = sizeof(header);
+	header.stringsOffset = header.indexOffset + entries.size() * sizeof(AssetPack::Entry);
+	header.stringsSize = strings.size();
+
+	std::ofstream output(path, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!output)
+		return false;
+
+	// the index is written again once the blob offsets are known
+	output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPack::Entry));
+	output.write(strings.data(), strings.size());
+
+	std::uint64_t offset = header.stringsOffset + header.stringsSize;
+	const char padding[AssetPack::Alignment] = {};
+	for (std::size_t i = 0; i < items.size(); ++i)
+	{
+		fs::mapped_file file;
+		if (!file.open(*items[i].file))
+			return false;
+
+		const auto aligned = align(offset);
+		output.write(padding, aligned - offset);
+		output.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+		entries[i].offset = aligned;
+		entries[i].size = file.size();
+		entries[i].originalSize = file.size();
+		offset = aligned + file.size();
+	}
+
+	output.seekp(header.indexOffset);
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPack::Entry));
+	return !!output;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "../System/FileSystem.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : AssetPack (Class)
+/// <summary>
+/// Read only archive of cooked assets. The file starts with an index sorted
+/// by the hash of the normalized asset keys, followed by the key strings and
+/// the asset blobs aligned to 64 bytes. The whole pack is mapped once, so
+/// finding and reading an asset does not touch the file system.
+/// </summary>
+//-----------------------------------------------------------------------------
+class AssetPack
+{
+public:
+	/// Codec of an entry, only uncompressed entries are written so far
+	enum class Compression : std::uint8_t
+	{
+		None = 0,
+		LZ4 = 1,
+		Zstd = 2,
+	};
+
+	struct Header
+	{
+		/// Always "PACK"
+		char magic[4];
+		/// Format version
+		std::uint32_t version;
+		/// Number of entries in the index
+		std::uint32_t entryCount;
+		std::uint32_t reserved;
+		/// File offset of the index
+		std::uint64_t indexOffset;
+		/// File offset and size of the key strings
+		std::uint64_t stringsOffset;
+		std::uint64_t stringsSize;
+	};
+
+	struct Entry
+	{
+		/// Hash of the normalized key, the index is sorted by it
+		std::uint32_t hash;
+		/// Offset of the key in the string table
+		std::uint32_t keyOffset;
+		/// File offset of the blob
+		std::uint64_t offset;
+		/// Size of the blob as stored
+		std::uint64_t size;
+		/// Size of the blob once decompressed
+		std::uint64_t originalSize;
+		/// Length of the key
+		std::uint16_t keySize;
+		/// Compression of the blob
+		Compression compression;
+		std::uint8_t reserved[5];
+	};
+
+	static const std::uint32_t Version = 1;
+	static const std::uint32_t Alignment = 64;
+
+	//-----------------------------------------------------------------------------
+	//  Name : normalizeKey ()
+	/// <summary>
+	/// Lower cases the key, uses forward slashes and collapses repeated
+	/// separators, so "Data://Textures\a.asset" becomes "data:/textures/a.asset".
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static std::string normalizeKey(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : open ()
+	/// <summary>
+	/// Maps the pack and validates its header and index.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool open(const fs::path& path);
+
+	//-----------------------------------------------------------------------------
+	//  Name : find ()
+	/// <summary>
+	/// Binary searches the index for a normalized key. Returns null if the
+	/// pack does not contain it.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const Entry* find(const std::string& key) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : getData ()
+	/// <summary>
+	/// Returns the stored blob of an entry inside the mapping. Null if the
+	/// entry uses a codec this build can not read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::uint8_t* getData(const Entry& entry) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : getFile ()
+	/// <summary>
+	/// The mapping of the pack, readers keep it alive while they use a blob.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::shared_ptr<fs::mapped_file>& getFile() const { return mFile; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getPath ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const fs::path& getPath() const { return mPath; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getEntryCount ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t getEntryCount() const { return mEntryCount; }
+
+private:
+	/// Path of the pack
+	fs::path mPath;
+	/// The mapped pack
+	std::shared_ptr<fs::mapped_file> mFile;
+	/// Index inside the mapping
+	const Entry* mEntries = nullptr;
+	std::size_t mEntryCount = 0;
+	/// Key strings inside the mapping
+	const char* mStrings = nullptr;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : AssetPackWriter (Class)
+/// <summary>
+/// Builds an AssetPack from loose asset files. Used by the editor and by
+/// command line tools when preparing a shipped build.
+/// </summary>
+//-----------------------------------------------------------------------------
+class AssetPackWriter
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Adds a file under the given key. The file is read when the pack is
+	/// written. A later file with the same key replaces an earlier one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add(const std::string& key, const fs::path& file);
+
+	//-----------------------------------------------------------------------------
+	//  Name : addDirectory ()
+	/// <summary>
+	/// Adds every file with the given extension below a directory, keyed by
+	/// the protocol followed by the path relative to the directory. Pass the
+	/// protocol the directory is mounted at, i.e. "data:".
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void addDirectory(const std::string& protocol, const fs::path& directory, const std::string& extension = ".asset");
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Writes the pack. Returns false if the pack or one of the files could
+	/// not be written or read.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool write(const fs::path& path) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : size ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t size() const { return mFiles.size(); }
+
+private:
+	/// Normalized key and source file of every entry
+	std::vector<std::pair<std::string, fs::path>> mFiles;
+};
@@ -1,4 +1,5 @@
 #include "AssetReader.h"
+#include "AssetManager.h"
 #include "../Rendering/Texture.h"
 #include "../Rendering/Uniform.h"
 #include "../Rendering/Shader.h"
@@ -9,109 +10,403 @@
 #include "../System/FileSystem.h"
 #include "../System/Application.h"
 #include "../Threading/ThreadPool.h"
+#include "AssetStreamer.h"
+#include "TextureStreamer.h"
 #include "../Ecs/Prefab.h"
 #include "Core/serialization/archives.h"
 #include "Meta/Rendering/Material.hpp"
 
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 
 #include "ib-compress/indexbufferdecompression.h"
+#include "Graphics/src/image.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.c"
 typedef unsigned char stbi_uc;
 extern "C" stbi_uc *stbi_load_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp);
 extern "C" void stbi_image_free(void *retval_from_stbi_load);
 
+//-----------------------------------------------------------------------------
+//  Name : FileMemory (Struct)
+/// <summary>
+/// Contents of a file read on a worker thread. Assets in a mounted pack are
+/// read from the pack mapping, loose files are mapped when possible. Both
+/// are handed to the renderer by reference, the renderer releases the
+/// mapping once it consumed the data. Falls back to a heap copy.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct FileMemory
+{
+	static void releaseMapping(void* ptr, void* userData)
+	{
+		delete static_cast<std::shared_ptr<fs::mapped_file>*>(userData);
+	}
+
+	void read(const fs::path& path)
+	{
+		auto& manager = Singleton<Application>::getInstance().getAssetManager();
+		const AssetPack::Entry* entry = nullptr;
+		auto pack = manager.hasPacks() ? manager.findPacked(path.generic_string(), entry) : nullptr;
+		if (pack)
+		{
+			view = pack->getData(*entry);
+			if (!view)
+				return;
+
+			viewSize = static_cast<std::size_t>(entry->size);
+			mapping = pack->getFile();
+			mapping->prefetch(static_cast<std::size_t>(entry->offset), viewSize);
+			return;
+		}
+
+		auto file = std::make_shared<fs::mapped_file>();
+		if (file->open(path))
+		{
+			// fault the pages in here rather than on the render thread
+			file->prefetch();
+			view = file->data();
+			viewSize = file->size();
+			mapping = std::move(file);
+			return;
+		}
+
+		memory = fs::read_stream(std::ifstream{ path, std::ios::in | std::ios::binary });
+	}
+
+	const std::uint8_t* data() const
+	{
+		return mapping ? view : memory.data();
+	}
+
+	std::size_t size() const
+	{
+		return mapping ? viewSize : memory.size();
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : makeRef ()
+	/// <summary>
+	/// References a range of the file without copying it when it is mapped.
+	/// The mapping stays alive until the renderer releases the memory.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const gfx::Memory* makeRef(const std::uint8_t* ptr, std::uint32_t size) const
+	{
+		if (!mapping)
+			return gfx::copy(ptr, size);
+
+		return gfx::makeRef(ptr, size, &releaseMapping, new std::shared_ptr<fs::mapped_file>(mapping));
+	}
+
+	void reset()
+	{
+		mapping.reset();
+		view = nullptr;
+		viewSize = 0;
+		memory.clear();
+		memory.shrink_to_fit();
+	}
+
+	/// The mapped file or pack, null if mapping failed
+	std::shared_ptr<fs::mapped_file> mapping;
+	/// The contents inside the mapping
+	const std::uint8_t* view = nullptr;
+	std::size_t viewSize = 0;
+	/// Heap copy of the file when it could not be mapped
+	fs::ByteArray memory;
+};
+
+struct TextureData
+{
+	static void releaseMips(void* ptr, void* userData)
+	{
+		delete static_cast<std::vector<std::uint8_t>*>(userData);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : selectMips ()
+	/// <summary>
+	/// Picks the top mips to leave out. A first load only brings in the
+	/// tail of mips no larger than the tail size, later loads the mips the
+	/// streamer asked for.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void selectMips(std::uint32_t tailSize)
+	{
+		tailMips = 0;
+		while (tailSize != 0 && tailMips + 1 < mipCount && std::max(width, height) >> tailMips > tailSize)
+			++tailMips;
+
+		skip = reload ? std::min<std::uint8_t>(targetMips, mipCount - 1) : tailMips;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : downsample ()
+	/// <summary>
+	/// Box filters an rgba8 mip into the next smaller one.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static void downsample(const std::uint8_t* src, std::uint32_t srcWidth, std::uint32_t srcHeight, std::uint8_t* dst)
+	{
+		const auto dstWidth = std::max(srcWidth / 2, 1u);
+		const auto dstHeight = std::max(srcHeight / 2, 1u);
+		for (std::uint32_t y = 0; y < dstHeight; ++y)
+		{
+			const auto y0 = std::min(y * 2, srcHeight - 1) * srcWidth;
+			const auto y1 = std::min(y * 2 + 1, srcHeight - 1) * srcWidth;
+			for (std::uint32_t x = 0; x < dstWidth; ++x)
+			{
+				const auto x0 = std::min(x * 2, srcWidth - 1);
+				const auto x1 = std::min(x * 2 + 1, srcWidth - 1);
+				auto out = dst + (y * dstWidth + x) * 4;
+				for (std::uint32_t c = 0; c < 4; ++c)
+				{
+					const std::uint32_t sum = src[(y0 + x0) * 4 + c]
+						+ src[(y0 + x1) * 4 + c]
+						+ src[(y1 + x0) * 4 + c]
+						+ src[(y1 + x1) * 4 + c];
+					out[c] = static_cast<std::uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : decode ()
+	/// <summary>
+	/// Decodes the file to rgba8 and builds the mip chain from the first
+	/// resident mip down. The file is released afterwards.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void decode(std::uint32_t tailSize)
+	{
+		int w = 0;
+		int h = 0;
+		int comp = 0;
+		auto image = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &w, &h, &comp, 4);
+		file.reset();
+		if (nullptr == image)
+			return;
+
+		width = static_cast<std::uint16_t>(w);
+		height = static_cast<std::uint16_t>(h);
+		mipCount = 1;
+		while (std::max(width, height) >> mipCount != 0)
+			++mipCount;
+		selectMips(tailSize);
+
+		std::uint32_t size = 0;
+		for (std::uint8_t mip = skip; mip < mipCount; ++mip)
+			size += std::max(width >> mip, 1) * std::max(height >> mip, 1) * 4;
+		mips.resize(size);
+
+		// the skipped top mips are only filtered through, never kept
+		std::vector<std::uint8_t> scratch[2];
+		const std::uint8_t* src = image;
+		std::uint32_t srcWidth = width;
+		std::uint32_t srcHeight = height;
+		std::size_t offset = 0;
+		for (std::uint8_t mip = 0; mip < mipCount; ++mip)
+		{
+			if (mip > 0)
+			{
+				auto& dst = scratch[mip & 1];
+				dst.resize(std::max(srcWidth / 2, 1u) * std::max(srcHeight / 2, 1u) * 4);
+				downsample(src, srcWidth, srcHeight, dst.data());
+				src = dst.data();
+				srcWidth = std::max(srcWidth / 2, 1u);
+				srcHeight = std::max(srcHeight / 2, 1u);
+			}
+
+			if (mip >= skip)
+			{
+				const auto mipSize = srcWidth * srcHeight * 4;
+				std::memcpy(mips.data() + offset, src, mipSize);
+				offset += mipSize;
+			}
+		}
+		stbi_image_free(image);
+	}
+
+	FileMemory file;
+	/// Decoded rgba8 mips for formats the renderer can not parse, starting at the first resident one
+	std::vector<std::uint8_t> mips;
+	/// Size and mips of the full texture
+	std::uint16_t width = 0;
+	std::uint16_t height = 0;
+	std::uint8_t mipCount = 1;
+	/// Top mips left out of the loaded texture
+	std::uint8_t skip = 0;
+	/// Top mips left out by a first load
+	std::uint8_t tailMips = 0;
+	/// Top mips the streamer asked for when reloading
+	std::uint8_t targetMips = 0;
+	/// Whether a streamed texture is loaded again
+	bool reload = false;
+	/// Parsed container
+	gfx::ImageContainer container;
+	bool parsed = false;
+};
+
 void AssetReader::loadTextureFromFile(const std::string& key, const fs::path& absoluteKey, bool async, LoadRequest<Texture>& request)
 {
-	std::shared_ptr<fs::ByteArray> read_memory = std::make_shared<fs::ByteArray>();
+	std::shared_ptr<TextureData> read_memory = std::make_shared<TextureData>();
+
+	std::string ext = absoluteKey.extension().string();
+	const bool container = ext == ".dds"
+		|| ext == ".pvr"
+		|| ext == ".ktx"
+		|| ext == ".asset";
+
+	auto& app = Singleton<Application>::getInstance();
+	// only streamed textures start with their tail, the others never ask for more mips
+	auto& streamer = app.getTextureStreamer();
+	const auto tailSize = streamer.isStreamed(key) ? streamer.getTailSize() : 0;
+	// streamed textures are loaded again with the mips the streamer picked
+	if (request.isReady() && request.asset->streaming.enabled)
+	{
+		read_memory->reload = true;
+		read_memory->targetMips = request.asset->streaming.targetMips;
+	}
 
-	auto readMemory = [read_memory, absoluteKey]()
+	auto readMemory = [read_memory, absoluteKey, container, tailSize]()
 	{
 		if (!read_memory)
 			return;
 
-		*read_memory = fs::read_stream(std::ifstream{ absoluteKey, std::ios::in | std::ios::binary });
+		read_memory->file.read(absoluteKey);
+		if (read_memory->file.empty())
+			return;
+
+		if (container)
+		{
+			auto& image = read_memory->container;
+			read_memory->parsed = gfx::imageParse(image, read_memory->file.data(), static_cast<std::uint32_t>(read_memory->file.size()));
+			if (read_memory->parsed)
+			{
+				read_memory->width = static_cast<std::uint16_t>(image.m_width);
+				read_memory->height = static_cast<std::uint16_t>(image.m_height);
+				read_memory->mipCount = std::max<std::uint8_t>(image.m_numMips, 1);
+				read_memory->selectMips(tailSize);
+			}
+			return;
+		}
+
+		// decode here as well, straight from the mapped file
+		read_memory->decode(tailSize);
 	};
 
-	auto createResource = [read_memory, key, absoluteKey, &request]() mutable
+	auto createResource = [read_memory, key, container, tailSize, &request]() mutable
 	{
 		// if someone destroyed our memory
 		if (!read_memory)
 			return;
-		// if nothing was read
-		if (read_memory->empty())
-			return;
 
-		std::string ext = absoluteKey.extension().string();
-		if (ext == ".dds"
-			|| ext == ".pvr"
-			|| ext == ".ktx"
-			|| ext == ".asset")
+		std::shared_ptr<Texture> texture;
+		if (container)
 		{
-			const gfx::Memory* mem = gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-			read_memory->clear();
-			read_memory.reset();
+			// if nothing was read
+			if (read_memory->file.empty())
+				return;
+
+			const gfx::Memory* mem = read_memory->file.makeRef(read_memory->file.data(), static_cast<std::uint32_t>(read_memory->file.size()));
+			if (nullptr == mem)
+				return;
 
-			if (nullptr != mem)
+			// the renderer leaves the skipped top mips out of the upload
+			texture = std::make_shared<Texture>(mem, 0, read_memory->skip, nullptr);
+			if (read_memory->parsed && read_memory->skip > 0)
 			{
-				auto texture = std::make_shared<Texture>(mem, 0, 0, nullptr);
-				request.setData(key, texture);
-				request.invokeCallbacks();
+				const auto& image = read_memory->container;
+				gfx::calcTextureSize(texture->info
+					, std::uint16_t(std::max<std::uint32_t>(image.m_width >> read_memory->skip, 1))
+					, std::uint16_t(std::max<std::uint32_t>(image.m_height >> read_memory->skip, 1))
+					, std::uint16_t(std::max<std::uint32_t>(image.m_depth >> read_memory->skip, 1))
+					, image.m_cubeMap
+					, read_memory->mipCount - read_memory->skip > 1
+					, image.m_numLayers
+					, image.m_format
+				);
 			}
 		}
 		else
 		{
-			int width = 0;
-			int height = 0;
-			int comp = 0;
-
-			uint8_t* img = stbi_load_from_memory(read_memory->data()
-				, static_cast<int>(read_memory->size())
-				, &width
-				, &height
-				, &comp
-				, 4
-			);
-
-			read_memory->clear();
-			read_memory.reset();
-
-			if (nullptr != img)
-			{
-				auto texture = std::make_shared<Texture>(
-					std::uint16_t(width)
-					, std::uint16_t(height)
-					, false
-					, 1
-					, gfx::TextureFormat::RGBA8
-					, 0
-					, gfx::copy(img, width*height * 4)
-					);
-
+			if (read_memory->mips.empty())
+				return;
+
+			const auto skip = read_memory->skip;
+			const auto width = std::uint16_t(std::max(read_memory->width >> skip, 1));
+			const auto height = std::uint16_t(std::max(read_memory->height >> skip, 1));
+			// the renderer frees the mips once they are uploaded
+			auto mips = new std::vector<std::uint8_t>(std::move(read_memory->mips));
+			const gfx::Memory* mem = gfx::makeRef(mips->data(), static_cast<std::uint32_t>(mips->size()), &TextureData::releaseMips, mips);
+
+			texture = std::make_shared<Texture>(
+				width
+				, height
+				, read_memory->mipCount - skip > 1
+				, 1
+				, gfx::TextureFormat::RGBA8
+				, 0
+				, mem
+				);
+		}
 
-				stbi_image_free(img);
+		auto& streaming = texture->streaming;
+		streaming.enabled = tailSize != 0 && read_memory->mipCount > 1;
+		streaming.width = read_memory->width;
+		streaming.height = read_memory->height;
+		streaming.mipCount = read_memory->mipCount;
+		streaming.skippedMips = read_memory->skip;
+		streaming.tailMips = read_memory->tailMips;
+		streaming.targetMips = read_memory->skip;
+		if (streaming.enabled)
+		{
+			gfx::TextureInfo full;
+			gfx::calcTextureSize(full, read_memory->width, read_memory->height, 1, false, true, 1, texture->info.format);
+			streaming.fullSize = full.storageSize;
+		}
 
-				request.setData(key, texture);
-				request.invokeCallbacks();
-			}
+		// the renderer's requests carry over to the new mips
+		if (request.isReady())
+		{
+			const auto& previous = request.asset->streaming;
+			streaming.requestedMips = previous.requestedMips;
+			streaming.requestedTexels = previous.requestedTexels;
+			streaming.requestedFrame = previous.requestedFrame;
+			streaming.neededFrame = previous.neededFrame;
 		}
+		read_memory.reset();
+
+		request.setData(key, texture);
+		request.invokeCallbacks();
 	};
 
 	if (async)
 	{
-		auto& app = Singleton<Application>::getInstance();
-		auto& threadPool = app.getThreadPool();
-		auto task = threadPool.enqueue_with_callback(
-			// load function
-			[readMemory]()
+		auto task = app.getAssetStreamer().enqueue(
+			// load function, returns the bytes held until the texture is created
+			[readMemory, read_memory]()
 		{
 			readMemory();
+			return std::uint64_t(read_memory->file.size() + read_memory->mips.size());
 		},
 			// callback to the issuer
 			[createResource]() mutable
 		{
 			createResource();
+		},
+			// dropped when nobody waits for it anymore
+			[&request]()
+		{
+			return request.isWanted();
 		});
 		request.setTask(task);
 	}
@@ -126,14 +421,14 @@ void AssetReader::loadTextureFromFile(const std::string& key, const fs::path& ab
 void AssetReader::loadShaderFromFile(const std::string& key, const fs::path& absoluteKey, bool async, LoadRequest<Shader>& request)
 {
 
-	std::shared_ptr<fs::ByteArray> read_memory = std::make_shared<fs::ByteArray>();
+	std::shared_ptr<FileMemory> read_memory = std::make_shared<FileMemory>();
 
 	auto readMemory = [read_memory, absoluteKey]()
 	{
 		if (!read_memory)
 			return;
 
-		*read_memory = fs::read_stream(std::ifstream{ absoluteKey, std::ios::in | std::ios::binary });
+		read_memory->read(absoluteKey);
 	};
 
 	auto createResource = [read_memory, &request, key]() mutable
@@ -144,8 +439,7 @@ void AssetReader::loadShaderFromFile(const std::string& key, const fs::path& abs
 		// if nothing was read
 		if (read_memory->empty())
 			return;
-		const gfx::Memory* mem = gfx::copy(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
-		read_memory->clear();
+		const gfx::Memory* mem = read_memory->makeRef(read_memory->data(), static_cast<std::uint32_t>(read_memory->size()));
 		read_memory.reset();
 		if (nullptr != mem)
 		{
@@ -172,17 +466,22 @@ void AssetReader::loadShaderFromFile(const std::string& key, const fs::path& abs
 	if (async)
 	{
 		auto& app = Singleton<Application>::getInstance();
-		auto& threadPool = app.getThreadPool();
-		auto task = threadPool.enqueue_with_callback(
-			// load function
-			[readMemory]()
+		auto task = app.getAssetStreamer().enqueue(
+			// load function, returns the bytes held until the shader is created
+			[readMemory, read_memory]()
 		{
 			readMemory();
+			return std::uint64_t(read_memory->size());
 		},
 			// callback to the issuer
 			[createResource]() mutable
 		{
 			createResource();
+		},
+			// dropped when nobody waits for it anymore
+			[&request]()
+		{
+			return request.isWanted();
 		});
 
 		request.setTask(task);
@@ -228,15 +527,37 @@ void AssetReader::loadShaderFromMemory(const std::string& key, const std::uint8_
 
 }
 
+struct MeshBuffer
+{
+	/// View into the file, or into memory when it had to be decoded
+	const std::uint8_t* data = nullptr;
+	std::uint32_t size = 0;
+	/// Bytes per index of index buffers
+	std::uint32_t indexSize = 2;
+	/// Decoded data
+	fs::ByteArray memory;
+};
+
 struct MeshData
 {
 	gfx::VertexDecl decl;
 	std::vector<Group> groups;
-	std::vector<std::pair<fs::ByteArray, fs::ByteArray>> buffersMem; // vb, ib
+	FileMemory file;
+	std::vector<std::pair<MeshBuffer, MeshBuffer>> buffersMem; // vb, ib
 	math::bbox aabb;
 	MeshInfo info;
+	std::vector<math::vec3> occluderVertices;
+	std::vector<std::uint32_t> occluderIndices;
+	bool occluderRejected = false;
+	/// Were the bounds read from the file
+	bool hasBounds = false;
+	/// Simplified lods cooked next to the mesh
+	std::uint32_t lods = 0;
 };
 
+/// Occluder meshes with more triangles keep no cpu copy for occlusion culling
+static const std::uint32_t MaxOccluderTriangles = 4096;
+
 
 void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absoluteKey, bool async, LoadRequest<Mesh>& request)
 {
@@ -244,17 +565,37 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 #define BGFX_CHUNK_MAGIC_IB  BX_MAKEFOURCC('I', 'B', ' ', 0x0)
 #define BGFX_CHUNK_MAGIC_IBC BX_MAKEFOURCC('I', 'B', 'C', 0x0)
 #define BGFX_CHUNK_MAGIC_PRI BX_MAKEFOURCC('P', 'R', 'I', 0x0)
+#define MESH_CHUNK_MAGIC_VB32 BX_MAKEFOURCC('V', 'B', ' ', 0x2)
+#define MESH_CHUNK_MAGIC_IB32 BX_MAKEFOURCC('I', 'B', ' ', 0x1)
+#define MESH_CHUNK_MAGIC_BOUNDS BX_MAKEFOURCC('B', 'N', 'D', 0x0)
+#define MESH_CHUNK_MAGIC_LOD BX_MAKEFOURCC('L', 'O', 'D', 0x0)
 
 	std::shared_ptr<MeshData> data = std::make_shared<MeshData>();
+	// only the meshes of occluders keep their triangles on the cpu
+	auto& manager = Singleton<Application>::getInstance().getAssetManager();
+	data->occluderRejected = !manager.isOccluderMesh(key);
 
 	auto readMemory = [data, absoluteKey]()
 	{
 		if (!data)
 			return;
 
-		FileStreamReaderSeeker _reader(absoluteKey.string());
+		data->file.read(absoluteKey);
+		if (data->file.empty())
+			return;
 
-		std::pair<fs::ByteArray, fs::ByteArray> buffers;
+		// the buffers are referenced in place, nothing is copied out of the file
+		gfx::MemoryReader _reader(data->file.data(), static_cast<std::uint32_t>(data->file.size()));
+		auto view = [&_reader](std::uint32_t size)
+		{
+			MeshBuffer buffer;
+			buffer.data = _reader.getDataPtr();
+			buffer.size = static_cast<std::uint32_t>(std::min<std::int64_t>(size, _reader.remaining()));
+			_reader.seek(buffer.size, gfx::Whence::Current);
+			return buffer;
+		};
+
+		std::pair<MeshBuffer, MeshBuffer> buffers;
 		std::uint32_t chunk;
 		gfx::Error err;
 		while (4 == gfx::read(&_reader, chunk, &err)
@@ -263,17 +604,45 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 			switch (chunk)
 			{
 			case BGFX_CHUNK_MAGIC_VB:
+			case MESH_CHUNK_MAGIC_VB32:
 			{
 				gfx::read(&_reader, data->decl);
 
-				std::uint16_t stride = data->decl.getStride();
+				std::uint32_t stride = data->decl.getStride();
 
-				std::uint16_t numVertices;
-				gfx::read(&_reader, numVertices);
-				buffers.first.resize(numVertices*stride);
-				gfx::read(&_reader, (std::uint8_t*)buffers.first.data(), (std::uint32_t)buffers.first.size());
+				// large meshes store 32 bit vertex counts
+				std::uint32_t numVertices = 0;
+				if (chunk == MESH_CHUNK_MAGIC_VB32)
+				{
+					gfx::read(&_reader, numVertices);
+				}
+				else
+				{
+					std::uint16_t numVertices16;
+					gfx::read(&_reader, numVertices16);
+					numVertices = numVertices16;
+				}
+				buffers.first = view(numVertices*stride);
 				
-				data->aabb.fromPoints(buffers.first.data(), numVertices, stride, false);
+				// cooked meshes store their bounds
+				if (!data->hasBounds)
+					data->aabb.fromPoints(buffers.first.data, buffers.first.size / stride, stride, false);
+			}
+			break;
+
+			case MESH_CHUNK_MAGIC_BOUNDS:
+			{
+				gfx::read(&_reader, &data->aabb.min, sizeof(float) * 3);
+				gfx::read(&_reader, &data->aabb.max, sizeof(float) * 3);
+				data->hasBounds = true;
+			}
+			break;
+
+			case MESH_CHUNK_MAGIC_LOD:
+			{
+				std::uint8_t lods;
+				gfx::read(&_reader, lods);
+				data->lods = lods;
 			}
 			break;
 
@@ -281,8 +650,16 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 			{
 				std::uint32_t numIndices;
 				gfx::read(&_reader, numIndices);
-				buffers.second.resize(numIndices * 2);
-				gfx::read(&_reader, (std::uint8_t*)buffers.second.data(), (std::uint32_t)buffers.second.size());
+				buffers.second = view(numIndices * 2);
+			}
+			break;
+
+			case MESH_CHUNK_MAGIC_IB32:
+			{
+				std::uint32_t numIndices;
+				gfx::read(&_reader, numIndices);
+				buffers.second = view(numIndices * 4);
+				buffers.second.indexSize = 4;
 			}
 			break;
 
@@ -294,12 +671,12 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 				std::uint32_t compressedSize;
 				gfx::read(&_reader, compressedSize);
 
-				std::vector<uint8_t> compressedIndices(compressedSize);
-				gfx::read(&_reader, &compressedIndices[0], compressedSize);
+				const auto compressed = view(compressedSize);
 
-				buffers.second.resize(numIndices * 2);
-				ReadBitstream rbs(compressedIndices.data(), compressedSize);
-				DecompressIndexBuffer((uint16_t*)buffers.second.data(), numIndices / 3, rbs);
+				buffers.second = MeshBuffer();
+				buffers.second.memory.resize(numIndices * 2);
+				ReadBitstream rbs(compressed.data, compressed.size);
+				DecompressIndexBuffer((uint16_t*)buffers.second.memory.data(), numIndices / 3, rbs);
 			}
 			break;
 
@@ -335,10 +712,57 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 					data->info.primitives += subset.m_numIndices / 3;
 				}
 
+				// decoded index buffers live in memory, the rest in the file
+				if (!buffers.second.memory.empty())
+				{
+					buffers.second.data = buffers.second.memory.data();
+					buffers.second.size = static_cast<std::uint32_t>(buffers.second.memory.size());
+				}
+
+				// keep a cpu copy of small occluder meshes for the occlusion buffer
+				const auto indexSize = buffers.second.indexSize;
+				const auto numIndices = buffers.second.size / indexSize;
+				if (!data->occluderRejected && (data->occluderIndices.size() + numIndices) / 3 <= MaxOccluderTriangles)
+				{
+					const std::uint32_t stride = data->decl.getStride();
+					const auto base = static_cast<std::uint32_t>(data->occluderVertices.size());
+					const auto numVertices = buffers.first.size / stride;
+					for (std::uint32_t v = 0; v < numVertices; ++v)
+					{
+						// views into the file are not aligned
+						math::vec3 position;
+						std::memcpy(&position, buffers.first.data + v * stride, sizeof(position));
+						data->occluderVertices.push_back(position);
+					}
+
+					for (std::uint32_t i = 0; i < numIndices; ++i)
+					{
+						std::uint32_t index = 0;
+						if (indexSize == 4)
+						{
+							std::memcpy(&index, buffers.second.data + i * 4, sizeof(index));
+						}
+						else
+						{
+							std::uint16_t index16;
+							std::memcpy(&index16, buffers.second.data + i * 2, sizeof(index16));
+							index = index16;
+						}
+						data->occluderIndices.push_back(base + index);
+					}
+				}
+				else
+				{
+					data->occluderVertices.clear();
+					data->occluderVertices.shrink_to_fit();
+					data->occluderIndices.clear();
+					data->occluderIndices.shrink_to_fit();
+					data->occluderRejected = true;
+				}
+
 				data->groups.emplace_back(group);
-				data->buffersMem.emplace_back(buffers);
-				buffers.first.clear();
-				buffers.second.clear();
+				data->buffersMem.emplace_back(std::move(buffers));
+				buffers = std::pair<MeshBuffer, MeshBuffer>();
 			}
 			break;
 
@@ -363,19 +787,22 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 		mesh->groups = data->groups;
 		mesh->aabb = data->aabb;
 		mesh->info = data->info;
+		mesh->lods = data->lods;
+		mesh->occluderVertices = std::move(data->occluderVertices);
+		mesh->occluderIndices = std::move(data->occluderIndices);
 		for (std::size_t i = 0; i < mesh->groups.size(); ++i)
 		{
 			auto& group = mesh->groups[i];
 			auto& buffers = data->buffersMem[i];
-			const gfx::Memory* memVB = gfx::copy(buffers.first.data(), static_cast<std::uint32_t>(buffers.first.size()));
-			buffers.first.clear();
+			const gfx::Memory* memVB = data->file.makeRef(buffers.first.data, buffers.first.size);
 			group.vertexBuffer = std::make_shared<VertexBuffer>();
 			group.vertexBuffer->populate(memVB, data->decl);
 
-			const gfx::Memory* memIB = gfx::copy(buffers.second.data(), static_cast<std::uint32_t>(buffers.second.size()));
-			buffers.second.clear();
+			const gfx::Memory* memIB = buffers.second.memory.empty() ?
+				data->file.makeRef(buffers.second.data, buffers.second.size) :
+				gfx::copy(buffers.second.data, buffers.second.size);
 			group.indexBuffer = std::make_shared<IndexBuffer>();
-			group.indexBuffer->populate(memIB);
+			group.indexBuffer->populate(memIB, buffers.second.indexSize == 4 ? BGFX_BUFFER_INDEX32 : BGFX_BUFFER_NONE);
 
 		}
 		data.reset();
@@ -386,17 +813,22 @@ void AssetReader::loadMeshFromFile(const std::string& key, const fs::path& absol
 	if (async)
 	{
 		auto& application = Singleton<Application>::getInstance();
-		auto& threadPool = application.getThreadPool();
-		auto task = threadPool.enqueue_with_callback(
-			// load function
-			[readMemory]()
+		auto task = application.getAssetStreamer().enqueue(
+			// load function, returns the bytes held until the mesh is created
+			[readMemory, data]()
 		{
 			readMemory();
+			return std::uint64_t(data->file.size());
 		},
 			// callback to the issuer
 			[createResource]() mutable
 		{
 			createResource();
+		},
+			// dropped when nobody waits for it anymore
+			[&request]()
+		{
+			return request.isWanted();
 		});
 
 		request.setTask(task);
@@ -417,9 +849,11 @@ void AssetReader::loadMaterialFromFile(const std::string& key, const fs::path& a
 	auto hMaterial = std::make_shared<Material>();
 	auto matWrapper = std::make_shared<MatWrapper>();
 	matWrapper->hMaterial = hMaterial;
-	auto deserialize = [matWrapper, absoluteKey, request]() mutable
+	auto deserialize = [matWrapper, absoluteKey]() mutable
 	{
-		std::ifstream stream{ absoluteKey, std::ios::in | std::ios::binary };
+		FileMemory file;
+		file.read(absoluteKey);
+		std::istringstream stream(std::string(reinterpret_cast<const char*>(file.data()), file.size()));
 		cereal::IArchive_JSON ar(stream);
 
 		ar(
@@ -427,7 +861,7 @@ void AssetReader::loadMaterialFromFile(const std::string& key, const fs::path& a
 		);
 	};
 
-	auto createResource = [matWrapper, key, request]() mutable
+	auto createResource = [matWrapper, key, &request]() mutable
 	{
 		request.setData(key, matWrapper->hMaterial);
 		request.invokeCallbacks();
@@ -436,17 +870,22 @@ void AssetReader::loadMaterialFromFile(const std::string& key, const fs::path& a
 	if (async)
 	{
 		auto& application = Singleton<Application>::getInstance();
-		auto& threadPool = application.getThreadPool();
-		auto task = threadPool.enqueue_with_callback(
-			// load function
+		auto task = application.getAssetStreamer().enqueue(
+			// load function, the file is released once deserialized
 			[deserialize]() mutable
 		{
 			deserialize();
+			return std::uint64_t(0);
 		},
 			// callback to the issuer
 			[createResource]() mutable
 		{
 			createResource();
+		},
+			// dropped when nobody waits for it anymore
+			[&request]()
+		{
+			return request.isWanted();
 		});
 
 		request.setTask(task);
@@ -468,11 +907,12 @@ void AssetReader::loadPrefabFromFile(const std::string& key, const fs::path& abs
 		if (!read_memory)
 			return;
 
-		auto mem = fs::read_stream(std::fstream{ absoluteKey, std::fstream::in | std::fstream::out | std::ios::binary });
- 		*read_memory = std::istringstream(std::string(reinterpret_cast<const char*>(mem.data()), mem.size()));
+		FileMemory file;
+		file.read(absoluteKey);
+ 		*read_memory = std::istringstream(std::string(reinterpret_cast<const char*>(file.data()), file.size()));
 	};
 
-	auto createResource = [read_memory, key, request]() mutable
+	auto createResource = [read_memory, key, &request]() mutable
 	{
 		auto prefab = std::make_shared<Prefab>();
 		prefab->data = read_memory;
@@ -484,17 +924,22 @@ void AssetReader::loadPrefabFromFile(const std::string& key, const fs::path& abs
 	if (async)
 	{
 		auto& application = Singleton<Application>::getInstance();
-		auto& threadPool = application.getThreadPool();
-		auto task = threadPool.enqueue_with_callback(
-			// load function
-			[readMemory]() mutable
+		auto task = application.getAssetStreamer().enqueue(
+			// load function, returns the bytes held until the prefab is created
+			[readMemory, read_memory]() mutable
 		{
 			readMemory();
+			return std::uint64_t(read_memory->rdbuf()->in_avail());
 		},
 			// callback to the issuer
 			[createResource]() mutable
 		{
 			createResource();
+		},
+			// dropped when nobody waits for it anymore
+			[&request]()
+		{
+			return request.isWanted();
 		});
 
 		request.setTask(task);
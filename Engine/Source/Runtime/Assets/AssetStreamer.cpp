@@ -0,0 +1,215 @@
+#include "AssetStreamer.h"
+#include <algorithm>
+#include <chrono>
+
+bool StreamTask::isReady() const
+{
+	return mState >= State::Loaded;
+}
+
+bool StreamTask::isCancelled() const
+{
+	return mState == State::Cancelled;
+}
+
+void StreamTask::invokeCallback()
+{
+	if (mState != State::Loaded)
+		return;
+
+	mState = State::Created;
+	mStreamer->mInFlightBytes -= mBytes;
+
+	// release whatever the loader captured once the asset exists
+	auto create = std::move(mCreate);
+	mCreate = nullptr;
+	mIsWanted = nullptr;
+	create();
+}
+
+void StreamTask::waitUntilReady()
+{
+	JobHandle job;
+	if (mStreamer->takeQueued(*this, job))
+	{
+		mState = State::Loading;
+		load();
+	}
+	else if (job)
+	{
+		// the job may not be pushed yet, wait helps until a worker ran it
+		mStreamer->mThreadPool.wait(job);
+	}
+}
+
+void StreamTask::load()
+{
+	mBytes = mLoad();
+	mLoad = nullptr;
+	mStreamer->mInFlightBytes += mBytes;
+	mState = State::Loaded;
+}
+
+AssetStreamer::AssetStreamer(ThreadPool& threadPool)
+	: mThreadPool(threadPool)
+	, mMaxInFlightLoads(std::max<std::size_t>(threadPool.getWorkerCount(), 1))
+{
+}
+
+std::shared_ptr<StreamTask> AssetStreamer::enqueue(std::function<std::uint64_t()> load,
+	std::function<void()> create,
+	std::function<bool()> isWanted,
+	float priority)
+{
+	auto task = std::make_shared<StreamTask>();
+	task->mStreamer = this;
+	task->mLoad = std::move(load);
+	task->mCreate = std::move(create);
+	task->mIsWanted = std::move(isWanted);
+	task->mPriority = priority;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	task->mOrder = mOrder++;
+	mQueued.push_back(task);
+	return task;
+}
+
+void AssetStreamer::update()
+{
+	auto byPriority = [](const std::shared_ptr<StreamTask>& a, const std::shared_ptr<StreamTask>& b)
+	{
+		if (a->mPriority != b->mPriority)
+			return a->mPriority > b->mPriority;
+		return a->mOrder < b->mOrder;
+	};
+
+	std::vector<std::shared_ptr<StreamTask>> dispatching;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mLoaded.insert(mLoaded.end(), mFinished.begin(), mFinished.end());
+		mFinished.clear();
+
+		// loads nobody waits for anymore are dropped before touching the disk
+		mQueued.erase(std::remove_if(mQueued.begin(), mQueued.end(), [this](const std::shared_ptr<StreamTask>& task)
+		{
+			if (task->mIsWanted())
+				return false;
+
+			cancel(*task);
+			return true;
+		}), mQueued.end());
+
+		std::sort(mQueued.begin(), mQueued.end(), byPriority);
+
+		// a single load is always let through so a huge asset can not stall the queue
+		std::size_t count = 0;
+		while (count < mQueued.size())
+		{
+			const auto loading = mLoading + count;
+			if (loading > 0 && (loading >= mMaxInFlightLoads || mInFlightBytes >= mMaxInFlightBytes))
+				break;
+			++count;
+		}
+		dispatching.assign(mQueued.begin(), mQueued.begin() + count);
+		mQueued.erase(mQueued.begin(), mQueued.begin() + count);
+
+		// leaving the queue and getting a job is one step for waiters
+		for (auto& task : dispatching)
+			dispatch(task);
+	}
+
+	for (auto& task : dispatching)
+		mThreadPool.run(task->mJob);
+
+	// loads that were waited for were already created
+	mLoaded.erase(std::remove_if(mLoaded.begin(), mLoaded.end(), [this](const std::shared_ptr<StreamTask>& task)
+	{
+		if (task->mState != StreamTask::State::Loaded)
+			return true;
+		if (task->mIsWanted())
+			return false;
+
+		cancel(*task);
+		return true;
+	}), mLoaded.end());
+
+	std::sort(mLoaded.begin(), mLoaded.end(), byPriority);
+
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	std::size_t processed = 0;
+	for (; processed < mLoaded.size(); ++processed)
+	{
+		const auto elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+		if (processed > 0 && elapsed >= mCreateBudget)
+			break;
+
+		auto& task = mLoaded[processed];
+		if (task->claimCallback())
+			task->invokeCallback();
+	}
+	mLoaded.erase(mLoaded.begin(), mLoaded.begin() + processed);
+}
+
+AssetStreamer::Stats AssetStreamer::getStats() const
+{
+	Stats stats;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		stats.queued = mQueued.size();
+		stats.loaded = mLoaded.size() + mFinished.size();
+	}
+	stats.loading = mLoading;
+	stats.inFlightBytes = mInFlightBytes;
+	stats.cancelled = mCancelled;
+	return stats;
+}
+
+void AssetStreamer::dispatch(const std::shared_ptr<StreamTask>& task)
+{
+	task->mState = StreamTask::State::Loading;
+	++mLoading;
+	task->mJob = mThreadPool.createBackgroundJob([this, task]()
+	{
+		task->load();
+		onLoaded(task);
+	});
+}
+
+void AssetStreamer::cancel(StreamTask& task)
+{
+	if (task.mState == StreamTask::State::Loaded)
+		mInFlightBytes -= task.mBytes;
+
+	task.mState = StreamTask::State::Cancelled;
+	task.mLoad = nullptr;
+	task.mCreate = nullptr;
+	task.mIsWanted = nullptr;
+	++mCancelled;
+}
+
+bool AssetStreamer::takeQueued(StreamTask& task, JobHandle& job)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = std::find_if(mQueued.begin(), mQueued.end(), [&task](const std::shared_ptr<StreamTask>& queued)
+	{
+		return queued.get() == &task;
+	});
+	if (it == mQueued.end())
+	{
+		job = task.mJob;
+		return false;
+	}
+
+	mQueued.erase(it);
+	return true;
+}
+
+void AssetStreamer::onLoaded(const std::shared_ptr<StreamTask>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mFinished.push_back(task);
+	}
+	--mLoading;
+}
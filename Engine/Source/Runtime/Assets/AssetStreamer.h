@@ -0,0 +1,290 @@
+#pragma once
+
+#include "../Threading/ThreadPool.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+class AssetStreamer;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : StreamTask (Class)
+/// <summary>
+/// An asset load scheduled by the AssetStreamer. The load function runs on a
+/// worker once the streamer dispatches it, the create function runs on the
+/// main thread within the per frame budget of the streamer.
+/// </summary>
+//-----------------------------------------------------------------------------
+class StreamTask : public ITask
+{
+public:
+	enum class State
+	{
+		Queued,
+		Loading,
+		Loaded,
+		Created,
+		Cancelled,
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : isReady (virtual )
+	/// <summary>
+	/// True once the data is loaded and the callback can be invoked, or the
+	/// load was cancelled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isReady() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : invokeCallback (virtual )
+	/// <summary>
+	/// Runs the create function. Does nothing for cancelled loads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void invokeCallback();
+
+	//-----------------------------------------------------------------------------
+	//  Name : waitUntilReady (virtual )
+	/// <summary>
+	/// Loads a queued task on the calling thread, or helps the pool until a
+	/// dispatched one is loaded.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void waitUntilReady();
+
+	//-----------------------------------------------------------------------------
+	//  Name : isCancelled (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isCancelled() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : setPriority ()
+	/// <summary>
+	/// Higher priorities are loaded and created first. Can be changed every
+	/// frame, it only has an effect until the load is created.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setPriority(float priority) { mPriority = priority; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getPriority ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	float getPriority() const { return mPriority; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getState ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	State getState() const { return mState; }
+
+private:
+	friend class AssetStreamer;
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Runs the load function and hands the task back to the streamer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void load();
+
+	/// Owning streamer
+	AssetStreamer* mStreamer = nullptr;
+	/// Reads the asset, returns the bytes held until it is created
+	std::function<std::uint64_t()> mLoad;
+	/// Creates the asset on the main thread
+	std::function<void()> mCreate;
+	/// Whether anyone still waits for the asset
+	std::function<bool()> mIsWanted;
+	/// Scheduling priority, higher first
+	float mPriority = 0.0f;
+	/// Order of enqueueing, keeps equal priorities first in first out
+	std::uint64_t mOrder = 0;
+	/// Bytes held between load and create
+	std::uint64_t mBytes = 0;
+	/// Current state
+	std::atomic<State> mState{ State::Queued };
+	/// Job running the load function, set under the streamer mutex
+	JobHandle mJob;
+};
+
+//-----------------------------------------------------------------------------
+//  Name : AssetStreamer (Class)
+/// <summary>
+/// Schedules asynchronous asset loads. Queued loads are dispatched to the
+/// thread pool by priority while the number of loads in flight and the
+/// bytes loaded but not yet created stay under their caps. Loaded assets
+/// are created on the main thread within a time budget per frame so a burst
+/// of finished loads does not upload everything in one frame. Loads nobody
+/// waits for anymore are cancelled.
+/// </summary>
+//-----------------------------------------------------------------------------
+class AssetStreamer
+{
+public:
+	struct Stats
+	{
+		/// Loads waiting to be dispatched
+		std::size_t queued = 0;
+		/// Loads running on the workers
+		std::size_t loading = 0;
+		/// Loads waiting to be created
+		std::size_t loaded = 0;
+		/// Bytes loaded but not yet created
+		std::uint64_t inFlightBytes = 0;
+		/// Loads cancelled since startup
+		std::size_t cancelled = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : AssetStreamer ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	AssetStreamer(ThreadPool& threadPool);
+
+	//-----------------------------------------------------------------------------
+	//  Name : enqueue ()
+	/// <summary>
+	/// Queues a load. The load function runs on a worker and returns the
+	/// bytes it keeps until the create function ran on the main thread.
+	/// isWanted is checked on the main thread before the load is dispatched
+	/// and before it is created. Can be called from any thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<StreamTask> enqueue(std::function<std::uint64_t()> load,
+		std::function<void()> create,
+		std::function<bool()> isWanted,
+		float priority = 0.0f);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Called once per frame on the main thread. Cancels unwanted loads,
+	/// dispatches queued ones and creates loaded ones within the budget.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update();
+
+	//-----------------------------------------------------------------------------
+	//  Name : setMaxInFlightLoads ()
+	/// <summary>
+	/// Maximum number of loads running on the workers at once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setMaxInFlightLoads(std::size_t count) { mMaxInFlightLoads = count; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : setMaxInFlightBytes ()
+	/// <summary>
+	/// No new load is dispatched while the bytes loaded but not yet created
+	/// are over this cap. One load is always allowed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setMaxInFlightBytes(std::uint64_t bytes) { mMaxInFlightBytes = bytes; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : setCreateBudget ()
+	/// <summary>
+	/// Time in milliseconds spent creating loaded assets per frame. At least
+	/// one asset is created each frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setCreateBudget(double milliseconds) { mCreateBudget = milliseconds; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getStats ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Stats getStats() const;
+
+private:
+	friend class StreamTask;
+
+	//-----------------------------------------------------------------------------
+	//  Name : dispatch ()
+	/// <summary>
+	/// Creates the job of a task taken from the queue. Called with mMutex
+	/// held, the job is run once the lock is released.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void dispatch(const std::shared_ptr<StreamTask>& task);
+
+	//-----------------------------------------------------------------------------
+	//  Name : cancel ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cancel(StreamTask& task);
+
+	//-----------------------------------------------------------------------------
+	//  Name : takeQueued ()
+	/// <summary>
+	/// Removes a task from the queue. Returns false if it was not queued,
+	/// job is then set to the job of a dispatched task.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool takeQueued(StreamTask& task, JobHandle& job);
+
+	//-----------------------------------------------------------------------------
+	//  Name : onLoaded ()
+	/// <summary>
+	/// Called by the task once its load function returned.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void onLoaded(const std::shared_ptr<StreamTask>& task);
+
+	/// Pool running the loads
+	ThreadPool& mThreadPool;
+	/// Loads waiting to be dispatched
+	std::vector<std::shared_ptr<StreamTask>> mQueued;
+	/// Loads finished since the last update
+	std::vector<std::shared_ptr<StreamTask>> mFinished;
+	/// Loads waiting to be created, main thread only
+	std::vector<std::shared_ptr<StreamTask>> mLoaded;
+	/// Guards mQueued, mFinished and the jobs of dispatched tasks
+	mutable std::mutex mMutex;
+	/// Counter for the enqueue order
+	std::uint64_t mOrder = 0;
+	/// Loads running on the workers
+	std::atomic<std::size_t> mLoading{ 0 };
+	/// Bytes loaded but not yet created
+	std::atomic<std::uint64_t> mInFlightBytes{ 0 };
+	/// Loads cancelled since startup
+	std::size_t mCancelled = 0;
+	/// Caps
+	std::size_t mMaxInFlightLoads;
+	std::uint64_t mMaxInFlightBytes = 64 * 1024 * 1024;
+	double mCreateBudget = 4.0;
+};
@@ -1,11 +1,13 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <cstdint>
 
 #include "Core/events/event.hpp"
 #include "AssetHandle.h"
 #include "../System/Application.h"
 #include "../Threading/ThreadPool.h"
+#include "AssetStreamer.h"
 
 template<typename T>
 struct LoadRequest
@@ -23,7 +25,10 @@ struct LoadRequest
 		if (isReady())
 			callback(asset);
 		else
+		{
 			callbacks.addListener(callback);
+			listeners++;
+		}
 	}
 
 	//-----------------------------------------------------------------------------
@@ -58,6 +63,53 @@ struct LoadRequest
 		}
 	}
 
+	//-----------------------------------------------------------------------------
+	//  Name : isWanted ()
+	/// <summary>
+	/// True while someone outside the asset manager holds the asset or waits
+	/// for it. Streamed loads nobody wants are cancelled.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isWanted() const
+	{
+		return asset.use_count() > 1 || listeners > 0;
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : isCancelled ()
+	/// <summary>
+	/// True if the streamed load was dropped and has to be dispatched again.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isCancelled() const
+	{
+		return loadTask && loadTask->isCancelled() && !isReady();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : isLoading ()
+	/// <summary>
+	/// True while a dispatched load has not invoked its callback yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isLoading() const
+	{
+		return loadTask && !loadTask->callbackClaimed && !loadTask->isCancelled();
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : setPriority ()
+	/// <summary>
+	/// Changes the priority of a streamed load that was not created yet.
+	/// Higher priorities are loaded and created first.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setPriority(float priority)
+	{
+		if (auto task = std::dynamic_pointer_cast<StreamTask>(loadTask))
+			task->setPriority(priority);
+	}
+
 	//-----------------------------------------------------------------------------
 	//  Name : setTask ()
 	/// <summary>
@@ -83,6 +135,11 @@ struct LoadRequest
 	{
 		asset.link->id = id;
 		asset.link->asset = data;
+		// the new data is measured again by the storage
+		if (onSetData)
+			onSetData(*this);
+		else
+			measured = false;
 	}
 
 	//-----------------------------------------------------------------------------
@@ -97,6 +154,7 @@ struct LoadRequest
 	{
 		callbacks(asset);
 		callbacks = {};
+		listeners = 0;
 	}
 
 	/// Requested asset
@@ -105,4 +163,15 @@ struct LoadRequest
 	std::shared_ptr<ITask> loadTask;
 	/// Subscribed callbacks
 	event<void(AssetHandle<T>)> callbacks;
+	/// Number of callbacks waiting for the load
+	std::uint32_t listeners = 0;
+	/// Last frame the asset was requested or referenced
+	std::uint32_t lastUsedFrame = 0;
+	/// Measured memory of the asset
+	std::uint64_t cpuBytes = 0;
+	std::uint64_t gpuBytes = 0;
+	/// Were the sizes measured for the current data
+	bool measured = false;
+	/// Called by setData, lets the storage measure the new data
+	delegate<void(LoadRequest<T>&)> onSetData;
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "TextureStreamer.h"
+#include "AssetManager.h"
+#include "../Rendering/Texture.h"
+#include "Core/common/string_utils.h"
+#include <algorithm>
+
+void TextureStreamer::setStreamed(const std::string& key)
+{
+	mStreamed.insert(string_utils::toLower(key));
+}
+
+bool TextureStreamer::isStreamed(const std::string& key) const
+{
+	return mStreamed.find(string_utils::toLower(key)) != mStreamed.end();
+}
+
+void TextureStreamer::update(AssetManager& manager, std::uint32_t frame)
+{
+	Stats stats;
+	stats.upgrades = mStats.upgrades;
+	stats.downgrades = mStats.downgrades;
+
+	auto storage = manager.getStorage<Texture>();
+	if (!storage)
+		return;
+
+	mReloads.clear();
+	for (auto& pair : storage->container)
+	{
+		auto& request = pair.second;
+		if (!request.isReady())
+			continue;
+
+		auto& texture = *request.asset.get();
+		auto& streaming = texture.streaming;
+		if (!streaming.enabled)
+			continue;
+
+		stats.textures++;
+		stats.residentBytes += texture.info.storageSize;
+		stats.fullBytes += streaming.fullSize;
+		if (streaming.skippedMips >= streaming.tailMips)
+			stats.tails++;
+		if (request.isLoading())
+		{
+			stats.loading++;
+			continue;
+		}
+
+		// the reload did not replace the texture, retry later or give up
+		if (streaming.reloading)
+		{
+			streaming.reloading = false;
+			streaming.failures++;
+			streaming.retryFrame = frame + (mRetryDelay << std::min<std::uint8_t>(streaming.failures - 1, 8));
+		}
+		if (streaming.failures >= mMaxFailures || frame < streaming.retryFrame)
+			continue;
+
+		// textures that were not drawn last frame fall back to their tail
+		const bool drawn = frame - streaming.requestedFrame <= 1;
+		const auto wanted = drawn ? std::min(streaming.requestedMips, streaming.tailMips) : streaming.tailMips;
+		if (wanted < streaming.skippedMips)
+		{
+			streaming.targetMips = wanted;
+			streaming.reloading = true;
+			mReloads.emplace_back(pair.first, streaming.requestedTexels);
+			stats.upgrades++;
+		}
+		else if (wanted > streaming.skippedMips && frame - streaming.neededFrame > mDropDelay)
+		{
+			streaming.targetMips = wanted;
+			streaming.reloading = true;
+			// dropping mips frees memory but is never urgent
+			mReloads.emplace_back(pair.first, -1.0f);
+			stats.downgrades++;
+		}
+	}
+
+	// the largest textures on screen are loaded first
+	for (const auto& reload : mReloads)
+	{
+		manager.load<Texture>(reload.first, true, true);
+		manager.setPriority<Texture>(reload.first, reload.second);
+	}
+	mReloads.clear();
+
+	mStats = stats;
+}
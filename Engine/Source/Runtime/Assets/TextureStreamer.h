@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+class AssetManager;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : TextureStreamer (Class)
+/// <summary>
+/// Keeps only the mips of a texture resident that the renderer needs. Only
+/// textures marked as streamed are affected, those referenced by materials.
+/// They are first loaded with their low resolution tail, the renderer reports
+/// the size they span on screen and the streamer loads the top mips in, or
+/// drops them again once they were not needed for a while. Every other
+/// texture is loaded with all its mips. A texture is
+/// replaced as a whole through the asset streamer, so residency changes show
+/// up in the asset residency of the manager.
+/// </summary>
+//-----------------------------------------------------------------------------
+class TextureStreamer
+{
+public:
+	struct Stats
+	{
+		/// Textures with streamed mips
+		std::size_t textures = 0;
+		/// Textures with only their tail resident
+		std::size_t tails = 0;
+		/// Textures waiting for new mips
+		std::size_t loading = 0;
+		/// Video memory of the resident mips
+		std::uint64_t residentBytes = 0;
+		/// Video memory with every mip resident
+		std::uint64_t fullBytes = 0;
+		/// Mip loads issued since startup
+		std::size_t upgrades = 0;
+		std::size_t downgrades = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : setTailSize ()
+	/// <summary>
+	/// Largest side of the mips loaded initially and always kept resident.
+	/// 0 disables streaming, textures are then loaded with all mips.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setTailSize(std::uint32_t size) { mTailSize = size; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getTailSize ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t getTailSize() const { return mTailSize; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : setDropDelay ()
+	/// <summary>
+	/// Frames a top mip stays resident after it was last needed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setDropDelay(std::uint32_t frames) { mDropDelay = frames; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : setStreamed ()
+	/// <summary>
+	/// Marks the texture as streamed. Must be called before the texture is
+	/// first loaded, from the main thread.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setStreamed(const std::string& key);
+
+	//-----------------------------------------------------------------------------
+	//  Name : isStreamed ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isStreamed(const std::string& key) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Called once per frame after rendering. Compares the mips requested
+	/// by the renderer with the resident ones and reloads textures whose
+	/// mips have to change.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update(AssetManager& manager, std::uint32_t frame);
+
+	//-----------------------------------------------------------------------------
+	//  Name : getStats ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const Stats& getStats() const { return mStats; }
+
+private:
+	/// Largest side of the initially loaded mips
+	std::uint32_t mTailSize = 256;
+	/// Frames before unneeded top mips are dropped
+	std::uint32_t mDropDelay = 300;
+	/// Frames before the first retry of a failed reload, doubled per failure
+	std::uint32_t mRetryDelay = 30;
+	/// Failed reloads in a row before a texture keeps its mips for good
+	std::uint8_t mMaxFailures = 5;
+	/// Lower case keys of the streamed textures
+	std::unordered_set<std::string> mStreamed;
+	/// Stats of the last update
+	Stats mStats;
+	/// Reloads issued by the last update
+	std::vector<std::pair<std::string, float>> mReloads;
+};
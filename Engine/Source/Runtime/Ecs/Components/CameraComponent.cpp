@@ -1,13 +1,18 @@
 #include "CameraComponent.h"
 #include "../../Rendering/Camera.h"
 #include "../../Rendering/RenderPass.h"
+#include "../Utils.h"
 
 CameraComponent::CameraComponent()
 {
 	mCamera = std::make_unique<Camera>();
 	mGBuffer = std::make_shared<FrameBuffer>();
 	mOutputBuffer = std::make_shared<FrameBuffer>();
-	init({ 0, 0 });
+	// the render targets are created on the main thread when deserialized on a worker
+	ecs::utils::runOnMainThread([this]()
+	{
+		init({ 0, 0 });
+	});
 }
 
 CameraComponent::CameraComponent(const CameraComponent& cameraComponent)
@@ -16,7 +21,11 @@ CameraComponent::CameraComponent(const CameraComponent& cameraComponent)
 	mHDR = cameraComponent.mHDR;
 	mGBuffer = std::make_shared<FrameBuffer>();
 	mOutputBuffer = std::make_shared<FrameBuffer>();
-	init({ 0, 0 });
+	// prefab instances may be copied on a worker
+	ecs::utils::runOnMainThread([this]()
+	{
+		init({ 0, 0 });
+	});
 }
 
 void CameraComponent::init(const uSize& size)
@@ -1,4 +1,7 @@
 #include "ModelComponent.h"
+#include "../../Rendering/Mesh.h"
+#include "../../Assets/AssetManager.h"
+#include "../../System/Application.h"
 
 ModelComponent::ModelComponent()
 {
@@ -10,6 +13,7 @@ ModelComponent::ModelComponent(const ModelComponent& component)
 	, mStatic(component.mStatic)
 	, mCastShadow(component.mCastShadow)
 	, mCastReflection(component.mCastReflection)
+	, mOccluder(component.mOccluder)
 {
 }
 
@@ -39,6 +43,19 @@ ModelComponent& ModelComponent::setStatic(bool bStatic)
 	return *this;
 }
 
+ModelComponent& ModelComponent::setOccluder(bool occluder)
+{
+	if (mOccluder == occluder)
+		return *this;
+
+	static const std::string strContext = "Occluder";
+	touch(strContext);
+	mOccluder = occluder;
+	if (mOccluder)
+		markOccluderMeshes();
+	return *this;
+}
+
 ModelComponent& ModelComponent::setCastReflelction(bool castReflection)
 {
 	if (mCastReflection == castReflection)
@@ -60,6 +77,11 @@ bool ModelComponent::isStatic() const
 	return mStatic;
 }
 
+bool ModelComponent::isOccluder() const
+{
+	return mOccluder;
+}
+
 const Model& ModelComponent::getModel() const
 {
 	return mModel;
@@ -68,12 +90,32 @@ const Model& ModelComponent::getModel() const
 ModelComponent& ModelComponent::setModel(const Model& model)
 {
 	mModel = model;
+	if (mOccluder)
+		markOccluderMeshes();
 
 	static const std::string strContext = "ModelChange";
 	touch(strContext);
+	// the bounds of the entity may have changed
+	if (mEntity)
+		mEntity.changed<ModelComponent>();
 	return *this;
 }
 
+void ModelComponent::markOccluderMeshes()
+{
+	auto& manager = Singleton<Application>::getInstance().getAssetManager();
+	for (const auto& lod : mModel.getLods())
+	{
+		if (lod.id().empty() || manager.isOccluderMesh(lod.id()))
+			continue;
+
+		// lods loaded before have no triangles on the cpu, they are reloaded
+		manager.setOccluderMesh(lod.id());
+		if (lod && lod->occluderIndices.empty())
+			manager.load<Mesh>(lod.id(), true, true);
+	}
+}
+
 bool ModelComponent::castsReflection() const
 {
 	return mCastReflection;
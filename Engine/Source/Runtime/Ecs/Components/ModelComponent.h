@@ -18,7 +18,7 @@ class Material;
 class ModelComponent : public Component
 {
 	COMPONENT(ModelComponent)
-	SERIALIZABLE(ModelComponent)
+	SERIALIZABLE_VERSIONED(ModelComponent)
 	REFLECTABLE(ModelComponent, Component)
 
 public:
@@ -38,15 +38,26 @@ public:
 	ModelComponent& setCastShadow(bool castShadow);
 	ModelComponent& setCastReflelction(bool castReflection);
 	ModelComponent& setStatic(bool bStatic);
+	ModelComponent& setOccluder(bool occluder);
 
 	bool castsShadow() const;
 	bool castsReflection() const;
 	bool isStatic() const;
+	bool isOccluder() const;
 
 	const Model& getModel() const;
 	ModelComponent& setModel(const Model& model);
 
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : markOccluderMeshes ()
+	/// <summary>
+	/// Lets the lod meshes of the model keep their triangles on the cpu for
+	/// the occlusion buffer, reloading the ones already loaded without them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void markOccluderMeshes();
+
 	//-------------------------------------------------------------------------
 	// Private Member Variables.
 	//-------------------------------------------------------------------------
@@ -54,5 +65,6 @@ private:
 	bool mStatic = true;
 	bool mCastShadow = true;
 	bool mCastReflection = true;
+	bool mOccluder = false;
 	Model mModel;
 };
@@ -2,8 +2,27 @@
 #include "Core/logging/logging.h"
 #include "../../System/Application.h"
 #include "../World.h"
+#include "Core/math/mathfu/vectorial/simd4x4f.h"
 #include <algorithm>
 
+namespace
+{
+	void multiplyTransforms(const math::transform_t& lhs, const math::transform_t& rhs, math::transform_t& result)
+	{
+		// both glm and vectorial store the columns contiguously
+		simd4x4f a, b, out;
+		simd4x4f_uload(&a, lhs);
+		simd4x4f_uload(&b, rhs);
+		simd4x4f_matrix_mul(&a, &b, &out);
+
+		float* dst = result;
+		simd4f_ustore4(out.x, dst + 0);
+		simd4f_ustore4(out.y, dst + 4);
+		simd4f_ustore4(out.z, dst + 8);
+		simd4f_ustore4(out.w, dst + 12);
+	}
+}
+
 HTransformComponent createFromComponent(HTransformComponent component)
 {
 	if (!component.expired())
@@ -47,6 +66,8 @@ void TransformComponent::onEntitySet()
 	{
 		child.lock()->mParent = makeHandle();
 	}
+	// the parent in this manager may differ from the one it was computed with
+	mWorldDirty = true;
 }
 
 TransformComponent::~TransformComponent()
@@ -92,9 +113,10 @@ TransformComponent& TransformComponent::moveLocal(const math::vec3 & amount)
 
 TransformComponent& TransformComponent::setLocalPosition(const math::vec3 & position)
 {
-	// Set new cell relative position
-	mLocalTransform.setPosition(position);
-	setLocalTransform(mLocalTransform);
+	// Set new cell relative position on a copy so the change is detected
+	math::transform_t m = mLocalTransform;
+	m.setPosition(position);
+	setLocalTransform(m);
 	return *this;
 }
 
@@ -245,8 +267,9 @@ TransformComponent& TransformComponent::rotateLocal(float x, float y, float z)
 	if (!x && !y && !z)
 		return *this;
 
-	mLocalTransform.rotateLocal(math::radians(x), math::radians(y), math::radians(z));
-	setLocalTransform(mLocalTransform);
+	math::transform_t m = mLocalTransform;
+	m.rotateLocal(math::radians(x), math::radians(y), math::radians(z));
+	setLocalTransform(m);
 	return *this;
 }
 
@@ -388,8 +411,9 @@ TransformComponent& TransformComponent::setLocalScale(const math::vec3 & scale)
 	// Do nothing if scaling is disallowed.
 	if (!canScale())
 		return *this;
-	mLocalTransform.setScale(scale);
-	setLocalTransform(mLocalTransform);
+	math::transform_t m = mLocalTransform;
+	m.setScale(scale);
+	setLocalTransform(m);
 	return *this;
 }
 
@@ -420,8 +444,9 @@ TransformComponent& TransformComponent::setLocalRotation(const math::quat & rota
 		return *this;
 
 	// Set orientation of new math::transform_t
-	mLocalTransform.setRotation(rotation);
-	setLocalTransform(mLocalTransform);
+	math::transform_t m = mLocalTransform;
+	m.setRotation(rotation);
+	setLocalTransform(m);
 
 	return *this;
 }
@@ -533,6 +558,10 @@ TransformComponent& TransformComponent::setParent(HTransformComponent parent, bo
 		shParent->attachChild(makeHandle());
 	}
 
+	mWorldDirty = true;
+	// only the systems of the owning manager flatten its hierarchy again
+	if (mEntity)
+		mEntity.changed<TransformComponent>();
 
 	if (worldPositionStays)
 	{
@@ -598,6 +627,7 @@ TransformComponent& TransformComponent::setLocalTransform(const math::transform_
 
 	static const std::string strContext = "LocalTransform";
 	touch(strContext);
+	mWorldDirty = true;
 	mLocalTransform = trans;
 	return *this;
 }
@@ -608,29 +638,47 @@ void TransformComponent::resolveTransform(bool force, float dt)
 
 	if (force || dirty)
 	{
-		if (!mParent.expired())
+		auto parent = mParent.lock();
+		if (parent)
+			parent->resolveTransform();
+
+		computeWorldTransform(parent.get(), dt);
+	}
+
+	mDirty = false;
+}
+
+void TransformComponent::updateWorldTransform(const TransformComponent* parent, float dt)
+{
+	computeWorldTransform(parent, dt);
+
+	mDirty = false;
+	mWorldDirty = false;
+}
+
+void TransformComponent::computeWorldTransform(const TransformComponent* parent, float dt)
+{
+	if (parent)
+	{
+		math::transform_t target;
+		multiplyTransforms(parent->mWorldTransform, mLocalTransform, target);
+
+		if (mSlowParenting)
 		{
-			auto target = mParent.lock()->getTransform() * mLocalTransform;
-
-			if (mSlowParenting)
-			{
-				float t = math::clamp(mSlowParentingSpeed * dt, 0.0f, 1.0f);
-				mWorldTransform.setPosition(math::lerp(mWorldTransform.getPosition(), target.getPosition(), t));
-				mWorldTransform.setScale(math::lerp(mWorldTransform.getScale(), target.getScale(), t));
-				mWorldTransform.setRotation(math::slerp(mWorldTransform.getRotation(), target.getRotation(), t));
-			}
-			else
-			{
-				mWorldTransform = target;
-			}
+			float t = math::clamp(mSlowParentingSpeed * dt, 0.0f, 1.0f);
+			mWorldTransform.setPosition(math::lerp(mWorldTransform.getPosition(), target.getPosition(), t));
+			mWorldTransform.setScale(math::lerp(mWorldTransform.getScale(), target.getScale(), t));
+			mWorldTransform.setRotation(math::slerp(mWorldTransform.getRotation(), target.getRotation(), t));
 		}
 		else
 		{
-			mWorldTransform = mLocalTransform;
+			mWorldTransform = target;
 		}
 	}
-
-	mDirty = false;
+	else
+	{
+		mWorldTransform = mLocalTransform;
+	}
 }
 
 bool TransformComponent::isDirty() const
@@ -70,6 +70,25 @@ public:
 	//-----------------------------------------------------------------------------
 	void resolveTransform(bool force = false, float dt = 0.0f);
 
+	//-----------------------------------------------------------------------------
+	//  Name : updateWorldTransform ()
+	/// <summary>
+	/// Recomputes the world transformation from the already resolved world
+	/// transformation of the parent (nullptr for roots) and clears the dirty
+	/// state. Used by the TransformSystem hierarchy update.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void updateWorldTransform(const TransformComponent* parent, float dt);
+
+	//-----------------------------------------------------------------------------
+	//  Name : isWorldDirty ()
+	/// <summary>
+	/// Was the local transformation or the parent changed since the last
+	/// hierarchy update.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isWorldDirty() const { return mWorldDirty; }
+
 	//-----------------------------------------------------------------------------
 	//  Name : isDirty (virtual )
 	/// <summary>
@@ -585,6 +604,16 @@ public:
 	//-----------------------------------------------------------------------------
 	void setSlowParentingSpeed(float val) { mSlowParentingSpeed = val; }
 protected:
+	//-----------------------------------------------------------------------------
+	//  Name : computeWorldTransform ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void computeWorldTransform(const TransformComponent* parent, float dt);
+
 	//-------------------------------------------------------------------------
 	// Protected Member Variables
 	//-------------------------------------------------------------------------
@@ -600,4 +629,6 @@ protected:
 	bool mSlowParenting = false;
 	/// Slow parenting speed.
 	float mSlowParentingSpeed = 5.0f;
+	/// Does the hierarchy update need to recompute the world transformation.
+	bool mWorldDirty = true;
 };
\ No newline at end of file
@@ -1,18 +1,113 @@
 #include "Prefab.h"
 #include "Utils.h"
+#include "World.h"
+#include "Components/TransformComponent.h"
+#include "../System/Application.h"
+#include "../Threading/ThreadPool.h"
+#include <algorithm>
 
 Entity Prefab::instantiate()
 {
-	std::vector<Entity> outDataVec;
-	if (!data)
-		return Entity();
-		
-	if(!ecs::utils::deserializeData(*data, outDataVec))
+	auto instances = instantiate(1);
+	if (instances.empty())
 		return Entity();
 
-	if (outDataVec.empty())
-		return Entity();
+	return instances[0];
+}
+
+std::vector<Entity> Prefab::instantiate(std::size_t count, bool parallel)
+{
+	std::vector<Entity> instances;
+	if (count == 0 || !compile())
+		return instances;
+
+	auto& app = Singleton<Application>::getInstance();
+	auto& world = app.getWorld();
+	auto& pool = app.getThreadPool();
+	const std::size_t roots = mTemplates.size();
+	const std::size_t componentCount = mTemplateComponents.size();
+
+	// copying a transform with children creates the child entities in the
+	// world, which is only allowed from the main thread
+	std::vector<std::shared_ptr<Component>> clones(count * componentCount);
+	const std::size_t chunks = std::min(count, pool.getWorkerCount() + 1);
+	if (parallel && !mHasHierarchy && chunks > 1)
+	{
+		// render targets and asset loads of the copies are queued per chunk
+		std::vector<ecs::utils::DeferredTasks> deferred(chunks);
+		auto parent = pool.createJob([]() {});
+		for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+		{
+			const std::size_t begin = count * chunk / chunks * componentCount;
+			const std::size_t end = count * (chunk + 1) / chunks * componentCount;
+			auto tasks = &deferred[chunk];
+			pool.run(pool.createChildJob(parent, [this, &clones, componentCount, begin, end, tasks]()
+			{
+				auto previous = ecs::utils::setDeferredTasks(tasks);
+				for (std::size_t i = begin; i < end; ++i)
+					clones[i] = mTemplateComponents[i % componentCount]->clone();
+				ecs::utils::setDeferredTasks(previous);
+			}));
+		}
+		pool.run(parent);
+		pool.wait(parent);
+
+		for (auto& tasks : deferred)
+		{
+			for (auto& task : tasks)
+				task();
+		}
+	}
 	else
-		return outDataVec[0];
+	{
+		for (std::size_t i = 0; i < clones.size(); ++i)
+			clones[i] = mTemplateComponents[i % componentCount]->clone();
+	}
+
+	instances = world.entities.create(count * roots);
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		for (std::size_t r = 0; r < roots; ++r)
+		{
+			auto& entity = instances[i * roots + r];
+			entity.setName(mTemplates[r].getName());
+			for (std::size_t c = mTemplateOffsets[r]; c < mTemplateOffsets[r + 1]; ++c)
+				entity.assign(std::move(clones[i * componentCount + c]));
+		}
+	}
+
+	return instances;
+}
+
+bool Prefab::compile()
+{
+	if (!mTemplates.empty())
+		return true;
+
+	if (!data)
+		return false;
+
+	mTemplateEvents = std::make_unique<EventManager>();
+	mTemplateEntities = std::make_unique<EntityManager>(*mTemplateEvents);
+
+	std::vector<Entity> outDataVec;
+	if (!ecs::utils::deserializeData(*data, *mTemplateEntities, outDataVec) || outDataVec.empty())
+	{
+		mTemplateEntities.reset();
+		mTemplateEvents.reset();
+		return false;
+	}
+
+	mTemplates = outDataVec;
+	mTemplateOffsets.push_back(0);
+	for (const auto& entity : mTemplates)
+	{
+		const auto components = entity.all_components_shared();
+		mTemplateComponents.insert(mTemplateComponents.end(), components.begin(), components.end());
+		mTemplateOffsets.push_back(mTemplateComponents.size());
 
+		auto transform = entity.component<TransformComponent>().lock();
+		mHasHierarchy = mHasHierarchy || (transform && !transform->getChildren().empty());
+	}
+	return true;
 }
@@ -3,11 +3,54 @@
 #include "entityx/quick.h"
 #include <memory>
 #include <fstream>
+#include <vector>
 
 using namespace entityx;
 
 struct Prefab
 {
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates one instance of the prefab in the application's world and
+	/// returns its first top level entity.
+	/// </summary>
+	//-----------------------------------------------------------------------------
 	Entity instantiate();
+
+	//-----------------------------------------------------------------------------
+	//  Name : instantiate ()
+	/// <summary>
+	/// Creates count instances of the prefab in the application's world by
+	/// cloning the compiled template. When parallel is set the components
+	/// are copied on the thread pool, unless the template has a hierarchy.
+	/// Returns the top level entities of every instance, instance after
+	/// instance, in the order they were serialized.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::vector<Entity> instantiate(std::size_t count, bool parallel = false);
+
 	std::shared_ptr<std::istream> data;
+
+private:
+	//-----------------------------------------------------------------------------
+	//  Name : compile ()
+	/// <summary>
+	/// Deserializes the data once into the template entity manager.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool compile();
+
+	/// Events of the template entity manager, nobody listens to them
+	std::unique_ptr<EventManager> mTemplateEvents;
+	/// Holds the deserialized template entities
+	std::unique_ptr<EntityManager> mTemplateEntities;
+	/// The template top level entities
+	std::vector<Entity> mTemplates;
+	/// Components of the template top level entities, one after the other
+	std::vector<std::shared_ptr<Component>> mTemplateComponents;
+	/// Start of each top level entity in mTemplateComponents, plus the end
+	std::vector<std::size_t> mTemplateOffsets;
+	/// Cloning the template creates child entities
+	bool mHasHierarchy = false;
 };
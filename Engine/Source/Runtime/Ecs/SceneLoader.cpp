@@ -0,0 +1,141 @@
+#include "SceneLoader.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+SceneLoad::SceneLoad() : mStaging(mStagingEvents)
+{
+}
+
+void SceneLoad::cancel()
+{
+	// merging happens on the main thread like cancelling, only the worker
+	// finishing the load can race with it
+	auto state = mState.load();
+	while (state == State::Loading || state == State::Loaded || state == State::Merging)
+	{
+		if (mState.compare_exchange_weak(state, State::Cancelled))
+			return;
+	}
+}
+
+void SceneLoad::load(const fs::path& fullPath)
+{
+	std::ifstream stream(fullPath, std::fstream::binary);
+	const bool loaded = ecs::utils::deserializeData(stream, mStaging, mStagedEntities, &mTasks);
+
+	auto state = State::Loading;
+	mState.compare_exchange_strong(state, loaded ? State::Loaded : State::Failed);
+}
+
+bool SceneLoad::merge(EntityManager& target, double budget)
+{
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+	// at least one step is taken so a tiny budget still makes progress
+	bool progressed = false;
+	auto outOfTime = [start, budget, &progressed]()
+	{
+		return progressed && std::chrono::duration<double, std::milli>(clock::now() - start).count() >= budget;
+	};
+
+	if (mState == State::Loaded)
+	{
+		mState = State::Merging;
+		mRemap.resize(mStaging.capacity());
+	}
+
+	// asset loads and render targets of the staged components come first
+	for (; mTaskCursor < mTasks.size(); ++mTaskCursor)
+	{
+		if (outOfTime())
+			return false;
+
+		mTasks[mTaskCursor]();
+		progressed = true;
+	}
+
+	// entities keep their order, the staging entity manager has no free slots
+	const auto count = static_cast<std::uint32_t>(mStaging.capacity());
+	for (; mEntityCursor < count; ++mEntityCursor)
+	{
+		if (outOfTime())
+			return false;
+
+		const auto id = mStaging.create_id(mEntityCursor);
+		if (mStaging.valid(id))
+			mRemap[mEntityCursor] = target.adopt(mStaging, id);
+		progressed = true;
+	}
+
+	mEntities.reserve(mStagedEntities.size());
+	for (const auto& entity : mStagedEntities)
+		mEntities.push_back(mRemap[entity.id().index()]);
+
+	mStagedEntities.clear();
+	mRemap.clear();
+	mTasks.clear();
+	mState = State::Merged;
+	return true;
+}
+
+SceneLoader::SceneLoader(ThreadPool& threadPool, EntityManager& target)
+	: mThreadPool(threadPool)
+	, mTarget(target)
+{
+}
+
+SceneLoader::~SceneLoader()
+{
+	for (auto& load : mLoads)
+	{
+		load->cancel();
+		if (load->mJob)
+			mThreadPool.wait(load->mJob);
+	}
+}
+
+std::shared_ptr<SceneLoad> SceneLoader::load(const fs::path& fullPath, std::function<void(SceneLoad&)> callback)
+{
+	auto load = std::make_shared<SceneLoad>();
+	load->mCallback = std::move(callback);
+	load->mJob = mThreadPool.scheduleBackground([load, fullPath]()
+	{
+		load->load(fullPath);
+	});
+	mLoads.push_back(load);
+	return load;
+}
+
+void SceneLoader::update()
+{
+	using clock = std::chrono::steady_clock;
+	const auto start = clock::now();
+
+	// cancelled loads are dropped once their worker let go of them
+	mLoads.erase(std::remove_if(mLoads.begin(), mLoads.end(), [this](const std::shared_ptr<SceneLoad>& load)
+	{
+		return load->getState() == SceneLoad::State::Cancelled && mThreadPool.isFinished(load->mJob);
+	}), mLoads.end());
+
+	// scenes are merged in request order, a later scene waits for the earlier ones
+	while (!mLoads.empty())
+	{
+		auto load = mLoads.front();
+		const auto state = load->getState();
+		if (state == SceneLoad::State::Loading || state == SceneLoad::State::Cancelled)
+			break;
+
+		if (state != SceneLoad::State::Failed)
+		{
+			const auto elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+			if (!load->merge(mTarget, mMergeBudget - elapsed))
+				break;
+		}
+
+		mLoads.erase(mLoads.begin());
+		load->mJob.reset();
+		if (load->mCallback)
+			load->mCallback(*load);
+	}
+}
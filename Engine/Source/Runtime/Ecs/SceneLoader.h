@@ -0,0 +1,196 @@
+#pragma once
+
+#include "entityx/quick.h"
+#include "Utils.h"
+#include "../Threading/ThreadPool.h"
+#include "../System/FileSystem.h"
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+using namespace entityx;
+
+class SceneLoader;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : SceneLoad (Class)
+/// <summary>
+/// A scene loaded by the SceneLoader. The file is deserialized on a worker
+/// into a staging entity manager of its own, which is then merged into the
+/// target entity manager on the main thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+class SceneLoad
+{
+public:
+	enum class State
+	{
+		Loading,
+		Loaded,
+		Merging,
+		Merged,
+		Failed,
+		Cancelled,
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : SceneLoad ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	SceneLoad();
+
+	//-----------------------------------------------------------------------------
+	//  Name : cancel ()
+	/// <summary>
+	/// Drops the load. Entities of a scene that is being merged stay in the
+	/// target, the rest of the scene is not merged anymore.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void cancel();
+
+	//-----------------------------------------------------------------------------
+	//  Name : getState ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	State getState() const { return mState; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getEntities ()
+	/// <summary>
+	/// The top level entities of the scene in the target entity manager.
+	/// Empty until the load is merged.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const std::vector<Entity>& getEntities() const { return mEntities; }
+
+private:
+	friend class SceneLoader;
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Deserializes the file into the staging entity manager. Runs on a worker.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void load(const fs::path& fullPath);
+
+	//-----------------------------------------------------------------------------
+	//  Name : merge ()
+	/// <summary>
+	/// Runs the deferred tasks and moves the staged entities into the target
+	/// until the deadline passes. Returns true once everything is merged.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool merge(EntityManager& target, double budget);
+
+	/// Events of the staging entity manager, nobody listens to them
+	EventManager mStagingEvents;
+	/// Entities deserialized on the worker
+	EntityManager mStaging;
+	/// Top level entities in the staging entity manager
+	std::vector<Entity> mStagedEntities;
+	/// Main thread work queued by the deserialization
+	ecs::utils::DeferredTasks mTasks;
+	/// Deferred tasks already run
+	std::size_t mTaskCursor = 0;
+	/// Next staging entity index to merge
+	std::uint32_t mEntityCursor = 0;
+	/// Target entity for each staging entity index
+	std::vector<Entity> mRemap;
+	/// Top level entities in the target entity manager
+	std::vector<Entity> mEntities;
+	/// Called once merged or failed
+	std::function<void(SceneLoad&)> mCallback;
+	/// Job deserializing the file
+	JobHandle mJob;
+	/// Current state
+	std::atomic<State> mState{ State::Loading };
+};
+
+//-----------------------------------------------------------------------------
+//  Name : SceneLoader (Class)
+/// <summary>
+/// Loads scenes without stalling the main thread. Scenes are deserialized on
+/// the thread pool and merged into the target entity manager in the order
+/// they were requested, within a time budget per frame.
+/// </summary>
+//-----------------------------------------------------------------------------
+class SceneLoader
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : SceneLoader ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	SceneLoader(ThreadPool& threadPool, EntityManager& target);
+
+	//-----------------------------------------------------------------------------
+	//  Name : ~SceneLoader ()
+	/// <summary>
+	/// Waits for the loads still running on the workers.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	~SceneLoader();
+
+	//-----------------------------------------------------------------------------
+	//  Name : load ()
+	/// <summary>
+	/// Starts loading the scene file. The callback is invoked on the main
+	/// thread once the scene is merged or failed to load.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::shared_ptr<SceneLoad> load(const fs::path& fullPath, std::function<void(SceneLoad&)> callback = nullptr);
+
+	//-----------------------------------------------------------------------------
+	//  Name : update ()
+	/// <summary>
+	/// Called once per frame on the main thread. Merges the loaded scenes
+	/// within the budget.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void update();
+
+	//-----------------------------------------------------------------------------
+	//  Name : isLoading ()
+	/// <summary>
+	/// True while any scene is still being loaded or merged.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isLoading() const { return !mLoads.empty(); }
+
+	//-----------------------------------------------------------------------------
+	//  Name : setMergeBudget ()
+	/// <summary>
+	/// Time in milliseconds spent merging per frame. At least one entity or
+	/// deferred task is merged each frame.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setMergeBudget(double milliseconds) { mMergeBudget = milliseconds; }
+
+private:
+	/// Pool running the deserialization
+	ThreadPool& mThreadPool;
+	/// Entity manager the scenes are merged into
+	EntityManager& mTarget;
+	/// Loads in request order
+	std::vector<std::shared_ptr<SceneLoad>> mLoads;
+	/// Budget in milliseconds
+	double mMergeBudget = 4.0;
+};
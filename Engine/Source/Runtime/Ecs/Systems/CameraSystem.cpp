@@ -2,6 +2,12 @@
 #include "../Components/TransformComponent.h"
 #include "../Components/CameraComponent.h"
 
+CameraSystem::CameraSystem()
+{
+	reads<TransformComponent>();
+	writes<CameraComponent>();
+}
+
 void CameraSystem::frameBegin(ecs::EntityManager &entities, ecs::EventManager &events, ecs::TimeDelta dt)
 {
 
@@ -5,6 +5,14 @@
 class CameraSystem : public ecs::System<CameraSystem>
 {
 public:
+	//-----------------------------------------------------------------------------
+	//  Name : CameraSystem ()
+	/// <summary>
+	/// Declares the components accessed by the system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	CameraSystem();
+
 	//-----------------------------------------------------------------------------
 	//  Name : frameBegin (virtual )
 	/// <summary>
@@ -1,4 +1,5 @@
 #include "RenderingSystem.h"
+#include "SpatialSystem.h"
 #include "../Components/TransformComponent.h"
 #include "../Components/CameraComponent.h"
 #include "../Components/ModelComponent.h"
@@ -11,17 +12,28 @@
 #include "../../Rendering/Program.h"
 #include "../../Rendering/Texture.h"
 #include "../../Rendering/Material.h"
+#include "../../Threading/ThreadPool.h"
+#include "../../System/Application.h"
+#include "../../Assets/AssetManager.h"
+#include "../../System/Timer.h"
+#include "../World.h"
+#include <algorithm>
 
-void updateLodData(LodData& lodData, std::size_t totalLods, float minDist, float maxDist, float transTime, float distanceToCamera, float dt)
+// projection scale of a 60 degree vertical field of view, the lod distances
+// of a model are the distances its lods switch at with such a camera
+static const float LodReferenceScale = 1.7320508f;
+
+// candidates handed to one job of the lod stage
+static const std::size_t LodBatchSize = 256;
+
+void updateLodData(LodData& lodData, std::size_t totalLods, float minCoverage, float maxCoverage, float transTime, float coverage, float dt)
 {
-	if (totalLods == 1)
+	if (totalLods <= 1)
 		return;
 
 	totalLods -= 1;
-	if (totalLods < 0)
-		totalLods = 0;
 
-	const float factor = 1.0f - math::clamp((maxDist - distanceToCamera) / (maxDist - minDist), 0.0f, 1.0f);
+	const float factor = 1.0f - math::clamp((coverage - minCoverage) / (maxCoverage - minCoverage), 0.0f, 1.0f);
 	const int lod = (int)math::lerp(0.0f, static_cast<float>(totalLods), factor);
 	if (lodData.targetLodIndex != lod && lodData.targetLodIndex == lodData.currentLodIndex)
 		lodData.targetLodIndex = lod;
@@ -36,9 +48,31 @@ void updateLodData(LodData& lodData, std::size_t totalLods, float minDist, float
 	}
 }
 
+// the lod mesh without touching its reference count, falls back like Model::getLod
+static const Mesh* getLodMesh(const Model& model, std::uint32_t lod)
+{
+	const auto& lods = model.getLods();
+	if (lod < lods.size() && lods[lod])
+		return lods[lod].get();
+
+	return model.getLod(lod).get();
+}
+
+RenderingSystem::RenderingSystem()
+{
+	reads<TransformComponent, CameraComponent, ModelComponent>();
+	// submits to the renderer
+	main_thread_only();
+}
+
 void RenderingSystem::frameRender(EntityManager &entities, EventManager &events, TimeDelta dt)
 {
-	entities.each<CameraComponent>([this, &entities, dt](
+	auto& world = Singleton<Application>::getInstance().getWorld();
+	const auto spatial = world.systems.system<SpatialSystem>();
+
+	mOcclusionStats = OcclusionBuffer::Stats();
+
+	entities.each<CameraComponent>([this, &entities, &spatial, dt](
 		Entity ce,
 		CameraComponent& cameraComponent
 		)
@@ -49,104 +83,154 @@ void RenderingSystem::frameRender(EntityManager &entities, EventManager &events,
 		RenderPass pass("GBufferFill");
 		pass.bind(gBuffer.get());
 		pass.clear();
-		auto& cameraLods = mLodDataMap[ce];
+		auto& cameraLods = mCameraLods[ce];
+		if (cameraLods.states.size() < entities.capacity())
+		{
+			cameraLods.states.resize(entities.capacity());
+			cameraLods.owners.resize(entities.capacity());
+		}
 
 		
 		gfx::setViewTransform(pass.id, &camera.getView(), &camera.getProj());
 
-		entities.each<TransformComponent, ModelComponent>([this, &cameraLods, &camera, dt, &pass](
-			Entity e,
-			TransformComponent& transformComponent,
-			ModelComponent& modelComponent
-			)
+		// the spatial tree limits the candidates to bounds touching the frustum
+		const auto& frustum = camera.getFrustum();
+		mCullBatch.clear();
+		mCandidates.clear();
+		auto addCandidate = [this, &cameraLods](Entity e, TransformComponent& transformComponent, ModelComponent& modelComponent, unsigned int frustumBits)
 		{
 			const auto& model = modelComponent.getModel();
 			if (!model.isValid())
 				return;
 
-			const auto& worldTransform = transformComponent.getTransform();
-			const auto clip_planes = math::vec2(camera.getNearClip(), camera.getFarClip());
-
-			auto& lodData = cameraLods[e];
-			const auto transitionTime = model.getTransitionTime();
-			const auto minDistance = model.getMinDistance();
-			const auto maxDistance = model.getMaxDistance();
-			const auto lodCount = model.getLods().size();
-			const auto currentTime = lodData.currentTime;
-			const auto currentLodIndex = lodData.currentLodIndex;
-			const auto targetLodIndex = lodData.targetLodIndex;
-
 			auto material = model.getMaterialForGroup({});
 			if (!material)
 				return;
 
-			const auto hMeshCurr = model.getLod(currentLodIndex);
-			if (!hMeshCurr)
-				return;
+			// a slot left by a destroyed entity starts over for the next owner
+			const auto index = e.id().index();
+			auto& lodData = cameraLods.states[index];
+			if (cameraLods.owners[index] != e.id())
+			{
+				cameraLods.owners[index] = e.id();
+				lodData = LodData();
+			}
 
-			const auto& frustum = camera.getFrustum();
-			const auto& bounds = hMeshCurr->aabb;
+			Candidate candidate = {};
+			candidate.model = &model;
+			candidate.material = material.get();
+			candidate.transform = &transformComponent.getTransform();
+			candidate.lodData = &lodData;
+			candidate.frustumBits = frustumBits;
+			candidate.occluder = modelComponent.isOccluder();
+			mCandidates.push_back(candidate);
+		};
 
-			float t = 0.0f;
-			const auto rayOrigin = camera.getPosition();
-			const auto invWorld = math::inverse(worldTransform);
-			const auto objectRayOrigin = invWorld.transformCoord(rayOrigin);
-			const auto objectRayDirection = math::normalize(bounds.getCenter() - objectRayOrigin);
-			bounds.intersect(objectRayOrigin, objectRayDirection, t);
+		if (spatial)
+		{
+			spatial->queryFrustum(frustum, [&entities, &addCandidate](Entity e, unsigned int frustumBits)
+			{
+				const auto transformComponent = entities.get_ptr<TransformComponent>(e.id());
+				const auto modelComponent = entities.get_ptr<ModelComponent>(e.id());
+				if (transformComponent && modelComponent)
+					addCandidate(e, *transformComponent, *modelComponent, frustumBits);
+			});
+		}
+		else
+		{
+			// without the tree every model is a candidate for the frustum test
+			entities.each<TransformComponent, ModelComponent>([&addCandidate](Entity e, TransformComponent& transformComponent, ModelComponent& modelComponent)
+			{
+				addCandidate(e, transformComponent, modelComponent, 0);
+			});
+		}
 
-			// Compute final object space intersection point.
-			auto intersectionPoint = objectRayOrigin + (objectRayDirection * t);
+		selectLods(camera, dt);
 
-			// transform intersection point back into world space to compute
-			// the final intersection distance.
-			intersectionPoint = worldTransform.transformCoord(intersectionPoint);
-			const float distance = math::length(intersectionPoint - rayOrigin);
+		// lod meshes still streaming in are loaded nearest first
+		auto& manager = Singleton<Application>::getInstance().getAssetManager();
+		for (const auto& candidate : mCandidates)
+		{
+			for (const auto& lod : candidate.model->getLods())
+			{
+				if (!lod && !lod.id().empty())
+					manager.setPriority<Mesh>(lod.id(), 1.0f / (1.0f + candidate.distance));
+			}
+		}
 
-			//Compute Lods
-			updateLodData(
-				lodData,
-				lodCount,
-				minDistance,
-				maxDistance,
-				transitionTime,
-				distance,
-				dt);
-			// Test the bounding box of the mesh
-			if (!math::frustum::testOBB(frustum, bounds, worldTransform))
-				return;
+		// models without a loaded lod have nothing to draw
+		mCandidates.erase(std::remove_if(mCandidates.begin(), mCandidates.end(), [](const Candidate& candidate)
+		{
+			return candidate.mesh == nullptr;
+		}), mCandidates.end());
+
+		// the bounding box of the lod mesh is tested with the others below,
+		// starting with the plane that rejected the entity last frame
+		for (const auto& candidate : mCandidates)
+			mCullBatch.add(candidate.mesh->aabb, *candidate.transform, candidate.frustumBits, candidate.lodData->lastOutside);
+
+		frustum.testBatch(mCullBatch, mVisible);
+		for (std::size_t i = 0; i < mCandidates.size(); ++i)
+			mCandidates[i].lodData->lastOutside = mCullBatch.getLastOutside(i);
+
+		// rasterize the visible occluders, everything else is tested against them
+		OcclusionBuffer* occlusion = nullptr;
+		if (mOcclusionCulling)
+		{
+			occlusion = &mOcclusionBuffers[ce];
+			occlusion->begin(camera.getProj() * camera.getView());
+			for (std::size_t i = 0; i < mCandidates.size(); ++i)
+			{
+				const auto& candidate = mCandidates[i];
+				if (candidate.occluder && ((mVisible[i / 32] >> (i % 32)) & 0x1) != 0)
+					occlusion->addOccluder(*candidate.mesh, *candidate.transform);
+			}
+			occlusion->rasterize(&Singleton<Application>::getInstance().getThreadPool());
+		}
+
+		// the bounding sphere coverage converts to pixels to pick texture mips
+		const auto frame = Singleton<Application>::getInstance().getTimer().getFrameCounter();
+		const float viewportHeight = static_cast<float>(camera.getViewportSize().height);
+
+		for (std::size_t i = 0; i < mCandidates.size(); ++i)
+		{
+			if (((mVisible[i / 32] >> (i % 32)) & 0x1) == 0)
+				continue;
+
+			const auto& candidate = mCandidates[i];
+			if (occlusion && !candidate.occluder && !occlusion->isVisible(candidate.mesh->aabb, *candidate.transform))
+				continue;
+
+			const auto& worldTransform = *candidate.transform;
+			const auto material = candidate.material;
+			const auto distance = candidate.distance;
+
+			// draws outside of a lod transition share their parameters so
+			// the queue can batch them
+			const auto params = math::vec3{ 0.0f, -1.0f, candidate.fade };
+			const auto paramsInv = math::vec3{ 1.0f, 1.0f, 1.0f - candidate.fade };
 
-			const auto params = math::vec3{
-				0.0f,
-				-1.0f,
-				(transitionTime - currentTime) / transitionTime
-			};
-
-			const auto paramsInv = math::vec3{
-				1.0f,
-				1.0f,
-				currentTime / transitionTime
-			};
 			// Set render states.
 			const auto states = material->getRenderStates();
-			material->beginPass();
-			material->setUniform("u_camera_wpos", &camera.getPosition());
-			material->setUniform("u_camera_clip_planes", &clip_planes);
-			material->setUniform("u_lod_params", &params);
-			material->submit();
-			hMeshCurr->submit(pass.id, material->getProgram()->handle, worldTransform, states);
-
-			if (currentTime != 0.0f)
-			{
-				material->setUniform("u_lod_params", &paramsInv);
-				material->submit();
 
-				const auto hMeshTarget = model.getLod(targetLodIndex);
-				if (!hMeshTarget)
-					return;
-				hMeshTarget->submit(pass.id, material->getProgram()->handle, worldTransform, states);
-			}
+			mRenderQueue.add(candidate.mesh, material, states, worldTransform, distance, params);
+			material->requestTextureResolution(candidate.coverage * viewportHeight, frame);
+
+			if (candidate.targetMesh)
+				mRenderQueue.add(candidate.targetMesh, material, states, worldTransform, distance, paramsInv);
+		}
+		mCandidates.clear();
 
-		});
+		if (occlusion)
+		{
+			const auto& stats = occlusion->getStats();
+			mOcclusionStats.occluders += stats.occluders;
+			mOcclusionStats.triangles += stats.triangles;
+			mOcclusionStats.tested += stats.tested;
+			mOcclusionStats.culled += stats.culled;
+		}
+
+		mRenderQueue.flush(pass.id, camera);
 
 		
 		const auto surface = cameraComponent.getOutputBuffer();
@@ -159,16 +243,111 @@ void RenderingSystem::frameRender(EntityManager &entities, EventManager &events,
 
 }
 
-void RenderingSystem::receive(const EntityDestroyedEvent &event)
+void RenderingSystem::selectLods(Camera& camera, float dt)
+{
+	const auto eye = camera.getPosition();
+	const bool perspective = camera.getProjectionMode() == ProjectionMode::Perspective;
+	const float projectionScale = camera.getProj()[1][1];
+
+	auto select = [this, eye, perspective, projectionScale, dt](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			auto& candidate = mCandidates[i];
+			const auto& model = *candidate.model;
+			const auto& worldTransform = *candidate.transform;
+			auto& lodData = *candidate.lodData;
+
+			// the sphere around the shown lod, lods share roughly the same bounds
+			const auto mesh = getLodMesh(model, lodData.currentLodIndex);
+			if (!mesh)
+			{
+				// nothing is loaded yet, the origin still orders the lod loads
+				candidate.distance = math::length(worldTransform.getPosition() - eye);
+				continue;
+			}
+
+			const auto center = worldTransform.transformCoord(mesh->aabb.getCenter());
+			const auto radius = math::length(mesh->aabb.getExtents() * worldTransform.getScale());
+			const auto centerDistance = math::length(center - eye);
+			const auto distance = std::max(centerDistance - radius, 0.0f);
+
+			// diameter over the viewport height, orthographic cameras ignore the distance
+			const auto coverage = perspective ?
+				radius * projectionScale / std::max(centerDistance, 0.01f) :
+				radius * projectionScale;
+
+			// the coverage the sphere has at the model's lod distances
+			const auto minCoverage = radius * LodReferenceScale / std::max(model.getMaxDistance(), 0.01f);
+			const auto maxCoverage = radius * LodReferenceScale / std::max(model.getMinDistance(), 0.01f);
+			const auto transitionTime = model.getTransitionTime();
+
+			updateLodData(
+				lodData,
+				model.getLods().size(),
+				minCoverage,
+				maxCoverage,
+				transitionTime,
+				coverage,
+				dt);
+
+			candidate.mesh = getLodMesh(model, lodData.currentLodIndex);
+			candidate.targetMesh = nullptr;
+			candidate.distance = distance;
+			candidate.coverage = coverage;
+			candidate.fade = 1.0f;
+			if (lodData.currentTime != 0.0f)
+			{
+				candidate.targetMesh = getLodMesh(model, lodData.targetLodIndex);
+				candidate.fade = (transitionTime - lodData.currentTime) / transitionTime;
+			}
+		}
+	};
+
+	const std::size_t count = mCandidates.size();
+	auto& pool = Singleton<Application>::getInstance().getThreadPool();
+	const std::size_t jobs = std::min((count + LodBatchSize - 1) / LodBatchSize, pool.getWorkerCount() + 1);
+	if (jobs <= 1)
+	{
+		select(0, count);
+		return;
+	}
+
+	auto parent = pool.createJob([]() {});
+	for (std::size_t job = 0; job < jobs; ++job)
+	{
+		const std::size_t begin = count * job / jobs;
+		const std::size_t end = count * (job + 1) / jobs;
+		pool.run(pool.createChildJob(parent, [&select, begin, end]()
+		{
+			select(begin, end);
+		}));
+	}
+	pool.run(parent);
+	pool.wait(parent);
+}
+
+void RenderingSystem::receive(EventSpan<EntityDestroyedEvent> events)
+{
+	// lod states of destroyed entities are reset when their slot is reused
+	for (const auto& event : events)
+	{
+		mCameraLods.erase(event.entity);
+		mOcclusionBuffers.erase(event.entity);
+	}
+}
+
+void RenderingSystem::receive(const EntitiesDestroyedEvent &event)
 {
-	mLodDataMap.erase(event.entity);
-	for (auto& pair : mLodDataMap)
+	for (const auto& entity : event.entities)
 	{
-		pair.second.erase(event.entity);
+		mCameraLods.erase(entity);
+		mOcclusionBuffers.erase(entity);
 	}
 }
 
 void RenderingSystem::configure(EventManager &events)
 {
-	events.subscribe<EntityDestroyedEvent>(*this);
+	events.subscribe_queued<EntityDestroyedEvent>(*this);
+	events.subscribe<EntitiesDestroyedEvent>(*this);
 }
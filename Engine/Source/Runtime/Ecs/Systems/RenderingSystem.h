@@ -1,21 +1,38 @@
 #pragma once
 
 #include "../entityx/System.h"
+#include "../../Rendering/RenderQueue.h"
+#include "../../Rendering/OcclusionBuffer.h"
 #include <vector>
 #include <memory>
 
 using namespace entityx;
 
+struct Mesh;
+class Model;
+class Material;
+class Camera;
+
 struct LodData
 {
 	std::uint32_t currentLodIndex = 0;
 	std::uint32_t targetLodIndex = 0;
 	float currentTime = 0.0f;
+	/// Frustum plane that rejected the entity last time, -1 if none
+	int lastOutside = -1;
 };
 
 class RenderingSystem : public System<RenderingSystem>, public Receiver<System<RenderingSystem>>
 {
 public:
+	//-----------------------------------------------------------------------------
+	//  Name : RenderingSystem ()
+	/// <summary>
+	/// Declares the components accessed by the system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	RenderingSystem();
+
 	//-----------------------------------------------------------------------------
 	//  Name : frameRender (virtual )
 	/// <summary>
@@ -34,7 +51,8 @@ public:
 	/// 
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void receive(const EntityDestroyedEvent &event);
+	void receive(EventSpan<EntityDestroyedEvent> events);
+	void receive(const EntitiesDestroyedEvent &event);
 	
 	//-----------------------------------------------------------------------------
 	//  Name : configure ()
@@ -46,6 +64,93 @@ public:
 	//-----------------------------------------------------------------------------
 	void configure(EventManager &events) override;
 
+	//-----------------------------------------------------------------------------
+	//  Name : setOcclusionCulling ()
+	/// <summary>
+	/// Enables the cpu occlusion stage. Visible entities whose model component
+	/// is marked as occluder hide the entities behind them.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setOcclusionCulling(bool enabled) { mOcclusionCulling = enabled; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getOcclusionCulling ()
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool getOcclusionCulling() const { return mOcclusionCulling; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getOcclusionStats ()
+	/// <summary>
+	/// Occlusion counters of the last frame, summed over every camera.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const OcclusionBuffer::Stats& getOcclusionStats() const { return mOcclusionStats; }
+
 private:
-	std::unordered_map<Entity, std::unordered_map<Entity, LodData>> mLodDataMap;
+	struct Candidate
+	{
+		/// Model of the entity
+		const Model* model;
+		/// Material of the draw
+		Material* material;
+		/// World transform of the entity
+		const math::transform_t* transform;
+		/// Lod and culling state of the entity for the camera
+		LodData* lodData;
+		/// Current lod mesh, written by the lod stage. Null if there is none
+		const Mesh* mesh;
+		/// Lod mesh faded in during a transition, written by the lod stage
+		const Mesh* targetMesh;
+		/// Distance from the camera to the bounding sphere, written by the lod stage
+		float distance;
+		/// Fraction of the viewport height covered by the bounding sphere,
+		/// written by the lod stage
+		float coverage;
+		/// Fade of the current lod mesh, written by the lod stage
+		float fade;
+		/// Frustum planes the spatial query found the bounds inside of
+		unsigned int frustumBits;
+		/// Is the model an occluder
+		bool occluder;
+	};
+
+	struct CameraLods
+	{
+		/// Lod state per entity index
+		std::vector<LodData> states;
+		/// Entity each state belongs to, a new entity in the slot starts over
+		std::vector<Entity::Id> owners;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : selectLods ()
+	/// <summary>
+	/// Lod stage. Picks the lod of every candidate from the screen coverage
+	/// of its bounding sphere and advances the lod transitions. Candidates
+	/// are independent so the work is split over the thread pool.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void selectLods(Camera& camera, float dt);
+
+	/// Lod state per camera
+	std::unordered_map<Entity, CameraLods> mCameraLods;
+	/// Bounding boxes of mCandidates for the frustum test
+	math::cull_batch mCullBatch;
+	/// Draws that passed the spatial query, parallel to the cull batch
+	std::vector<Candidate> mCandidates;
+	/// Visibility mask of mCandidates
+	std::vector<std::uint32_t> mVisible;
+	/// Occlusion buffer per camera
+	std::unordered_map<Entity, OcclusionBuffer> mOcclusionBuffers;
+	/// Occlusion counters of the last frame
+	OcclusionBuffer::Stats mOcclusionStats;
+	/// Is the occlusion stage enabled
+	bool mOcclusionCulling = false;
+	/// Draws collected for the current pass, reused between frames
+	RenderQueue mRenderQueue;
 };
@@ -0,0 +1,166 @@
+#include "SpatialSystem.h"
+#include "TransformSystem.h"
+#include "../Components/TransformComponent.h"
+#include "../Components/ModelComponent.h"
+#include "../../Rendering/Mesh.h"
+#include "../../Rendering/Model.h"
+#include <algorithm>
+#include <mutex>
+
+SpatialSystem::SpatialSystem()
+{
+	reads<TransformComponent, ModelComponent>();
+}
+
+void SpatialSystem::configure(EntityManager &entities, EventManager &events)
+{
+	mEntities = &entities;
+
+	events.subscribe<ComponentAddedEvent<Component>>(*this);
+	events.subscribe<ComponentRemovedEvent<Component>>(*this);
+	events.subscribe<ComponentChangedEvent<Component>>(*this);
+	events.subscribe_queued<EntityDestroyedEvent>(*this);
+	events.subscribe<EntitiesDestroyedEvent>(*this);
+	events.subscribe_queued<TransformsUpdatedEvent>(*this);
+}
+
+void SpatialSystem::receive(const ComponentAddedEvent<Component> &event)
+{
+	auto component = event.component.lock();
+	if (!component)
+		return;
+
+	const auto id = component->getId_v();
+	if (id == TransformComponent::getId() || id == ModelComponent::getId())
+		markPending(event.entity.id());
+}
+
+void SpatialSystem::receive(const ComponentRemovedEvent<Component> &event)
+{
+	auto component = event.component.lock();
+	if (!component)
+		return;
+
+	const auto id = component->getId_v();
+	if (id == TransformComponent::getId() || id == ModelComponent::getId())
+		markPending(event.entity.id());
+}
+
+void SpatialSystem::receive(const ComponentChangedEvent<Component> &event)
+{
+	// a swapped model only refits the proxy of its own entity
+	auto component = event.component.lock();
+	if (component && component->getId_v() == ModelComponent::getId())
+		markPending(event.entity.id());
+}
+
+void SpatialSystem::receive(EventSpan<EntityDestroyedEvent> events)
+{
+	std::lock_guard<core::spin_mutex> lock(mPendingMutex);
+	for (const auto& event : events)
+		mPending.push_back(event.entity.id());
+}
+
+void SpatialSystem::receive(const EntitiesDestroyedEvent &event)
+{
+	std::lock_guard<core::spin_mutex> lock(mPendingMutex);
+	for (const auto& entity : event.entities)
+		mPending.push_back(entity.id());
+}
+
+void SpatialSystem::receive(EventSpan<TransformsUpdatedEvent> events)
+{
+	// delivered on the main thread between the phases, moving the proxies
+	// right away keeps the tree in sync with this frame's transforms
+	for (const auto& event : events)
+	{
+		for (auto transform : event.transforms)
+		{
+			const auto id = transform->getEntity().id();
+			if (!refresh(*mEntities, id))
+				mUnresolved.push_back(id);
+		}
+	}
+}
+
+void SpatialSystem::markPending(Entity::Id id)
+{
+	std::lock_guard<core::spin_mutex> lock(mPendingMutex);
+	mPending.push_back(id);
+}
+
+void SpatialSystem::frameBegin(EntityManager &entities, EventManager &events, TimeDelta dt)
+{
+	std::vector<Entity::Id> pending;
+	{
+		std::lock_guard<core::spin_mutex> lock(mPendingMutex);
+		pending.swap(mPending);
+	}
+
+	// meshes finish loading asynchronously, retry until the bounds are known
+	pending.insert(pending.end(), mUnresolved.begin(), mUnresolved.end());
+	mUnresolved.clear();
+
+	for (const auto id : pending)
+	{
+		if (!refresh(entities, id))
+			mUnresolved.push_back(id);
+	}
+
+	// the same entity may have been queued several times
+	std::sort(mUnresolved.begin(), mUnresolved.end());
+	mUnresolved.erase(std::unique(mUnresolved.begin(), mUnresolved.end()), mUnresolved.end());
+}
+
+bool SpatialSystem::refresh(EntityManager &entities, Entity::Id id)
+{
+	const auto index = id.index();
+	if (!entities.valid(id))
+	{
+		// the index may already belong to a new entity
+		if (index < mProxies.size() && mProxies[index] != -1 && mTree.getUserData(mProxies[index]) == id.id())
+			removeProxy(index);
+		return true;
+	}
+
+	auto transform = entities.component<TransformComponent>(id).lock();
+	auto model = entities.component<ModelComponent>(id).lock();
+	if (!transform || !model)
+	{
+		removeProxy(index);
+		return true;
+	}
+
+	const auto mesh = model->getModel().getLod(0);
+	if (!mesh)
+	{
+		removeProxy(index);
+		return !model->getModel().isValid();
+	}
+
+	const auto bounds = math::bbox::mul(mesh->aabb, transform->getTransform());
+
+	if (mProxies.size() <= index)
+		mProxies.resize(index + 1, -1);
+
+	// a proxy left behind by a destroyed entity with the same index
+	if (mProxies[index] != -1 && mTree.getUserData(mProxies[index]) != id.id())
+		removeProxy(index);
+
+	auto& proxy = mProxies[index];
+	if (proxy == -1)
+		proxy = mTree.insert(bounds, id.id());
+	else
+		mTree.update(proxy, bounds);
+
+	return true;
+}
+
+void SpatialSystem::removeProxy(std::uint32_t index)
+{
+	if (index >= mProxies.size() || mProxies[index] == -1)
+		return;
+
+	mTree.remove(mProxies[index]);
+	mProxies[index] = -1;
+}
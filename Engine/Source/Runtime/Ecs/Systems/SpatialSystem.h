@@ -0,0 +1,198 @@
+#pragma once
+
+#include "../entityx/System.h"
+#include "Core/math/bvh.h"
+#include "Core/common/spin.hpp"
+#include <vector>
+#include <cstdint>
+
+using namespace entityx;
+
+struct TransformsUpdatedEvent;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : SpatialSystem (Class)
+/// <summary>
+/// Keeps the world bounds of every entity with a transform and a model in a
+/// dynamic bounding volume hierarchy. The tree is updated incrementally from
+/// the transforms recomputed by the TransformSystem and from component
+/// changes, and is shared by culling, picking and gameplay queries.
+/// </summary>
+//-----------------------------------------------------------------------------
+class SpatialSystem : public System<SpatialSystem>, public Receiver<System<SpatialSystem>>
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : SpatialSystem ()
+	/// <summary>
+	/// Declares the components accessed by the system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	SpatialSystem();
+
+	//-----------------------------------------------------------------------------
+	//  Name : frameBegin (virtual )
+	/// <summary>
+	/// Applies the changes collected since the last frame to the tree.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void frameBegin(EntityManager &entities, EventManager &events, TimeDelta dt) override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : configure ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void configure(EntityManager &entities, EventManager &events) override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : receive ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void receive(const ComponentAddedEvent<Component> &event);
+	void receive(const ComponentRemovedEvent<Component> &event);
+	void receive(const ComponentChangedEvent<Component> &event);
+	void receive(EventSpan<EntityDestroyedEvent> events);
+	void receive(const EntitiesDestroyedEvent &event);
+	void receive(EventSpan<TransformsUpdatedEvent> events);
+
+	//-----------------------------------------------------------------------------
+	//  Name : queryFrustum ()
+	/// <summary>
+	/// Calls callback(Entity, frustumBits) for every entity whose bounds may
+	/// be visible in the frustum. Bounds are conservative, exact tests are up
+	/// to the caller. Bit i of frustumBits is set if the bounds are known to
+	/// be completely inside plane i.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryFrustum(const math::frustum& frustum, F&& callback) const
+	{
+		mTree.queryFrustum(frustum, [this, &callback](std::uint64_t userData, unsigned int frustumBits)
+		{
+			auto withBits = [&callback, frustumBits](Entity e)
+			{
+				callback(e, frustumBits);
+			};
+			yield(userData, withBits);
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : queryRay ()
+	/// <summary>
+	/// Calls callback(Entity) for every entity whose bounds may be hit by the
+	/// segment from origin along direction up to maxDistance.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryRay(const math::vec3& origin, const math::vec3& direction, float maxDistance, F&& callback) const
+	{
+		mTree.queryRay(origin, direction, maxDistance, [this, &callback](std::uint64_t userData)
+		{
+			yield(userData, callback);
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : querySphere ()
+	/// <summary>
+	/// Calls callback(Entity) for every entity whose bounds may overlap the
+	/// sphere.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void querySphere(const math::vec3& center, float radius, F&& callback) const
+	{
+		mTree.querySphere(center, radius, [this, &callback](std::uint64_t userData)
+		{
+			yield(userData, callback);
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : queryAABB ()
+	/// <summary>
+	/// Calls callback(Entity) for every entity whose bounds may overlap the
+	/// box.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void queryAABB(const math::bbox& bounds, F&& callback) const
+	{
+		mTree.queryAABB(bounds, [this, &callback](std::uint64_t userData)
+		{
+			yield(userData, callback);
+		});
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : getTree ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const math::bvh& getTree() const { return mTree; }
+
+private:
+	template<typename F>
+	void yield(std::uint64_t userData, F& callback) const
+	{
+		// entities destroyed since the last frame are still in the tree
+		const Entity::Id id(userData);
+		if (mEntities && mEntities->valid(id))
+			callback(mEntities->get(id));
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : markPending ()
+	/// <summary>
+	/// Queues an entity for a bounds refresh on the next frameBegin.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void markPending(Entity::Id id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : refresh ()
+	/// <summary>
+	/// Inserts, moves or removes the proxy of an entity. Returns false if the
+	/// entity has a model whose mesh is not loaded yet.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool refresh(EntityManager &entities, Entity::Id id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : removeProxy ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void removeProxy(std::uint32_t index);
+
+	/// The hierarchy of world bounds, user data is the entity id
+	math::bvh mTree;
+	/// Tree proxy per entity index, -1 if the entity is not in the tree
+	std::vector<int> mProxies;
+	/// Entities changed since the last frame
+	std::vector<Entity::Id> mPending;
+	/// Guards mPending, events may be emitted from worker threads
+	core::spin_mutex mPendingMutex;
+	/// Entities waiting for their mesh to load
+	std::vector<Entity::Id> mUnresolved;
+	/// Used to resolve the entities of query results
+	EntityManager* mEntities = nullptr;
+};
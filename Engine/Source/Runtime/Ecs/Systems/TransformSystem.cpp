@@ -1,37 +1,138 @@
 #include "TransformSystem.h"
 #include "../Components/TransformComponent.h"
+#include <algorithm>
 
-void updateTransform(ComponentHandle<TransformComponent> hTransform, TimeDelta dt)
+const std::uint32_t TransformSystem::invalidNode;
+
+TransformSystem::TransformSystem()
 {
-	auto pTransform = hTransform.lock();
-	if (pTransform)
-	{
-		pTransform->resolveTransform(true, dt);
+	writes<TransformComponent>();
+}
+
+void TransformSystem::configure(EventManager &events)
+{
+	events.queue<TransformsUpdatedEvent>();
+
+	events.subscribe<ComponentAddedEvent<Component>>(*this);
+	events.subscribe<ComponentRemovedEvent<Component>>(*this);
+	events.subscribe<ComponentChangedEvent<Component>>(*this);
+	events.subscribe<EntitiesDestroyedEvent>(*this);
+}
+
+void TransformSystem::receive(const ComponentAddedEvent<Component> &event)
+{
+	auto component = event.component.lock();
+	if (component && component->getId_v() == TransformComponent::getId())
+		mHierarchyChanged = true;
+}
+
+void TransformSystem::receive(const ComponentRemovedEvent<Component> &event)
+{
+	auto component = event.component.lock();
+	if (component && component->getId_v() == TransformComponent::getId())
+		mHierarchyChanged = true;
+}
+
+void TransformSystem::receive(const ComponentChangedEvent<Component> &event)
+{
+	auto component = event.component.lock();
+	if (component && component->getId_v() == TransformComponent::getId())
+		mHierarchyChanged = true;
+}
 
-		auto& children = pTransform->getChildren();
-		for (auto& child : children)
+void TransformSystem::receive(const EntitiesDestroyedEvent &event)
+{
+	// emitted before the components are destroyed
+	for (const auto& entity : event.entities)
+	{
+		if (entity.has_component<TransformComponent>())
 		{
-			updateTransform(child, dt);
+			mHierarchyChanged = true;
+			return;
 		}
 	}
+}
 
+void TransformSystem::rebuildHierarchy(EntityManager &entities)
+{
+	std::vector<TransformComponent*> roots;
+	entities.each<TransformComponent>([&roots](Entity e, TransformComponent& transformComponent)
+	{
+		if (transformComponent.getParent().expired())
+			roots.push_back(&transformComponent);
+	});
 
+	// keep the roots in entity order regardless of the storage layout
+	std::sort(roots.begin(), roots.end(), [](TransformComponent* lhs, TransformComponent* rhs)
+	{
+		return lhs->getEntity().id().index() < rhs->getEntity().id().index();
+	});
+
+	mRoots.clear();
+	mNodes.clear();
+
+	std::vector<Node> stack;
+	for (auto root : roots)
+	{
+		mRoots.push_back(root->makeHandle());
+
+		stack.push_back({ root, invalidNode });
+		while (!stack.empty())
+		{
+			const Node node = stack.back();
+			stack.pop_back();
+
+			const auto index = static_cast<std::uint32_t>(mNodes.size());
+			mNodes.push_back(node);
+
+			// pushed in reverse so the first child is visited first
+			const auto& children = node.component->getChildren();
+			for (auto it = children.rbegin(); it != children.rend(); ++it)
+			{
+				auto child = it->lock();
+				if (child)
+					stack.push_back({ child.get(), index });
+			}
+		}
+	}
+
+	mUpdated.resize(mNodes.size());
 }
 
 void TransformSystem::frameBegin(EntityManager &entities, EventManager &events, TimeDelta dt)
 {
-	mRoots.clear();
-	entities.each<TransformComponent>([this](Entity e, TransformComponent& transformComponent)
+	// the flattened hierarchy only changes when transforms of this manager
+	// are created, destroyed or reparented
+	if (mHierarchyChanged.exchange(false))
+		rebuildHierarchy(entities);
+
+	// parents precede their children, so a single pass propagates the dirty
+	// state down and recomputes only the changed subtrees. The dirty flags
+	// live in the transforms and survive a rebuild, new and reparented
+	// transforms start dirty.
+	mUpdatedTransforms.clear();
+	const auto count = mNodes.size();
+	for (std::size_t i = 0; i < count; ++i)
 	{
-		auto parent = transformComponent.getParent();
-		if (parent.expired())
+		const auto& node = mNodes[i];
+		auto component = node.component;
+		const TransformComponent* parent = nullptr;
+		bool dirty = component->isWorldDirty() || component->getSlowParenting();
+
+		if (node.parent != invalidNode)
 		{
-			mRoots.push_back(transformComponent.makeHandle());
+			parent = mNodes[node.parent].component;
+			dirty |= mUpdated[node.parent] != 0;
 		}
-	});
 
-	for (auto& hComponent : mRoots)
-	{
-		updateTransform(hComponent, dt);
+		mUpdated[i] = dirty ? 1 : 0;
+		if (dirty)
+		{
+			component->updateWorldTransform(parent, dt);
+			mUpdatedTransforms.push_back(component);
+		}
 	}
+
+	if (!mUpdatedTransforms.empty())
+		events.emit<TransformsUpdatedEvent>(mUpdatedTransforms);
 }
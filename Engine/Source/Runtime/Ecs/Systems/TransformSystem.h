@@ -2,12 +2,61 @@
 
 #include "../entityx/System.h"
 #include <vector>
+#include <cstdint>
+#include <atomic>
 using namespace entityx;
 
 class TransformComponent;
-class TransformSystem : public System<TransformSystem>
+
+//-----------------------------------------------------------------------------
+//  Name : TransformsUpdatedEvent (Struct)
+/// <summary>
+/// Queued by the TransformSystem after the world transforms were resolved,
+/// listing every transform whose world matrix was recomputed this frame.
+/// Delivered on the main thread at the end of the phase, the list is only
+/// valid while the event is delivered.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct TransformsUpdatedEvent : public Event<TransformsUpdatedEvent>
+{
+	explicit TransformsUpdatedEvent(const std::vector<TransformComponent*>& transforms) : transforms(transforms) {}
+
+	const std::vector<TransformComponent*>& transforms;
+};
+
+class TransformSystem : public System<TransformSystem>, public Receiver<System<TransformSystem>>
 {
 public:
+	//-----------------------------------------------------------------------------
+	//  Name : TransformSystem ()
+	/// <summary>
+	/// Declares the components accessed by the system.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	TransformSystem();
+
+	//-----------------------------------------------------------------------------
+	//  Name : configure ()
+	/// <summary>
+	/// Switches TransformsUpdatedEvent to queued delivery, the system runs
+	/// on a worker. Subscribes to the component events of its own manager
+	/// that change the hierarchy.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void configure(EventManager &events) override;
+
+	//-----------------------------------------------------------------------------
+	//  Name : receive ()
+	/// <summary>
+	/// Flags the flattened hierarchy for a rebuild when a transform is added,
+	/// removed, destroyed or reparented.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void receive(const ComponentAddedEvent<Component> &event);
+	void receive(const ComponentRemovedEvent<Component> &event);
+	void receive(const ComponentChangedEvent<Component> &event);
+	void receive(const EntitiesDestroyedEvent &event);
+
 	//-----------------------------------------------------------------------------
 	//  Name : frameBegin (virtual )
 	/// <summary>
@@ -28,6 +77,32 @@ public:
 	//-----------------------------------------------------------------------------
 	const std::vector<ComponentHandle<TransformComponent>>& getRoots() const { return mRoots; }
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : rebuildHierarchy ()
+	/// <summary>
+	/// Collects the scene roots and flattens the hierarchy below them in
+	/// depth-first order, so every parent precedes its children.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rebuildHierarchy(EntityManager &entities);
+
+	struct Node
+	{
+		/// The transform, valid until the hierarchy is rebuilt.
+		TransformComponent* component;
+		/// Position of the parent node, invalidNode for roots.
+		std::uint32_t parent;
+	};
+	static const std::uint32_t invalidNode = 0xffffffff;
+
 	/// Scene roots
 	std::vector<ComponentHandle<TransformComponent>> mRoots;
+	/// The hierarchy in depth-first order
+	std::vector<Node> mNodes;
+	/// Was the node recomputed this frame, parallel to mNodes
+	std::vector<std::uint8_t> mUpdated;
+	/// Transforms recomputed this frame
+	std::vector<TransformComponent*> mUpdatedTransforms;
+	/// Does mNodes need a rebuild, set by the receivers
+	std::atomic<bool> mHierarchyChanged{ true };
 };
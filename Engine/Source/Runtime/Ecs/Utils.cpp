@@ -7,6 +7,14 @@ namespace ecs
 {
 	namespace utils
 	{
+		namespace
+		{
+			/// Deferred task list of the deserialization running on this thread
+			thread_local DeferredTasks* sDeferredTasks = nullptr;
+			/// Are the meshes deserialized on this thread part of an occluder
+			thread_local bool sLoadingOccluder = false;
+		}
+
 		void saveEntity(const fs::path& dir, const Entity& data)
 		{
 			const fs::path fullPath = fs::resolve_protocol(dir / fs::path(data.getName()+ ".asset"));
@@ -70,5 +78,44 @@ namespace ecs
 			}
 			return false;
 		}
+
+		bool deserializeData(std::istream& stream, EntityManager& target, std::vector<Entity>& outData, DeferredTasks* deferred)
+		{
+			auto& serializationTarget = getSerializationTarget();
+			auto previousTarget = serializationTarget;
+			serializationTarget = &target;
+			auto previousDeferred = setDeferredTasks(deferred);
+			const bool result = deserializeData(stream, outData);
+			serializationTarget = previousTarget;
+			setDeferredTasks(previousDeferred);
+			return result;
+		}
+
+		void runOnMainThread(std::function<void()> task)
+		{
+			if (sDeferredTasks)
+				sDeferredTasks->push_back(std::move(task));
+			else
+				task();
+		}
+
+		DeferredTasks* setDeferredTasks(DeferredTasks* deferred)
+		{
+			auto previous = sDeferredTasks;
+			sDeferredTasks = deferred;
+			return previous;
+		}
+
+		bool setLoadingOccluder(bool loading)
+		{
+			const bool previous = sLoadingOccluder;
+			sLoadingOccluder = loading;
+			return previous;
+		}
+
+		bool isLoadingOccluder()
+		{
+			return sLoadingOccluder;
+		}
 	}
 }
@@ -3,6 +3,7 @@
 #include "entityx/quick.h"
 #include <vector>
 #include <fstream>
+#include <functional>
 #include "../System/FileSystem.h"
 
 
@@ -10,6 +11,9 @@ namespace ecs
 {
 	namespace utils
 	{
+		/// Work a deserialized component has to do on the main thread
+		using DeferredTasks = std::vector<std::function<void()>>;
+
 		//-----------------------------------------------------------------------------
 		//  Name : saveEntity ()
 		/// <summary>
@@ -69,5 +73,50 @@ namespace ecs
 		/// </summary>
 		//-----------------------------------------------------------------------------
 		bool deserializeData(std::istream& stream, std::vector<Entity>& outData);
+
+		//-----------------------------------------------------------------------------
+		//  Name : deserializeData ()
+		/// <summary>
+		/// Deserializes the entities into the given entity manager instead of
+		/// the application's world. When deferred is given the call may run on
+		/// any thread, work that has to happen on the main thread is queued
+		/// there instead of being run.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool deserializeData(std::istream& stream, EntityManager& target, std::vector<Entity>& outData, DeferredTasks* deferred = nullptr);
+
+		//-----------------------------------------------------------------------------
+		//  Name : runOnMainThread ()
+		/// <summary>
+		/// Runs the task right away, unless the calling thread is deserializing
+		/// with a deferred task list, in which case it is queued there.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void runOnMainThread(std::function<void()> task);
+
+		//-----------------------------------------------------------------------------
+		//  Name : setDeferredTasks ()
+		/// <summary>
+		/// Sets the list runOnMainThread queues to on the calling thread and
+		/// returns the previous one. Null runs the tasks right away again.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		DeferredTasks* setDeferredTasks(DeferredTasks* deferred);
+
+		//-----------------------------------------------------------------------------
+		//  Name : setLoadingOccluder ()
+		/// <summary>
+		/// Marks the meshes deserialized next on the calling thread as part of
+		/// an occluder and returns the previous state.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool setLoadingOccluder(bool loading);
+
+		//-----------------------------------------------------------------------------
+		//  Name : isLoadingOccluder ()
+		/// <summary>
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool isLoadingOccluder();
 	}
 }
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2012 Alec Thomas <alec@swapoff.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Alec Thomas <alec@swapoff.org>
+ */
+
+#include "CommandBuffer.h"
+#include "Component.h"
+
+namespace entityx
+{
+
+	std::vector<Entity> EntityCommandBuffer::playback(EntityManager &entities)
+	{
+		std::vector<Entity> created(created_count_);
+		std::vector<Entity::Id> destroyed;
+
+		auto target = [&created](const Command &command)
+		{
+			return command.created == none ? command.id : created[command.created].id();
+		};
+
+		const size_t count = commands_.size();
+		for (size_t i = 0; i < count;)
+		{
+			const Command &command = commands_[i];
+			switch (command.op)
+			{
+			case Op::Create:
+			{
+				size_t end = i;
+				while (end < count && commands_[end].op == Op::Create)
+					++end;
+
+				auto batch = entities.create(end - i);
+				for (size_t j = i; j < end; ++j)
+					created[commands_[j].created] = batch[j - i];
+				i = end;
+				break;
+			}
+			case Op::Destroy:
+			{
+				destroyed.clear();
+				for (; i < count && commands_[i].op == Op::Destroy; ++i)
+					destroyed.push_back(target(commands_[i]));
+
+				entities.destroy(destroyed);
+				break;
+			}
+			case Op::Assign:
+			{
+				const auto id = target(command);
+				if (entities.valid(id))
+					entities.assign(id, command.component);
+				++i;
+				break;
+			}
+			case Op::Remove:
+			{
+				const auto id = target(command);
+				if (entities.valid(id) && entities.has_component(id, command.family))
+					entities.remove(id, command.family);
+				++i;
+				break;
+			}
+			}
+		}
+
+		clear();
+		return created;
+	}
+
+}  // namespace entityx
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2012 Alec Thomas <alec@swapoff.org>
+ * All rights reserved.
+ *
+ * This software is licensed as described in the file COPYING, which
+ * you should have received as part of this distribution.
+ *
+ * Author: Alec Thomas <alec@swapoff.org>
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Entity.h"
+
+namespace entityx
+{
+
+	/**
+	 * Records structural changes to be applied to an EntityManager later.
+	 *
+	 * Recording does not touch any EntityManager, so a buffer can be filled
+	 * from any thread as long as each thread uses its own buffer. Playback
+	 * must happen on the thread owning the EntityManager and applies the
+	 * commands in the order they were recorded.
+	 *
+	 * @code
+	 * auto bullet = commands.create();
+	 * commands.assign<Position>(bullet, x, y);
+	 * commands.destroy(target.id());
+	 * ...
+	 * commands.playback(entities);
+	 * @endcode
+	 */
+	class EntityCommandBuffer
+	{
+	public:
+		/**
+		 * An entity created by the buffer. It only exists once the buffer is
+		 * played back, until then it can be used with the buffer's commands.
+		 */
+		struct Created
+		{
+			std::uint32_t index;
+		};
+
+		/**
+		 * Record the creation of an entity.
+		 */
+		Created create()
+		{
+			Command command;
+			command.op = Op::Create;
+			command.created = created_count_;
+			commands_.push_back(std::move(command));
+			return Created{ created_count_++ };
+		}
+
+		/**
+		 * Record the destruction of an entity.
+		 */
+		void destroy(Entity::Id id)
+		{
+			Command command;
+			command.op = Op::Destroy;
+			command.id = id;
+			commands_.push_back(std::move(command));
+		}
+
+		void destroy(Created entity)
+		{
+			Command command;
+			command.op = Op::Destroy;
+			command.created = entity.index;
+			commands_.push_back(std::move(command));
+		}
+
+		/**
+		 * Record the assignment of a component. The component is constructed
+		 * right away on the recording thread.
+		 */
+		template <typename C, typename ... Args>
+		void assign(Entity::Id id, Args && ... args)
+		{
+			assign(id, std::allocate_shared<C>(ComponentAllocator<C>(), std::forward<Args>(args) ...));
+		}
+
+		template <typename C, typename ... Args>
+		void assign(Created entity, Args && ... args)
+		{
+			assign(entity, std::allocate_shared<C>(ComponentAllocator<C>(), std::forward<Args>(args) ...));
+		}
+
+		void assign(Entity::Id id, std::shared_ptr<Component> component)
+		{
+			Command command;
+			command.op = Op::Assign;
+			command.id = id;
+			command.component = std::move(component);
+			commands_.push_back(std::move(command));
+		}
+
+		void assign(Created entity, std::shared_ptr<Component> component)
+		{
+			Command command;
+			command.op = Op::Assign;
+			command.created = entity.index;
+			command.component = std::move(component);
+			commands_.push_back(std::move(command));
+		}
+
+		/**
+		 * Record the removal of a component.
+		 */
+		template <typename C>
+		void remove(Entity::Id id)
+		{
+			remove(id, C::getId());
+		}
+
+		void remove(Entity::Id id, ComponentId family)
+		{
+			Command command;
+			command.op = Op::Remove;
+			command.id = id;
+			command.family = family;
+			commands_.push_back(std::move(command));
+		}
+
+		/**
+		 * Apply the recorded commands to the EntityManager and clear the buffer.
+		 *
+		 * Runs of consecutive creates and destroys are applied through the
+		 * batched EntityManager::create(n) and EntityManager::destroy(ids).
+		 * Commands on entities that are no longer valid are skipped.
+		 *
+		 * @returns The entities created by the buffer, indexed by Created::index.
+		 */
+		std::vector<Entity> playback(EntityManager &entities);
+
+		bool empty() const { return commands_.empty(); }
+		size_t size() const { return commands_.size(); }
+
+		void clear()
+		{
+			commands_.clear();
+			created_count_ = 0;
+		}
+
+	private:
+		enum class Op : std::uint8_t
+		{
+			Create,
+			Destroy,
+			Assign,
+			Remove,
+		};
+
+		static const std::uint32_t none = 0xffffffff;
+
+		struct Command
+		{
+			Op op;
+			/// Target entity, unless created is set.
+			Entity::Id id;
+			/// Index of the target entity created by this buffer.
+			std::uint32_t created = none;
+			ComponentId family = 0;
+			std::shared_ptr<Component> component;
+		};
+
+		std::vector<Command> commands_;
+		std::uint32_t created_count_ = 0;
+	};
+
+}  // namespace entityx
@@ -24,7 +24,7 @@ ComponentHandle<type> makeHandle()	\
 }									\
 virtual std::shared_ptr<Component> clone() const								\
 {																				\
-	return std::static_pointer_cast<Component>(std::make_shared<type>(*this));	\
+	return std::allocate_shared<type>(ComponentAllocator<type>(), *this);		\
 }
 
 class Component
@@ -74,6 +74,8 @@ namespace entityx
 
 	void EntityManager::reset()
 	{
+		// one at a time, so receivers still get the EntityDestroyedEvent and
+		// ComponentRemovedEvent of every entity
 		for (Entity entity : entities_for_debugging()) entity.destroy();
 		for (ComponentStorage *pool : component_pools_)
 		{
@@ -109,6 +111,14 @@ namespace entityx
 		pool->destroy(index);
 	}
 
+	void EntityManager::changed(Entity::Id id, const ComponentId family)
+	{
+		assert_valid(id);
+		ComponentStorage *pool = component_pools_[family];
+		ComponentHandle<Component> component(pool->get(id.index()));
+		event_manager_.emit<ComponentChangedEvent<Component>>(get(id), component);
+	}
+
 	bool EntityManager::has_component(Entity::Id id, std::shared_ptr<Component> component) const
 	{
 		return has_component(id, component->getId_v());
@@ -209,26 +219,112 @@ namespace entityx
 
 	}
 
+	std::vector<Entity> EntityManager::create(std::size_t n)
+	{
+		std::vector<Entity> entities;
+		entities.reserve(n);
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			std::uint32_t index, version;
+			if (free_list_.empty())
+			{
+				index = index_counter_++;
+				accomodate_entity(index);
+				version = entity_version_[index] = 1;
+			}
+			else
+			{
+				index = free_list_.back();
+				free_list_.pop_back();
+				version = entity_version_[index];
+			}
+			entities.push_back(Entity(this, Entity::Id(index, version)));
+		}
+		event_manager_.emit<EntitiesCreatedEvent>(entities);
+		return entities;
+	}
+
+	void EntityManager::destroy(const std::vector<Entity::Id> &ids)
+	{
+		std::vector<Entity> entities;
+		entities.reserve(ids.size());
+		for (auto id : ids)
+		{
+			if (valid(id))
+				entities.push_back(Entity(this, id));
+		}
+		if (entities.empty())
+			return;
+
+		event_manager_.emit<EntitiesDestroyedEvent>(entities);
+
+		for (auto &entity : entities)
+		{
+			// a component destructor may have destroyed it already
+			const auto id = entity.id();
+			if (!valid(id))
+				continue;
+
+			const std::uint32_t index = id.index();
+			mEntityNames.erase(id.id());
+			for (size_t i = 0; i < component_pools_.size(); i++)
+			{
+				if (entity_component_mask_[index].test(i))
+				{
+					entity_component_mask_[index].reset(i);
+					component_pools_[i]->destroy(index);
+				}
+			}
+			entity_component_mask_[index].reset();
+			entity_version_[index]++;
+			free_list_.push_back(index);
+		}
+	}
+
 	entityx::Entity EntityManager::create_from_copy(Entity original)
 	{
 		assert(original.valid());
+		// the original may live in another manager, e.g. a prefab template,
+		// so its components are read through its own manager
 		auto clone = create();
-		auto mask = original.component_mask();
-		for (size_t i = 0; i < component_pools_.size(); ++i)
+		for (const auto &component : original.all_components_shared())
+		{
+			clone.assign(component->clone());
+		}
+		clone.setName(original.getName());
+		return clone;
+	}
+
+	entityx::Entity EntityManager::adopt(EntityManager &source, Entity::Id id)
+	{
+		source.assert_valid(id);
+		const std::uint32_t index = id.index();
+		auto entity = create();
+		entity.setName(source.getEntityName(id));
+		source.mEntityNames.erase(id.id());
+
+		auto mask = source.entity_component_mask_[index];
+		for (size_t i = 0; i < source.component_pools_.size(); ++i)
 		{
 			if (mask.test(i))
 			{
-				auto component = component_pools_[i]->get(original.id().index());
-
-				clone.assign(component->clone());
+				ComponentStorage *pool = source.component_pools_[i];
+				auto component = pool->get(index);
+				pool->destroy(index);
+				assign(entity.id(), component);
 			}
 		}
-		clone.setName(original.getName());
-		return clone;
+
+		source.entity_component_mask_[index].reset();
+		source.entity_version_[index]++;
+		source.free_list_.push_back(index);
+		return entity;
 	}
 
 	EntityCreatedEvent::~EntityCreatedEvent() {}
 	EntityDestroyedEvent::~EntityDestroyedEvent() {}
+	EntitiesCreatedEvent::~EntitiesCreatedEvent() {}
+	EntitiesDestroyedEvent::~EntitiesDestroyedEvent() {}
 
 
 }  // namespace entityx
@@ -148,6 +148,9 @@ namespace entityx
 
 		void remove(std::shared_ptr<Component> component);
 
+		template <typename C>
+		void changed();
+
 		template <typename C, typename = typename std::enable_if<!std::is_const<C>::value>::type>
 		ComponentHandle<C> component();
 
@@ -210,6 +213,32 @@ namespace entityx
 	};
 
 
+	/**
+	 * Emitted once for all the entities created by EntityManager::create(n).
+	 */
+	struct EntitiesCreatedEvent : public Event<EntitiesCreatedEvent>
+	{
+		explicit EntitiesCreatedEvent(std::vector<Entity> entities) : entities(std::move(entities)) {}
+		virtual ~EntitiesCreatedEvent();
+
+		std::vector<Entity> entities;
+	};
+
+
+	/**
+	 * Emitted once for all the entities destroyed by
+	 * EntityManager::destroy(ids), just prior to destroying them. No
+	 * ComponentRemovedEvent is emitted for their components.
+	 */
+	struct EntitiesDestroyedEvent : public Event<EntitiesDestroyedEvent>
+	{
+		explicit EntitiesDestroyedEvent(std::vector<Entity> entities) : entities(std::move(entities)) {}
+		virtual ~EntitiesDestroyedEvent();
+
+		std::vector<Entity> entities;
+	};
+
+
 	/**
 	 * Emitted when any component is added to an entity.
 	 */
@@ -236,6 +265,20 @@ namespace entityx
 		ComponentHandle<C> component;
 	};
 
+	/**
+	 * Emitted by EntityManager::changed() when a component changed in a way
+	 * that systems caching data derived from it must know about.
+	 */
+	template <typename C>
+	struct ComponentChangedEvent : public Event<ComponentChangedEvent<C>>
+	{
+		ComponentChangedEvent(Entity entity, ComponentHandle<C> component) :
+			entity(entity), component(component) {}
+
+		Entity entity;
+		ComponentHandle<C> component;
+	};
+
 	/**
 	 * Manages Entity::Id creation and component assignment.
 	 */
@@ -343,7 +386,7 @@ namespace entityx
 			const Iterator begin() const { return Iterator(manager_, mask_, 0); }
 			const Iterator end() const { return Iterator(manager_, mask_, manager_->capacity()); }
 
-		private:
+		protected:
 			friend class EntityManager;
 
 			explicit BaseView(EntityManager *manager) : manager_(manager) { mask_.set(); }
@@ -360,10 +403,50 @@ namespace entityx
 		public:
 			template <typename T> struct identity { typedef T type; };
 
+			/**
+			 * Walks the dense array of the smallest component pool and hands
+			 * out plain references, without locking any handle.
+			 *
+			 * Entities are visited in storage order. The pool is locked for
+			 * the walk, so the callback may remove components or destroy any
+			 * entity. Entities it destroys are skipped, entities it creates
+			 * are not visited.
+			 */
 			void each(typename identity<std::function<void(Entity entity, Components&...)>>::type f)
 			{
-				for (auto it : *this)
-					f(it, *(it.template component<Components>().lock().get())...);
+				EntityManager *manager = this->manager_;
+				ComponentStorage *pools[] = { manager->component_pool(Components::getId())... };
+
+				ComponentStorage *driver = nullptr;
+				for (ComponentStorage *pool : pools)
+				{
+					if (!pool)
+						return;
+					if (!driver || pool->count() < driver->count())
+						driver = pool;
+				}
+
+				// destroyed components leave holes while locked, so the slots
+				// ahead do not move
+				struct Lock
+				{
+					explicit Lock(ComponentStorage *pool) : pool(pool) { pool->lock(); }
+					~Lock() { pool->unlock(); }
+					ComponentStorage *pool;
+				} lock(driver);
+
+				const std::size_t end = driver->slot_count();
+				for (std::size_t i = 0; i < end; ++i)
+				{
+					const std::uint32_t index = driver->entities()[i];
+					if (index == ComponentStorage::invalid)
+						continue;
+
+					if ((manager->entity_component_mask_[index] & this->mask_) != this->mask_)
+						continue;
+
+					f(Entity(manager, manager->create_id(index)), *manager->template component_ptr<Components>(index)...);
+				}
 			}
 
 		private:
@@ -497,6 +580,13 @@ namespace entityx
 			return entity;
 		}
 
+		/**
+		 * Create n new entities.
+		 *
+		 * Emits a single EntitiesCreatedEvent.
+		 */
+		std::vector<Entity> create(std::size_t n);
+
 		/**
 		 * Create a new Entity by copying another. Copy-constructs each component.
 		 *
@@ -504,6 +594,14 @@ namespace entityx
 		 */
 		Entity create_from_copy(Entity original);
 
+		/**
+		 * Move an entity and its components from another EntityManager into
+		 * this one. The components are not copied, the slot in the source is
+		 * freed without destroying them.
+		 *
+		 * Emits EntityCreatedEvent and ComponentAddedEvent on this manager only.
+		 */
+		Entity adopt(EntityManager &source, Entity::Id id);
 
 		/**
 		 * Destroy an existing Entity::Id and its associated Components.
@@ -512,6 +610,15 @@ namespace entityx
 		 */
 		void destroy(Entity::Id id);
 
+		/**
+		 * Destroy several entities and their components. Ids that are no
+		 * longer valid, eg. children destroyed along with their parent, are
+		 * skipped.
+		 *
+		 * Emits a single EntitiesDestroyedEvent.
+		 */
+		void destroy(const std::vector<Entity::Id> &ids);
+
 		Entity get(Entity::Id id)
 		{
 			assert_valid(id);
@@ -539,7 +646,9 @@ namespace entityx
 		template <typename C, typename ... Args>
 		ComponentHandle<C> assign(Entity::Id id, Args && ... args)
 		{
-			return std::static_pointer_cast<C>(assign(id, std::make_shared<C>(std::forward<Args>(args) ...)).lock());
+			auto component = std::allocate_shared<C>(ComponentAllocator<C>(), std::forward<Args>(args) ...);
+			assign(id, component);
+			return component;
 		}
 
 		ComponentHandle<Component> assign(Entity::Id id, std::shared_ptr<Component> component);
@@ -557,6 +666,19 @@ namespace entityx
 		void remove(Entity::Id id, std::shared_ptr<Component> component);
 		void remove(Entity::Id id, const ComponentId family);
 
+		/**
+		 * Notify the receivers of this manager that a Component of an
+		 * Entity::Id changed, eg. a transform was reparented.
+		 *
+		 * Emits a ComponentChangedEvent<Component> event.
+		 */
+		template <typename C>
+		void changed(Entity::Id id)
+		{
+			changed(id, C::getId());
+		}
+		void changed(Entity::Id id, const ComponentId family);
+
 		/**
 		 * Check if an Entity has a component.
 		 */
@@ -608,6 +730,21 @@ namespace entityx
 			return ComponentHandle<C>(pool->get<C>(id.index()));
 		}
 
+		/**
+		 * Raw pointer to a Component assigned to an Entity::Id, for hot loops.
+		 *
+		 * Unlike component() the reference count is not touched, the pointer
+		 * is only valid while the Component stays assigned.
+		 *
+		 * @returns Pointer to an instance of C, or nullptr if the Entity::Id does not have that Component.
+		 */
+		template <typename C>
+		C *get_ptr(Entity::Id id) const
+		{
+			assert_valid(id);
+			return component_ptr<C>(id.index());
+		}
+
 		template <typename ... Components>
 		std::tuple<ComponentHandle<Components>...> components(Entity::Id id)
 		{
@@ -710,6 +847,8 @@ namespace entityx
 
 		/**
 		 * Destroy all entities and reset the EntityManager.
+		 *
+		 * Emits EntityDestroyedEvent and ComponentRemovedEvent for every entity.
 		 */
 		void reset();
 
@@ -779,6 +918,22 @@ namespace entityx
 			return accomodate_component(family);
 		}
 
+		ComponentStorage *component_pool(ComponentId family) const
+		{
+			return family < component_pools_.size() ? component_pools_[family] : nullptr;
+		}
+
+		/**
+		 * Raw pointer to the component of an entity slot, without touching the
+		 * reference count. Only valid while the component stays assigned.
+		 */
+		template <typename C>
+		C *component_ptr(std::uint32_t index) const
+		{
+			ComponentStorage *pool = component_pool(C::getId());
+			return pool ? pool->get_ptr<C>(index) : nullptr;
+		}
+
 		ComponentStorage *accomodate_component(ComponentId family)
 		{
 			if (component_pools_.size() <= family)
@@ -845,6 +1000,13 @@ namespace entityx
 		manager_->remove(id_, component);
 	}
 
+	template <typename C>
+	void Entity::changed()
+	{
+		assert(valid() && has_component<C>());
+		manager_->changed<C>(id_);
+	}
+
 	template <typename C, typename>
 	ComponentHandle<C> Entity::component()
 	{
@@ -19,6 +19,7 @@
 #include <map>
 #include "entityx/3rdparty/catch.hpp"
 #include "entityx/entityx.h"
+#include "entityx/CommandBuffer.h"
 
 // using namespace std;
 using namespace entityx;
@@ -668,3 +669,95 @@ TEST_CASE_METHOD(EntityManagerFixture, "TestViewEach") {
   });
   REQUIRE(count == 1);
 }
+
+struct Health : Component {
+  COMPONENT(Health)
+  explicit Health(int points = 0) : points(points) {}
+
+  int points;
+};
+
+struct DestroyedEventsReceiver : public Receiver<DestroyedEventsReceiver> {
+  void receive(const EntityDestroyedEvent &event) { ++destroyed; }
+  void receive(const EntitiesDestroyedEvent &event) {
+    batches.push_back(event.entities.size());
+  }
+
+  int destroyed = 0;
+  vector<size_t> batches;
+};
+
+TEST_CASE_METHOD(EntityManagerFixture, "TestBatchedDestroy") {
+  DestroyedEventsReceiver receiver;
+  ev.subscribe<EntityDestroyedEvent>(receiver);
+  ev.subscribe<EntitiesDestroyedEvent>(receiver);
+
+  auto created = em.create(3);
+  REQUIRE(created.size() == 3UL);
+  REQUIRE(em.size() == 3UL);
+  created[0].assign<Health>(1);
+  created[2].assign<Health>(3);
+
+  Entity stale = em.create();
+  Entity::Id stale_id = stale.id();
+  stale.destroy();
+  REQUIRE(receiver.destroyed == 1);
+
+  em.destroy(vector<Entity::Id>{ created[0].id(), stale_id, created[2].id() });
+  REQUIRE(receiver.batches == vector<size_t>({ 2 }));
+  REQUIRE(receiver.destroyed == 1);
+  REQUIRE(!created[0].valid());
+  REQUIRE(created[1].valid());
+  REQUIRE(!created[2].valid());
+  REQUIRE(em.size() == 1UL);
+  REQUIRE(size(em.entities_with_components<Health>()) == 0);
+
+  em.destroy(vector<Entity::Id>{ stale_id });
+  REQUIRE(receiver.batches.size() == 1UL);
+}
+
+TEST_CASE_METHOD(EntityManagerFixture, "TestResetEmitsPerEntityEvents") {
+  DestroyedEventsReceiver receiver;
+  ev.subscribe<EntityDestroyedEvent>(receiver);
+  ev.subscribe<EntitiesDestroyedEvent>(receiver);
+
+  em.create(4)[1].assign<Health>(2);
+  em.reset();
+  REQUIRE(receiver.destroyed == 4);
+  REQUIRE(receiver.batches.empty());
+  REQUIRE(em.size() == 0UL);
+}
+
+TEST_CASE_METHOD(EntityManagerFixture, "TestCommandBufferPlayback") {
+  Entity existing = em.create();
+  existing.assign<Health>(5);
+  Entity doomed = em.create();
+
+  EntityCommandBuffer commands;
+  auto first = commands.create();
+  auto second = commands.create();
+  commands.assign<Health>(first, 10);
+  commands.assign<Health>(second, 20);
+  commands.remove<Health>(existing.id());
+  commands.destroy(doomed.id());
+  commands.destroy(second);
+  REQUIRE(commands.size() == 7UL);
+  REQUIRE(em.size() == 2UL);
+  REQUIRE(existing.has_component<Health>());
+
+  auto created = commands.playback(em);
+  REQUIRE(commands.empty());
+  REQUIRE(created.size() == 2UL);
+  REQUIRE(created[0].valid());
+  REQUIRE(created[0].component<Health>().lock()->points == 10);
+  REQUIRE(!created[1].valid());
+  REQUIRE(!doomed.valid());
+  REQUIRE(!existing.has_component<Health>());
+  REQUIRE(em.size() == 2UL);
+
+  // commands on entities destroyed before playback are skipped
+  commands.assign<Health>(doomed.id(), 1);
+  commands.destroy(doomed.id());
+  REQUIRE(commands.playback(em).empty());
+  REQUIRE(em.size() == 2UL);
+}
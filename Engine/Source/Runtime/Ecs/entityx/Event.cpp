@@ -20,6 +20,7 @@ namespace entityx
 	}
 
 	EventManager::EventManager()
+		: queues_(max_queued_families)
 	{
 	}
 
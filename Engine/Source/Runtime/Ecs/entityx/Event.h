@@ -12,6 +12,11 @@
 
 #include <cstdint>
 #include <cstddef>
+#include <cassert>
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <type_traits>
 #include <vector>
 #include <list>
 #include <unordered_map>
@@ -62,6 +67,143 @@ namespace entityx
 	};
 
 
+	/**
+	 * A contiguous run of queued events of type E.
+	 *
+	 * Receivers subscribed with EventManager::subscribe_queued() implement
+	 * receive(EventSpan<E>). The events are only valid during the call.
+	 */
+	template <typename E>
+	struct EventSpan
+	{
+		const E *begin() const { return data; }
+		const E *end() const { return data + size; }
+
+		const E *data;
+		std::size_t size;
+	};
+
+
+	/// Used internally by the EventManager.
+	class BaseEventQueue
+	{
+	public:
+		virtual ~BaseEventQueue() {}
+
+		virtual bool empty() const = 0;
+
+		/// Hand every queued event to the receivers and clear the queue.
+		virtual void deliver(EventSignal *each, EventSignal *spans) = 0;
+	};
+
+
+	/**
+	 * Per type queue of events waiting for EventManager::deliver().
+	 *
+	 * Any number of threads may push concurrently. A push reserves a slot
+	 * with a single atomic increment and constructs the event in place, the
+	 * storage is a table of fixed size blocks that are allocated on first
+	 * use and kept for the following frames, so events never move and each
+	 * block is handed out as one span.
+	 */
+	template <typename E>
+	class EventQueue : public BaseEventQueue
+	{
+	public:
+		static const std::size_t block_size = 1024;
+		static const std::size_t max_blocks = 1024;
+
+		EventQueue() : blocks_(new std::atomic<Block*>[max_blocks])
+		{
+			for (std::size_t i = 0; i < max_blocks; ++i)
+				blocks_[i].store(nullptr, std::memory_order_relaxed);
+		}
+
+		~EventQueue()
+		{
+			clear(count_.load(std::memory_order_acquire));
+			for (std::size_t i = 0; i < max_blocks; ++i)
+				delete blocks_[i].load(std::memory_order_relaxed);
+		}
+
+		template <typename ... Args>
+		void push(Args && ... args)
+		{
+			const std::size_t index = count_.fetch_add(1, std::memory_order_acq_rel);
+			assert(index < block_size * max_blocks && "Too many queued events");
+			new (block(index / block_size)->data() + index % block_size) E(std::forward<Args>(args) ...);
+		}
+
+		bool empty() const override
+		{
+			return count_.load(std::memory_order_acquire) == 0;
+		}
+
+		void deliver(EventSignal *each, EventSignal *spans) override
+		{
+			// Receivers may queue more events of the same type, they are
+			// delivered in the same pass.
+			std::size_t delivered = 0;
+			for (std::size_t count = count_.load(std::memory_order_acquire); delivered < count;
+				count = count_.load(std::memory_order_acquire))
+			{
+				while (delivered < count)
+				{
+					const std::size_t offset = delivered % block_size;
+					const std::size_t size = std::min(block_size - offset, count - delivered);
+					const E *first = blocks_[delivered / block_size].load(std::memory_order_acquire)->data() + offset;
+					if (spans)
+					{
+						EventSpan<E> span{ first, size };
+						spans->emit(&span);
+					}
+					if (each)
+					{
+						for (std::size_t i = 0; i < size; ++i)
+							each->emit(first + i);
+					}
+					delivered += size;
+				}
+			}
+			clear(delivered);
+		}
+
+	private:
+		struct Block
+		{
+			E *data() { return reinterpret_cast<E*>(&slots[0]); }
+
+			typename std::aligned_storage<sizeof(E), alignof(E)>::type slots[block_size];
+		};
+
+		Block *block(std::size_t index)
+		{
+			Block *current = blocks_[index].load(std::memory_order_acquire);
+			if (current)
+				return current;
+
+			// Several producers may cross into a new block at once, the first
+			// one to publish its allocation wins.
+			Block *fresh = new Block;
+			if (blocks_[index].compare_exchange_strong(current, fresh, std::memory_order_acq_rel))
+				return fresh;
+
+			delete fresh;
+			return current;
+		}
+
+		void clear(std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+				blocks_[i / block_size].load(std::memory_order_relaxed)->data()[i % block_size].~E();
+			count_.store(0, std::memory_order_release);
+		}
+
+		std::unique_ptr<std::atomic<Block*>[]> blocks_;
+		std::atomic<std::size_t> count_{ 0 };
+	};
+
+
 	class BaseReceiver
 	{
 	public:
@@ -93,6 +235,12 @@ namespace entityx
 
 	private:
 		friend class EventManager;
+		/// Span subscriptions are keyed by the family with the top bit set.
+		static BaseEvent::Family span_key(BaseEvent::Family family)
+		{
+			return family | (BaseEvent::Family(1) << (sizeof(BaseEvent::Family) * 8 - 1));
+		}
+
 		std::unordered_map<BaseEvent::Family, std::pair<EventSignalWeakPtr, std::size_t>> connections_;
 	};
 
@@ -109,6 +257,9 @@ namespace entityx
 	 * Handles event subscription and delivery.
 	 *
 	 * Subscriptions are automatically removed when receivers are destroyed..
+	 *
+	 * Events are delivered synchronously by emit() unless their type is
+	 * queued, see queue().
 	 */
 	class EventManager : entityx::help::NonCopyable
 	{
@@ -164,9 +315,126 @@ namespace entityx
 			base.connections_.erase(Event<E>::family());
 		}
 
+		/**
+		 * Subscribe an object to receive queued events of type E in spans.
+		 *
+		 * Also switches E to queued delivery, see queue(). If E cannot be
+		 * queued, its events are delivered immediately as spans of one.
+		 * Receivers must implement a receive() method accepting an
+		 * EventSpan<E>.
+		 *
+		 * eg.
+		 *
+		 *     struct DebrisReceiver : public Receiver<DebrisReceiver> {
+		 *       void receive(EventSpan<Explosion> explosions) {
+		 *         for (const auto &explosion : explosions) ...
+		 *       }
+		 *     };
+		 *
+		 *     DebrisReceiver receiver;
+		 *     em.subscribe_queued<Explosion>(receiver);
+		 */
+		template <typename E, typename Receiver>
+		void subscribe_queued(Receiver &receiver)
+		{
+			void (Receiver::*receive)(EventSpan<E>) = &Receiver::receive;
+			std::function<void(EventSpan<E>)> callback = std::bind(receive, &receiver, std::placeholders::_1);
+			EventSignalPtr sig;
+			std::size_t connection;
+			if (queue<E>())
+			{
+				sig = span_signal_for(Event<E>::family());
+				connection = sig->connect(EventSpanCallbackWrapper<E>(callback));
+			}
+			else
+			{
+				sig = signal_for(Event<E>::family());
+				connection = sig->connect(EventCallbackWrapper<E>([callback](const E &event)
+				{
+					callback(EventSpan<E>{ &event, 1 });
+				}));
+			}
+			BaseReceiver &base = receiver;
+			base.connections_.insert(std::make_pair(BaseReceiver::span_key(Event<E>::family()), std::make_pair(EventSignalWeakPtr(sig), connection)));
+		}
+
+		/**
+		 * Unsubscribe an object from spans of queued events of type E.
+		 *
+		 * E stays queued.
+		 */
+		template <typename E, typename Receiver>
+		void unsubscribe_queued(Receiver &receiver)
+		{
+			BaseReceiver &base = receiver;
+			const auto key = BaseReceiver::span_key(Event<E>::family());
+			assert(base.connections_.find(key) != base.connections_.end());
+			auto pair = base.connections_[key];
+			auto &ptr = pair.first;
+			if (!ptr.expired())
+			{
+				ptr.lock()->disconnect(pair.second);
+			}
+			base.connections_.erase(key);
+		}
+
+		/**
+		 * Switch events of type E to queued delivery.
+		 *
+		 * emit<E>() then appends the event to a per type queue and returns
+		 * without calling any receiver. The queue accepts events from any
+		 * number of threads at once. deliver() hands them over, spans to
+		 * subscribe_queued() receivers and one at a time to subscribe()
+		 * receivers.
+		 *
+		 * Must be called before events of type E can be emitted concurrently,
+		 * typically when configuring the receivers.
+		 *
+		 * @returns false if the family of E is max_queued_families or more,
+		 * emit() then keeps delivering E immediately.
+		 */
+		template <typename E>
+		bool queue()
+		{
+			const auto family = Event<E>::family();
+			// the table is never resized, emitting threads read it unlocked
+			if (family >= queues_.size())
+				return false;
+			if (!queues_[family])
+				queues_[family].reset(new EventQueue<E>());
+			return true;
+		}
+
+		/**
+		 * Deliver the events queued since the last call.
+		 *
+		 * Must not overlap with threads emitting queued events. Types are
+		 * delivered in family order, events in the order their slots were
+		 * reserved. Events of an already delivered type that are emitted by
+		 * the receivers wait for the next call.
+		 */
+		void deliver()
+		{
+			for (std::size_t family = 0; family < queues_.size(); ++family)
+			{
+				auto &queue = queues_[family];
+				if (!queue || queue->empty())
+					continue;
+
+				EventSignal *each = family < handlers_.size() ? handlers_[family].get() : nullptr;
+				EventSignal *spans = family < span_handlers_.size() ? span_handlers_[family].get() : nullptr;
+				queue->deliver(each, spans);
+			}
+		}
+
 		template <typename E>
 		void emit(const E &event)
 		{
+			if (auto queue = queue_for<E>())
+			{
+				queue->push(event);
+				return;
+			}
 			auto sig = signal_for(Event<E>::family());
 			sig->emit(&event);
 		}
@@ -177,6 +445,11 @@ namespace entityx
 		template <typename E>
 		void emit(std::unique_ptr<E> event)
 		{
+			if (auto queue = queue_for<E>())
+			{
+				queue->push(std::move(*event));
+				return;
+			}
 			auto sig = signal_for(Event<E>::family());
 			sig->emit(event.get());
 		}
@@ -195,6 +468,11 @@ namespace entityx
 		template <typename E, typename ... Args>
 		void emit(Args && ... args)
 		{
+			if (auto queue = queue_for<E>())
+			{
+				queue->push(std::forward<Args>(args) ...);
+				return;
+			}
 			// Using 'E event(std::forward...)' causes VS to fail with an internal error. Hack around it.
 			E event = E(std::forward<Args>(args) ...);
 			auto sig = signal_for(std::size_t(Event<E>::family()));
@@ -208,10 +486,34 @@ namespace entityx
 			{
 				if (handler) size += handler->size();
 			}
+			for (EventSignalPtr handler : span_handlers_)
+			{
+				if (handler) size += handler->size();
+			}
 			return size;
 		}
 
 	private:
+		static const std::size_t max_queued_families = 256;
+
+		template <typename E>
+		EventQueue<E> *queue_for()
+		{
+			const auto family = Event<E>::family();
+			if (family >= queues_.size())
+				return nullptr;
+			return static_cast<EventQueue<E>*>(queues_[family].get());
+		}
+
+		EventSignalPtr &span_signal_for(std::size_t id)
+		{
+			if (id >= span_handlers_.size())
+				span_handlers_.resize(id + 1);
+			if (!span_handlers_[id])
+				span_handlers_[id] = std::make_shared<EventSignal>();
+			return span_handlers_[id];
+		}
+
 		EventSignalPtr &signal_for(std::size_t id)
 		{
 			if (id >= handlers_.size())
@@ -230,7 +532,20 @@ namespace entityx
 			std::function<void(const E &)> callback;
 		};
 
+		// Functor used as a span signal callback that casts to EventSpan<E>.
+		template <typename E>
+		struct EventSpanCallbackWrapper
+		{
+			explicit EventSpanCallbackWrapper(std::function<void(EventSpan<E>)> callback) : callback(callback) {}
+			void operator()(const void *span) { callback(*(static_cast<const EventSpan<E>*>(span))); }
+			std::function<void(EventSpan<E>)> callback;
+		};
+
 		std::vector<EventSignalPtr> handlers_;
+		std::vector<EventSignalPtr> span_handlers_;
+		/// Queues of the queued event types, sized once so emitting threads
+		/// can look them up without locking.
+		std::vector<std::unique_ptr<BaseEventQueue>> queues_;
 	};
 
 }  // namespace entityx
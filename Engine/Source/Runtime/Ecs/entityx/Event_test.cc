@@ -11,6 +11,7 @@
 #define CATCH_CONFIG_MAIN
 
 #include <string>
+#include <utility>
 #include <vector>
 #include "entityx/3rdparty/catch.hpp"
 #include "entityx/Event.h"
@@ -18,6 +19,8 @@
 
 using entityx::EventManager;
 using entityx::Event;
+using entityx::EventQueue;
+using entityx::EventSpan;
 using entityx::Receiver;
 
 
@@ -113,3 +116,80 @@ TEST_CASE("TestUnsubscription") {
     REQUIRE(explosion_system.damage_received == 1);
   }
 }
+
+struct DebrisSystem : public Receiver<DebrisSystem> {
+  void receive(EventSpan<Explosion> explosions) {
+    spans.push_back(explosions.size);
+    for (const auto &explosion : explosions) damages.push_back(explosion.damage);
+  }
+
+  std::vector<std::size_t> spans;
+  std::vector<int> damages;
+};
+
+TEST_CASE("TestQueuedDelivery") {
+  EventManager em;
+  ExplosionSystem explosion_system;
+  REQUIRE(em.queue<Explosion>());
+  em.subscribe<Explosion>(explosion_system);
+  em.emit<Explosion>(1);
+  em.emit<Explosion>(2);
+  REQUIRE(0 == explosion_system.received_count);
+  em.deliver();
+  REQUIRE(2 == explosion_system.received_count);
+  REQUIRE(3 == explosion_system.damage_received);
+  em.deliver();
+  REQUIRE(2 == explosion_system.received_count);
+}
+
+TEST_CASE("TestQueuedSpanOrdering") {
+  EventManager em;
+  DebrisSystem debris_system;
+  ExplosionSystem explosion_system;
+  em.subscribe_queued<Explosion>(debris_system);
+  em.subscribe<Explosion>(explosion_system);
+  const int count = int(EventQueue<Explosion>::block_size) + 10;
+  for (int i = 0; i < count; ++i) em.emit<Explosion>(i);
+  REQUIRE(debris_system.damages.empty());
+  em.deliver();
+  REQUIRE(debris_system.spans == std::vector<std::size_t>({ EventQueue<Explosion>::block_size, 10 }));
+  REQUIRE(int(debris_system.damages.size()) == count);
+  for (int i = 0; i < count; ++i) REQUIRE(debris_system.damages[i] == i);
+  REQUIRE(count == explosion_system.received_count);
+}
+
+template <std::size_t N>
+struct Filler {};
+
+template <std::size_t ... N>
+void use_families(std::index_sequence<N ...>) {
+  (void)std::initializer_list<int>{ ((void)Event<Filler<N>>::family(), 0) ... };
+}
+
+struct Overflow {
+  explicit Overflow(int damage) : damage(damage) {}
+  int damage;
+};
+
+struct OverflowSystem : public Receiver<OverflowSystem> {
+  void receive(EventSpan<Overflow> overflows) {
+    spans.push_back(overflows.size);
+  }
+
+  std::vector<std::size_t> spans;
+};
+
+TEST_CASE("TestQueuedFallsBackToImmediate") {
+  // push the family of Overflow past the queue table
+  use_families(std::make_index_sequence<256>());
+  EventManager em;
+  OverflowSystem overflow_system;
+  REQUIRE(!em.queue<Overflow>());
+  em.subscribe_queued<Overflow>(overflow_system);
+  em.emit<Overflow>(1);
+  em.emit<Overflow>(2);
+  REQUIRE(overflow_system.spans == std::vector<std::size_t>({ 1, 1 }));
+  em.unsubscribe_queued<Overflow>(overflow_system);
+  em.emit<Overflow>(3);
+  REQUIRE(overflow_system.spans.size() == 2);
+}
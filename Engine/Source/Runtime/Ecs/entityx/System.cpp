@@ -9,6 +9,7 @@
  */
 
 #include "System.h"
+#include "../../Threading/ThreadPool.h"
 
 namespace entityx
 {
@@ -21,44 +22,148 @@ namespace entityx
 
 	void SystemManager::frameBegin(TimeDelta dt)
 	{
-		assert(initialized_ && "SystemManager::configure() not called");
-		for (auto &pair : systems_)
+		run_phase(&BaseSystem::frameBegin, dt);
+	}
+
+	void SystemManager::frameUpdate(TimeDelta dt)
+	{
+		run_phase(&BaseSystem::frameUpdate, dt);
+	}
+	void SystemManager::frameRender(TimeDelta dt)
+	{
+		run_phase(&BaseSystem::frameRender, dt);
+	}
+	void SystemManager::frameEnd(TimeDelta dt)
+	{
+		run_phase(&BaseSystem::frameEnd, dt);
+	}
+
+	void SystemManager::build_graph()
+	{
+		const size_t count = ordered_.size();
+		dependents_.assign(count, {});
+		dependency_counts_.assign(count, 0);
+		remaining_.reset(new std::atomic<size_t>[count]);
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			pair.second->frameBegin(entity_manager_, event_manager_, dt);
+			for (size_t j = i + 1; j < count; ++j)
+			{
+				if (ordered_[i]->access().conflicts(ordered_[j]->access()))
+				{
+					dependents_[i].push_back(j);
+					++dependency_counts_[j];
+				}
+			}
 		}
+
+		graph_dirty_ = false;
 	}
 
-	void SystemManager::frameUpdate(TimeDelta dt)
+	void SystemManager::run_phase(Phase phase, TimeDelta dt)
 	{
 		assert(initialized_ && "SystemManager::configure() not called");
-		for (auto &pair : systems_)
+
+		if (!thread_pool_ || thread_pool_->getWorkerCount() == 0)
+		{
+			for (auto &system : ordered_)
+			{
+				((*system).*phase)(entity_manager_, event_manager_, dt);
+			}
+			playback_commands();
+			event_manager_.deliver();
+			return;
+		}
+
+		if (graph_dirty_)
+			build_graph();
+
+		const size_t count = ordered_.size();
+		PhaseRun run;
+		run.phase = phase;
+		run.dt = dt;
+		run.finished = 0;
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			pair.second->frameUpdate(entity_manager_, event_manager_, dt);
+			remaining_[i] = dependency_counts_[i];
 		}
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (dependency_counts_[i] == 0)
+				dispatch(run, i);
+		}
+
+		// The main thread runs the systems bound to it and helps with the
+		// pool's work otherwise.
+		while (run.finished < count)
+		{
+			size_t index = count;
+			{
+				std::lock_guard<std::mutex> lock(run.main_thread_mutex);
+				if (!run.main_thread_ready.empty())
+				{
+					index = run.main_thread_ready.back();
+					run.main_thread_ready.pop_back();
+				}
+			}
+
+			if (index != count)
+				execute(run, index);
+			else if (!thread_pool_->tryExecute())
+				std::this_thread::yield();
+		}
+
+		playback_commands();
+		event_manager_.deliver();
 	}
-	void SystemManager::frameRender(TimeDelta dt)
+
+	void SystemManager::playback_commands()
 	{
-		assert(initialized_ && "SystemManager::configure() not called");
-		for (auto &pair : systems_)
+		// registration order keeps the result independent of the scheduling
+		for (auto &system : ordered_)
 		{
-			pair.second->frameRender(entity_manager_, event_manager_, dt);
+			if (!system->commands_.empty())
+				system->commands_.playback(entity_manager_);
 		}
 	}
-	void SystemManager::frameEnd(TimeDelta dt)
+
+	void SystemManager::dispatch(PhaseRun &run, size_t index)
 	{
-		assert(initialized_ && "SystemManager::configure() not called");
-		for (auto &pair : systems_)
+		if (ordered_[index]->access().main_thread)
 		{
-			pair.second->frameEnd(entity_manager_, event_manager_, dt);
+			std::lock_guard<std::mutex> lock(run.main_thread_mutex);
+			run.main_thread_ready.push_back(index);
+			return;
 		}
+
+		thread_pool_->schedule([this, &run, index]()
+		{
+			execute(run, index);
+		});
+	}
+
+	void SystemManager::execute(PhaseRun &run, size_t index)
+	{
+		((*ordered_[index]).*run.phase)(entity_manager_, event_manager_, run.dt);
+
+		for (auto dependent : dependents_[index])
+		{
+			if (--remaining_[dependent] == 0)
+				dispatch(run, dependent);
+		}
+
+		// last access to the run, the main thread may return right after this
+		++run.finished;
 	}
 
 
 	void SystemManager::configure()
 	{
-		for (auto &pair : systems_)
+		for (auto &system : ordered_)
 		{
-			pair.second->configure(entity_manager_, event_manager_);
+			system->configure(entity_manager_, event_manager_);
 		}
 		initialized_ = true;
 	}
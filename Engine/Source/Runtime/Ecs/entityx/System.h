@@ -14,15 +14,51 @@
 #include <unordered_map>
 #include <utility>
 #include <cassert>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
 #include "config.h"
 #include "Entity.h"
 #include "Event.h"
+#include "CommandBuffer.h"
 #include "help/NonCopyable.h"
 
+class ThreadPool;
 
 namespace entityx
 {
 	class SystemManager;
+
+	/**
+	 * Component access declared by a System.
+	 *
+	 * Systems that do not declare anything are exclusive: they run on the main
+	 * thread and never overlap with any other system.
+	 */
+	struct SystemAccess
+	{
+		/// Components the system only reads.
+		EntityManager::ComponentMask reads;
+		/// Components the system modifies.
+		EntityManager::ComponentMask writes;
+		/// Whether the system conflicts with every other system.
+		bool exclusive = true;
+		/// Whether the system must run on the main thread (eg. it talks to the renderer).
+		bool main_thread = true;
+
+		/**
+		 * Two systems conflict if either of them is exclusive or one writes a
+		 * component the other one touches.
+		 */
+		bool conflicts(const SystemAccess &other) const
+		{
+			return exclusive || other.exclusive
+				|| (writes & (other.reads | other.writes)).any()
+				|| (other.writes & reads).any();
+		}
+	};
+
 	/**
 	 * Base System class. Generally should not be directly used, instead see System<Derived>.
 	 */
@@ -58,9 +94,66 @@ namespace entityx
 		virtual void frameRender(EntityManager &entities, EventManager &events, TimeDelta dt) = 0;
 		virtual void frameEnd(EntityManager &entities, EventManager &events, TimeDelta dt) = 0;
 
+		/**
+		 * Component access used by the SystemManager to schedule this system.
+		 */
+		const SystemAccess &access() const { return access_; }
+
 		static Family family_counter_;
 
 	protected:
+		/**
+		 * Declare components the system reads. Call from the constructor.
+		 *
+		 * Once a system declares its access it may be run on a worker thread,
+		 * so it must not create, destroy or change components of entities, nor
+		 * emit events other than queued ones (see EventManager::queue()).
+		 * Record such changes into commands() instead, or use
+		 * main_thread_only() if it needs the main thread.
+		 */
+		template <typename ... Components>
+		void reads()
+		{
+			int expand[] = { 0, (access_.reads.set(Components::getId()), 0)... };
+			(void)expand;
+			access_.exclusive = false;
+			access_.main_thread = false;
+		}
+
+		/**
+		 * Declare components the system writes. Call from the constructor.
+		 */
+		template <typename ... Components>
+		void writes()
+		{
+			int expand[] = { 0, (access_.writes.set(Components::getId()), 0)... };
+			(void)expand;
+			access_.exclusive = false;
+			access_.main_thread = false;
+		}
+
+		/**
+		 * Keep the system on the main thread while still letting other systems
+		 * run next to it.
+		 */
+		void main_thread_only()
+		{
+			access_.main_thread = true;
+		}
+
+		/**
+		 * Structural changes recorded by the system. The SystemManager plays
+		 * them back on the main thread once every system finished the phase,
+		 * in system registration order. Queued events are delivered right
+		 * after.
+		 */
+		EntityCommandBuffer &commands() { return commands_; }
+
+	private:
+		friend class SystemManager;
+
+		SystemAccess access_;
+		EntityCommandBuffer commands_;
 	};
 
 
@@ -115,7 +208,12 @@ namespace entityx
 		template <typename S>
 		void add(std::shared_ptr<S> system)
 		{
-			systems_.insert(std::make_pair(S::family(), system));
+			auto result = systems_.insert(std::make_pair(S::family(), system));
+			if (result.second)
+			{
+				ordered_.push_back(system);
+				graph_dirty_ = true;
+			}
 		}
 
 		/**
@@ -163,15 +261,12 @@ namespace entityx
 		}
 
 		/**
-		 * Call System::update() on all registered systems.
+		 * Call the frame methods on all registered systems.
 		 *
-		 * The order which the registered systems are updated is arbitrary but consistent,
-		 * meaning the order which they will be updated cannot be specified, but that order
-		 * will stay the same as long no systems are added or removed.
-		 *
-		 * If the order in which systems update is important, use SystemManager::update()
-		 * to manually specify the update order. EntityX does not yet support a way of
-		 * specifying priority for update_all().
+		 * A system that conflicts with an earlier registered one (see SystemAccess)
+		 * always runs after it, so for conflicting systems the registration order
+		 * is the update order. Systems that do not conflict are run at the same time
+		 * on the worker threads of the thread pool, if one was set.
 		 */
 		void frameBegin(TimeDelta dt);
 		void frameUpdate(TimeDelta dt);
@@ -184,11 +279,50 @@ namespace entityx
 		 */
 		void configure();
 
+		/**
+		 * Set the thread pool used to run systems in parallel. Without one all
+		 * systems are run on the calling thread in registration order.
+		 */
+		void set_thread_pool(ThreadPool *thread_pool)
+		{
+			thread_pool_ = thread_pool;
+		}
+
 	private:
+		typedef void (BaseSystem::*Phase)(EntityManager &, EventManager &, TimeDelta);
+
+		/**
+		 * State shared by the systems executed in one phase.
+		 */
+		struct PhaseRun
+		{
+			Phase phase;
+			TimeDelta dt;
+			std::atomic<size_t> finished;
+			std::mutex main_thread_mutex;
+			std::vector<size_t> main_thread_ready;
+		};
+
+		void run_phase(Phase phase, TimeDelta dt);
+		void playback_commands();
+		void build_graph();
+		void dispatch(PhaseRun &run, size_t index);
+		void execute(PhaseRun &run, size_t index);
+
 		bool initialized_ = false;
 		EntityManager &entity_manager_;
 		EventManager &event_manager_;
 		std::unordered_map<BaseSystem::Family, std::shared_ptr<BaseSystem>> systems_;
+		/// Systems in registration order.
+		std::vector<std::shared_ptr<BaseSystem>> ordered_;
+		/// For each system the later registered systems that conflict with it.
+		std::vector<std::vector<size_t>> dependents_;
+		/// Number of earlier systems each system has to wait for.
+		std::vector<size_t> dependency_counts_;
+		/// Per phase countdown of the dependencies still running.
+		std::unique_ptr<std::atomic<size_t>[]> remaining_;
+		bool graph_dirty_ = true;
+		ThreadPool *thread_pool_ = nullptr;
 	};
 
 }  // namespace entityx
@@ -9,10 +9,13 @@
  */
 
 #include "Storage.h"
+#include <algorithm>
 
 namespace entityx
 {
 
+	const std::uint32_t ComponentStorage::invalid;
+
 	ComponentStorage::ComponentStorage(std::size_t size)
 	{
 		expand(size);
@@ -26,41 +29,124 @@ namespace entityx
 
 	void ComponentStorage::expand(std::size_t n)
 	{
-		data.resize(n);
+		if (n > sparse_.size())
+			sparse_.resize(n, invalid);
 	}
 
 
 	void ComponentStorage::reserve(std::size_t n)
 	{
-		data.reserve(n);
+		sparse_.reserve(n);
+		entities_.reserve(n);
+		components_.reserve(n);
+		owners_.reserve(n);
 	}
 
 
 	std::shared_ptr<Component> ComponentStorage::get(std::size_t n)
 	{
 		assert(n < size());
-		return data[n];
+		return has(n) ? owners_[sparse_[n]] : nullptr;
 	}
 
 
 	const std::shared_ptr<Component> ComponentStorage::get(std::size_t n) const
 	{
 		assert(n < size());
-		return data[n];
+		return has(n) ? owners_[sparse_[n]] : nullptr;
 	}
 
 
 	void ComponentStorage::destroy(std::size_t n)
 	{
 		assert(n < size());
-		auto& element = data[n];
+		if (!has(n))
+			return;
+
+		const std::uint32_t slot = sparse_[n];
+		if (locks_ > 0)
+		{
+			// Slots ahead of an iteration must not move, leave a hole.
+			sparse_[n] = invalid;
+			entities_[slot] = invalid;
+			components_[slot] = nullptr;
+			holes_.push_back(slot);
+			auto element = std::move(owners_[slot]);
+			element.reset();
+			return;
+		}
+
+		// Move the last element into the freed slot to keep the arrays packed.
+		const std::uint32_t last = static_cast<std::uint32_t>(components_.size() - 1);
+		if (slot != last)
+		{
+			entities_[slot] = entities_[last];
+			components_[slot] = components_[last];
+			owners_[slot] = std::move(owners_[last]);
+			sparse_[entities_[slot]] = slot;
+		}
+
+		sparse_[n] = invalid;
+		entities_.pop_back();
+		components_.pop_back();
+		// Release after the arrays are consistent, the destructor may call back into us.
+		auto element = std::move(owners_.back());
+		owners_.pop_back();
 		element.reset();
 	}
 
 
+	void ComponentStorage::unlock()
+	{
+		assert(locks_ > 0);
+		if (--locks_ == 0 && !holes_.empty())
+			compact();
+	}
+
+
+	void ComponentStorage::compact()
+	{
+		// Fill the holes from the back of the arrays, trailing holes are dropped.
+		std::sort(holes_.begin(), holes_.end());
+		std::size_t filled = 0;
+		while (filled < holes_.size())
+		{
+			const std::uint32_t last = static_cast<std::uint32_t>(components_.size() - 1);
+			if (holes_.back() != last)
+			{
+				const std::uint32_t slot = holes_[filled++];
+				entities_[slot] = entities_[last];
+				components_[slot] = components_[last];
+				owners_[slot] = std::move(owners_[last]);
+				sparse_[entities_[slot]] = slot;
+			}
+			else
+			{
+				holes_.pop_back();
+			}
+			entities_.pop_back();
+			components_.pop_back();
+			owners_.pop_back();
+		}
+		holes_.clear();
+	}
+
+
 	std::weak_ptr<Component> ComponentStorage::set(unsigned int index, std::shared_ptr<Component> component)
 	{
-		data[index] = component;
+		expand(index + 1);
+		if (has(index))
+		{
+			const std::uint32_t slot = sparse_[index];
+			components_[slot] = component.get();
+			owners_[slot] = component;
+			return component;
+		}
+
+		sparse_[index] = static_cast<std::uint32_t>(components_.size());
+		entities_.push_back(index);
+		components_.push_back(component.get());
+		owners_.push_back(component);
 		return component;
 	}
 
@@ -11,13 +11,116 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <cassert>
 #include <vector>
 #include <memory>
+#include <mutex>
+#include "Core/common/spin.hpp"
+#include "Core/memory/memory_pool.hpp"
 
 namespace entityx {
 
 	class Component;
+
+	/**
+	 * Memory pool shared by the allocators of one component type.
+	 */
+	struct ComponentPoolState
+	{
+		core::spin_mutex mutex;
+		std::unique_ptr<core::MemoryPool> pool;
+		std::size_t block_size = 0;
+	};
+
+	/**
+	 * Allocates the components of one type from a memory pool shared by every
+	 * allocator of that type, so components created through
+	 * EntityManager::assign<C>() are packed next to each other in memory.
+	 *
+	 * The pool is kept alive by the allocators stored in the shared_ptr
+	 * control blocks, so handles may outlive the EntityManager.
+	 */
+	template <typename T>
+	class ComponentAllocator
+	{
+	public:
+		typedef T value_type;
+
+		ComponentAllocator() : state_(type_state()) {}
+
+		template <typename U>
+		ComponentAllocator(const ComponentAllocator<U> &other) : state_(other.state_) {}
+
+		T *allocate(std::size_t n)
+		{
+			const std::size_t bytes = n * sizeof(T);
+			if (n == 1 && alignof(T) <= alignof(std::max_align_t))
+			{
+				std::lock_guard<core::spin_mutex> lock(state_->mutex);
+				if (!state_->pool)
+				{
+					state_->pool.reset(new core::MemoryPool(bytes, ChunkSize));
+					state_->block_size = bytes;
+				}
+
+				if (state_->block_size == bytes)
+				{
+					if (void *block = state_->pool->malloc())
+						return static_cast<T*>(block);
+				}
+			}
+			return static_cast<T*>(::operator new(bytes));
+		}
+
+		void deallocate(T *p, std::size_t n)
+		{
+			const std::size_t bytes = n * sizeof(T);
+			if (n == 1)
+			{
+				// blocks from operator new, eg. when the pool could not grow,
+				// are outside every chunk of the pool
+				std::lock_guard<core::spin_mutex> lock(state_->mutex);
+				if (state_->pool && state_->block_size == bytes && state_->pool->free(p))
+					return;
+			}
+			::operator delete(p);
+		}
+
+		template <typename U>
+		bool operator == (const ComponentAllocator<U> &other) const { return state_ == other.state_; }
+		template <typename U>
+		bool operator != (const ComponentAllocator<U> &other) const { return state_ != other.state_; }
+
+	private:
+		template <typename U> friend class ComponentAllocator;
+
+		/// Components per pool chunk.
+		static const std::size_t ChunkSize = 512;
+
+		static const std::shared_ptr<ComponentPoolState> &type_state()
+		{
+			static const std::shared_ptr<ComponentPoolState> state = std::make_shared<ComponentPoolState>();
+			return state;
+		}
+
+		std::shared_ptr<ComponentPoolState> state_;
+	};
+
+	/**
+	 * Storage for the components of one type, laid out as a sparse set.
+	 *
+	 * The sparse array maps an entity index to a slot in the dense arrays,
+	 * which hold the entity indices and raw component pointers packed
+	 * together, so iteration never touches a reference count. Ownership is
+	 * kept in a parallel array of shared_ptrs so ComponentHandle stays a
+	 * stable weak reference.
+	 *
+	 * While the storage is locked for an iteration, destroyed components
+	 * leave a hole instead of moving the last one, so the slots not visited
+	 * yet stay in place. The holes are filled by the last unlock().
+	 */
 	class ComponentStorage
 	{
 	public:
@@ -25,14 +128,31 @@ namespace entityx {
 
 		~ComponentStorage();
 
-		std::size_t size() const { return data.size(); }
-		std::size_t capacity() const { return data.capacity(); }
+		/// Number of entity slots the storage can address.
+		std::size_t size() const { return sparse_.size(); }
+		std::size_t capacity() const { return sparse_.capacity(); }
+
+		/// Number of stored components.
+		std::size_t count() const { return components_.size() - holes_.size(); }
+
+		/// Number of dense slots, holes included.
+		std::size_t slot_count() const { return components_.size(); }
+
+		/// Keep the dense slots in place until the matching unlock().
+		void lock() { ++locks_; }
+		void unlock();
 
 		/// Ensure at least n elements will fit in the pool.
 		void expand(std::size_t n);
 
 		void reserve(std::size_t n);
 
+		/// Whether the entity slot n holds a component.
+		bool has(std::size_t n) const
+		{
+			return n < sparse_.size() && sparse_[n] != invalid;
+		}
+
 		std::shared_ptr<Component> get(std::size_t n);
 
 		const std::shared_ptr<Component> get(std::size_t n) const;
@@ -52,22 +172,59 @@ namespace entityx {
 			return std::static_pointer_cast<T>(get(n));
 		}
 
+		/// Raw access to the component of entity slot n, nullptr if there is none.
+		Component *get_ptr(std::size_t n) const
+		{
+			return has(n) ? components_[sparse_[n]] : nullptr;
+		}
+
+		template<typename T>
+		T *get_ptr(std::size_t n) const
+		{
+			static_assert(std::is_base_of<Component, T>::value, "Invalid component type.");
+
+			return static_cast<T*>(get_ptr(n));
+		}
+
+		/// Densely packed entity indices, slot_count() elements. Holes are
+		/// marked with the invalid index.
+		const std::uint32_t *entities() const { return entities_.data(); }
+
+		/// Densely packed components matching entities(), nullptr for holes.
+		Component *const *components() const { return components_.data(); }
+
+		static const std::uint32_t invalid = 0xffffffff;
+
 		virtual void destroy(std::size_t n);
 
 
 		template <typename T, typename ... Args>
 		std::weak_ptr<T> set(unsigned int index, Args && ... args)
 		{
-			auto element = std::make_shared<T>(std::forward<Args>(args) ...);
-			data[index] = std::move(element);
-			return std::static_pointer_cast<T>(data[index]);
+			auto element = std::allocate_shared<T>(ComponentAllocator<T>(), std::forward<Args>(args) ...);
+			set(index, element);
+			return element;
 		}
 
 		std::weak_ptr<Component> set(unsigned int index, std::shared_ptr<Component> component);
 
 
 	private:
-		std::vector<std::shared_ptr<Component>> data;
+		/// Fill the holes left while locked.
+		void compact();
+
+		/// Entity index to dense slot.
+		std::vector<std::uint32_t> sparse_;
+		/// Dense slot to entity index.
+		std::vector<std::uint32_t> entities_;
+		/// Dense slot to component, used for iteration.
+		std::vector<Component*> components_;
+		/// Dense slot to owning pointer.
+		std::vector<std::shared_ptr<Component>> owners_;
+		/// Dense slots emptied while locked.
+		std::vector<std::uint32_t> holes_;
+		/// Number of iterations in progress.
+		std::uint32_t locks_ = 0;
 	};
 
 }  // namespace entityx
@@ -6,6 +6,8 @@
 #include "../../Assets/AssetHandle.h"
 #include "../../Assets/AssetManager.h"
 #include "../../System/Application.h"
+#include "../../Ecs/Utils.h"
+#include "../../Assets/TextureStreamer.h"
 
 #include "../../Rendering/Mesh.h"
 #include "../../Rendering/Texture.h"
@@ -20,12 +22,17 @@ inline void loadAsset(AssetHandle<T>& obj, const std::string& id, bool async)
 	}
 	else
 	{
-		auto& app = Singleton<Application>::getInstance();
-		auto& manager = app.getAssetManager();
-		manager.load<T>(id, false)
-			.then([&obj](auto asset) mutable
+		// the asset manager is main thread only, loads made while a scene is
+		// deserialized on a worker are run when it is merged
+		ecs::utils::runOnMainThread([&obj, id]()
 		{
-			obj = asset;
+			auto& app = Singleton<Application>::getInstance();
+			auto& manager = app.getAssetManager();
+			manager.load<T>(id, false)
+				.then([&obj](auto asset) mutable
+			{
+				obj = asset;
+			});
 		});
 	}
 }
@@ -75,6 +82,15 @@ namespace cereal
 			cereal::make_nvp("link", obj.link)
 		);
 
+		// textures are serialized by materials, the renderer asks for their mips
+		const auto id = obj.link->id;
+		if (!id.empty())
+		{
+			ecs::utils::runOnMainThread([id]()
+			{
+				Singleton<Application>::getInstance().getTextureStreamer().setStreamed(id);
+			});
+		}
 		loadAsset(obj, obj.link->id, true);
 	}
 
@@ -85,6 +101,15 @@ namespace cereal
 			cereal::make_nvp("link", obj.link)
 		);
 
+		// meshes of occluders keep their triangles, marked before they load
+		const auto id = obj.link->id;
+		if (!id.empty() && ecs::utils::isLoadingOccluder())
+		{
+			ecs::utils::runOnMainThread([id]()
+			{
+				Singleton<Application>::getInstance().getAssetManager().setOccluderMesh(id);
+			});
+		}
 		loadAsset(obj, obj.link->id, true);
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "../../../Ecs/Components/ModelComponent.h"
+#include "../../../Ecs/Utils.h"
 #include "Core/reflection/reflection.h"
 #include "Core/serialization/serialization.h"
 #include "Core/serialization/cereal/types/vector.hpp"
@@ -21,6 +22,9 @@ REFLECT(ModelComponent)
 		.property("Casts Reflection",
 			&ModelComponent::castsReflection,
 			&ModelComponent::setCastReflelction)
+		.property("Occluder",
+			&ModelComponent::isOccluder,
+			&ModelComponent::setOccluder)
 		.property("Model",
 			&ModelComponent::getModel,
 			&ModelComponent::setModel)
@@ -28,27 +32,44 @@ REFLECT(ModelComponent)
 }
 
 
-SAVE(ModelComponent)
+// version 1 added the occluder flag
+CEREAL_CLASS_VERSION(ModelComponent, 1);
+
+SAVE_VERSIONED(ModelComponent)
 {
 	ar(
 		cereal::make_nvp("base_type", cereal::base_class<ecs::Component>(&obj)),
 		cereal::make_nvp("static", obj.mStatic),
 		cereal::make_nvp("casts_shadow", obj.mCastShadow),
 		cereal::make_nvp("casts_reflection", obj.mCastReflection),
+		cereal::make_nvp("occluder", obj.mOccluder),
 		cereal::make_nvp("model", obj.mModel)
 	);
 }
 
 
-LOAD(ModelComponent)
+LOAD_VERSIONED(ModelComponent)
 {
 	ar(
 		cereal::make_nvp("base_type", cereal::base_class<ecs::Component>(&obj)),
 		cereal::make_nvp("static", obj.mStatic),
 		cereal::make_nvp("casts_shadow", obj.mCastShadow),
-		cereal::make_nvp("casts_reflection", obj.mCastReflection),
+		cereal::make_nvp("casts_reflection", obj.mCastReflection)
+	);
+
+	if (version >= 1)
+	{
+		ar(
+			cereal::make_nvp("occluder", obj.mOccluder)
+		);
+	}
+
+	// the lods of occluders keep a cpu copy of their triangles
+	const bool previous = ecs::utils::setLoadingOccluder(obj.mOccluder);
+	ar(
 		cereal::make_nvp("model", obj.mModel)
 	);
+	ecs::utils::setLoadingOccluder(previous);
 }
 
 
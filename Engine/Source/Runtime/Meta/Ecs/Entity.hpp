@@ -8,11 +8,18 @@
 
 inline std::map<uint32_t, Entity>& getSerializationMap()
 {
-	/// Keep count of serialized entities
-	static std::map<uint32_t, Entity> serializationMap;
+	/// Keep count of serialized entities, per thread so loads can run on workers
+	static thread_local std::map<uint32_t, Entity> serializationMap;
 	return serializationMap;
 }
 
+inline EntityManager*& getSerializationTarget()
+{
+	/// Entity manager deserialized entities are created in, the world when null
+	static thread_local EntityManager* serializationTarget = nullptr;
+	return serializationTarget;
+}
+
 
 namespace entityx
 {
@@ -47,8 +54,6 @@ LOAD(Entity)
 	);
 
 	
-	auto& app = Singleton<Application>::getInstance();
-	auto& world = app.getWorld();
 	auto& serializationMap = getSerializationMap();
 	auto it = serializationMap.find(id);
 	if (it != serializationMap.end())
@@ -57,7 +62,11 @@ LOAD(Entity)
 	}
 	else
 	{
-		obj = world.entities.create();
+		auto target = getSerializationTarget();
+		if (!target)
+			target = &Singleton<Application>::getInstance().getWorld().entities;
+
+		obj = target->create();
 		serializationMap[id] = obj;
 
 		ar(
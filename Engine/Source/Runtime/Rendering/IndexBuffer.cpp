@@ -11,6 +11,7 @@ void IndexBuffer::dispose()
 		gfx::destroyIndexBuffer(handle);
 
 	handle = { bgfx::invalidHandle };
+	size = 0;
 }
 
 bool IndexBuffer::isValid() const
@@ -21,5 +22,8 @@ bool IndexBuffer::isValid() const
 void IndexBuffer::populate(const gfx::Memory* _mem, std::uint16_t _flags /*= BGFX_BUFFER_NONE*/)
 {
 	dispose();
+	// bgfx owns the memory once the buffer is created
+	const auto memSize = _mem ? _mem->size : 0;
 	handle = gfx::createIndexBuffer(_mem, _flags);
+	size = memSize;
 }
@@ -46,4 +46,6 @@ struct IndexBuffer
 
 	/// Internal handle
 	gfx::IndexBufferHandle handle = { gfx::invalidHandle };
+	/// Size of the data in bytes
+	std::uint32_t size = 0;
 };
\ No newline at end of file
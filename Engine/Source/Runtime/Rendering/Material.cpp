@@ -5,6 +5,8 @@
 
 #include "../System/Application.h"
 #include "../Assets/AssetManager.h"
+#include "Core/logging/logging.h"
+#include <algorithm>
 
 Material::Material()
 {
@@ -29,27 +31,27 @@ Material::~Material()
 
 }
 
-void Material::setTexture(std::uint8_t _stage, const std::string& _sampler, gfx::TextureHandle _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Material::setTexture(std::uint8_t _stage, const UniformId& _sampler, gfx::TextureHandle _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	mProgram->setTexture(_stage, _sampler, _texture, _flags);
 }
 
-void Material::setTexture(std::uint8_t _stage, const std::string& _sampler, Texture* _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Material::setTexture(std::uint8_t _stage, const UniformId& _sampler, Texture* _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	mProgram->setTexture(_stage, _sampler, _texture, _flags);
 }
 
-void Material::setTexture(std::uint8_t _stage, const std::string& _sampler, gfx::FrameBufferHandle _handle, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Material::setTexture(std::uint8_t _stage, const UniformId& _sampler, gfx::FrameBufferHandle _handle, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	mProgram->setTexture(_stage, _sampler, _handle, _attachment, _flags);
 }
 
-void Material::setTexture(std::uint8_t _stage, const std::string& _sampler, FrameBuffer* _handle, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Material::setTexture(std::uint8_t _stage, const UniformId& _sampler, FrameBuffer* _handle, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	mProgram->setTexture(_stage, _sampler, _handle, _attachment, _flags);
 }
 
-void Material::setUniform(const std::string& _name, const void* _value, std::uint16_t _num /*= 1*/)
+void Material::setUniform(const UniformId& _name, const void* _value, std::uint16_t _num /*= 1*/)
 {
 	mProgram->setUniform(_name, _value, _num);
 }
@@ -84,6 +86,9 @@ void Material::beginPass()
 {
 	if (isValid())
 		mProgram->beginPass();
+
+	if (mProgramInstanced)
+		mProgramInstanced->beginPass();
 }
 
 StandardMaterial::StandardMaterial()
@@ -100,19 +105,48 @@ StandardMaterial::StandardMaterial()
 			mProgram = std::make_unique<Program>(vs, fs);
 		});
 	});
+
+	// a missing variant gets the shared empty request, the queue then draws
+	// the material without instancing
+	const auto& vsInstanced = manager.load<Shader>("engine_data://shaders/vs_deferred_geom_instanced", false);
+	const auto& fs = manager.load<Shader>("engine_data://shaders/fs_deferred_geom", false);
+	if (vsInstanced.isReady() && fs.isReady())
+		mProgramInstanced = std::make_unique<Program>(vsInstanced.asset, fs.asset);
+	else
+		logging::get("Log")->warn().write("Instanced shaders are not compiled, instancing is disabled");
 }
 
 void StandardMaterial::submit()
 {
-	mProgram->setUniform("u_baseColor", &mBaseColor);
-	mProgram->setUniform("u_specularColor", &mSpecularColor);
-	mProgram->setUniform("u_emissiveColor", &mEmissiveColor);
-	mProgram->setUniform("u_surfaceData", &mSurfaceData);
-	mProgram->setUniform("u_tiling", &mTiling);
-	mProgram->setUniform("u_dither_threshold", &mDitherThreshold);
+	static constexpr UniformId u_baseColor = "u_baseColor";
+	static constexpr UniformId u_specularColor = "u_specularColor";
+	static constexpr UniformId u_emissiveColor = "u_emissiveColor";
+	static constexpr UniformId u_surfaceData = "u_surfaceData";
+	static constexpr UniformId u_tiling = "u_tiling";
+	static constexpr UniformId u_dither_threshold = "u_dither_threshold";
+	static constexpr UniformId s_texColor = "s_texColor";
+	static constexpr UniformId s_texNormal = "s_texNormal";
+
+	mProgram->setUniform(u_baseColor, &mBaseColor);
+	mProgram->setUniform(u_specularColor, &mSpecularColor);
+	mProgram->setUniform(u_emissiveColor, &mEmissiveColor);
+	mProgram->setUniform(u_surfaceData, &mSurfaceData);
+	mProgram->setUniform(u_tiling, &mTiling);
+	mProgram->setUniform(u_dither_threshold, &mDitherThreshold);
 
 	auto albedo = mColorMap ? mColorMap : mDefaultColorMap;
 	auto normal = mNormalMap ? mNormalMap : mDefaultNormalMap;
-	mProgram->setTexture(0, "s_texColor", albedo.get());
-	mProgram->setTexture(1, "s_texNormal", normal.get());
+	mProgram->setTexture(0, s_texColor, albedo.get());
+	mProgram->setTexture(1, s_texNormal, normal.get());
+}
+
+void StandardMaterial::requestTextureResolution(float pixels, std::uint32_t frame)
+{
+	// tiled textures repeat across the surface and need more texels
+	const auto texels = pixels * std::max(mTiling.x, mTiling.y);
+	for (const auto& texture : { mColorMap, mNormalMap, mRoughnessMap, mMetalnessMap })
+	{
+		if (texture)
+			texture->requestResolution(texels, frame);
+	}
 }
@@ -7,6 +7,7 @@
 #include "Core/reflection/rttr/rttr_enable.h"
 #include "Core/serialization/serialization.h"
 #include "Graphics/graphics.h"
+#include "Uniform.h"
 
 struct Program;
 struct Texture;
@@ -64,7 +65,7 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, FrameBuffer* _handle
 		, uint8_t _attachment = 0
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
@@ -78,7 +79,7 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, gfx::FrameBufferHandle _handle
 		, uint8_t _attachment = 0
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
@@ -92,7 +93,7 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, Texture* _texture
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
 
@@ -105,7 +106,7 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, gfx::TextureHandle _texture
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
 
@@ -117,7 +118,7 @@ public:
 	/// 
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void setUniform(const std::string& _name, const void* _value, std::uint16_t _num = 1);
+	void setUniform(const UniformId& _name, const void* _value, std::uint16_t _num = 1);
 
 	//-----------------------------------------------------------------------------
 	//  Name : getProgram ()
@@ -129,6 +130,15 @@ public:
 	//-----------------------------------------------------------------------------
 	inline Program* getProgram() const { return mProgram.get(); }
 
+	//-----------------------------------------------------------------------------
+	//  Name : getInstancedProgram ()
+	/// <summary>
+	/// Variant of the program that reads the world matrix from instance data.
+	/// Can be null if the material has no instanced variant.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline Program* getInstancedProgram() const { return mProgramInstanced.get(); }
+
 	//-----------------------------------------------------------------------------
 	//  Name : submit (virtual )
 	/// <summary>
@@ -139,6 +149,15 @@ public:
 	//-----------------------------------------------------------------------------
 	virtual void submit() {};
 
+	//-----------------------------------------------------------------------------
+	//  Name : requestTextureResolution (virtual )
+	/// <summary>
+	/// Passes the pixels the material spans on screen on to its textures so
+	/// the mips they need are streamed in.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void requestTextureResolution(float pixels, std::uint32_t frame) {}
+
 	//-----------------------------------------------------------------------------
 	//  Name : getCullType ()
 	/// <summary>
@@ -181,6 +200,8 @@ public:
 protected:
 	/// Program that is responsible for rendering.
 	std::unique_ptr<Program> mProgram;
+	/// Instanced variant of the program.
+	std::unique_ptr<Program> mProgramInstanced;
 	/// Cull type for this material.
 	CullType mCullType = CullType::CounterClockWise;
 	/// Default color texture
@@ -475,6 +496,16 @@ public:
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	virtual void submit();
+
+	//-----------------------------------------------------------------------------
+	//  Name : requestTextureResolution (virtual )
+	/// <summary>
+	/// 
+	/// 
+	/// 
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void requestTextureResolution(float pixels, std::uint32_t frame);
 private:
 	/// Base color
 	math::color mBaseColor
@@ -20,7 +20,7 @@ bool Mesh::isValid() const
 	return true;
 }
 
-void Mesh::submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, uint64_t _state) const
+static std::uint64_t getDefaultStates(std::uint64_t _state)
 {
 	if (BGFX_STATE_MASK == _state)
 	{
@@ -33,9 +33,13 @@ void Mesh::submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, u
 			| BGFX_STATE_MSAA
 			;
 	}
+	return _state;
+}
 
+void Mesh::submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, uint64_t _state, bool _preserveState) const
+{
 	gfx::setTransform(_mtx);
-	gfx::setState(_state);
+	gfx::setState(getDefaultStates(_state));
 
 	for (auto it = std::begin(groups), itEnd = std::end(groups); it != itEnd; ++it)
 	{
@@ -43,7 +47,21 @@ void Mesh::submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, u
 
 		gfx::setIndexBuffer(group.indexBuffer->handle);
 		gfx::setVertexBuffer(group.vertexBuffer->handle);
-		gfx::submit(_id, _program, 0, it != itEnd - 1);
+		gfx::submit(_id, _program, 0, _preserveState || it != itEnd - 1);
 	}
 }
 
+void Mesh::submitInstanced(uint8_t _id, gfx::ProgramHandle _program, const gfx::InstanceDataBuffer* _idb, uint64_t _state) const
+{
+	gfx::setInstanceDataBuffer(_idb);
+	gfx::setState(getDefaultStates(_state));
+
+	for (auto it = std::begin(groups), itEnd = std::end(groups); it != itEnd; ++it)
+	{
+		const auto& group = *it;
+
+		gfx::setIndexBuffer(group.indexBuffer->handle);
+		gfx::setVertexBuffer(group.vertexBuffer->handle);
+		gfx::submit(_id, _program, 0, it != itEnd - 1);
+	}
+}
@@ -52,7 +52,16 @@ struct Mesh
 	/// 
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, uint64_t _state) const;
+	void submit(uint8_t _id, gfx::ProgramHandle _program, const float* _mtx, uint64_t _state, bool _preserveState = false) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : submitInstanced ()
+	/// <summary>
+	/// Submits every group once, drawing one instance per entry of the
+	/// instance data buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void submitInstanced(uint8_t _id, gfx::ProgramHandle _program, const gfx::InstanceDataBuffer* _idb, uint64_t _state) const;
 
 	/// Vertex declaration for this mesh
 	gfx::VertexDecl decl;
@@ -62,4 +71,11 @@ struct Mesh
 	math::bbox aabb;
 	/// Mesh info
 	MeshInfo info;
+	/// Simplified lods cooked next to this mesh, named <key>_lod<n>
+	std::uint32_t lods = 0;
+	/// Object space positions kept on the cpu for occlusion culling, empty
+	/// for meshes too detailed to be useful occluders
+	std::vector<math::vec3> occluderVertices;
+	/// Triangle list into occluderVertices
+	std::vector<std::uint32_t> occluderIndices;
 };
\ No newline at end of file
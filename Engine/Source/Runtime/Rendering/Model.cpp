@@ -4,16 +4,24 @@
 #include "Core/math/math_includes.h"
 #include "../System/Application.h"
 #include "../Assets/AssetManager.h"
+#include "../Ecs/Utils.h"
 
 
 Model::Model()
 {
-	auto& app = Singleton<Application>::getInstance();
-	auto& manager = app.getAssetManager();
-	manager.load<Material>("engine_data://materials/standard", false)
-		.then([this](auto asset)
+	// the asset manager is main thread only, models deserialized on a
+	// worker get their default material once merged
+	ecs::utils::runOnMainThread([this]()
 	{
-		mMaterials.push_back(asset);
+		auto& app = Singleton<Application>::getInstance();
+		auto& manager = app.getAssetManager();
+		manager.load<Material>("engine_data://materials/standard", false)
+			.then([this](auto asset)
+		{
+			// deserialized materials replace the default one
+			if (mMaterials.empty())
+				mMaterials.push_back(asset);
+		});
 	});
 }
 
@@ -0,0 +1,299 @@
+#include "OcclusionBuffer.h"
+#include "Mesh.h"
+#include "../Threading/ThreadPool.h"
+#include "Core/math/mathfu/vectorial/simd4f.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	const std::uint32_t TileSize = 8;
+	/// Vertices closer than this in clip space w are clipped
+	const float NearW = 1e-5f;
+	/// Added to the depth of pixels outside a triangle so they never win
+	const float OutsidePenalty = 1e30f;
+
+	inline math::vec4 lerpClip(const math::vec4& a, const math::vec4& b)
+	{
+		const float t = (NearW - a.w) / (b.w - a.w);
+		return a + (b - a) * t;
+	}
+}
+
+OcclusionBuffer::OcclusionBuffer(std::uint32_t width, std::uint32_t height)
+	: mWidth(std::max(TileSize, (width + TileSize - 1) / TileSize * TileSize))
+	, mHeight(std::max(TileSize, (height + TileSize - 1) / TileSize * TileSize))
+{
+	mTilesX = mWidth / TileSize;
+	mTilesY = mHeight / TileSize;
+	mDepth.resize(mWidth * mHeight);
+	mTileDepth.resize(mTilesX * mTilesY);
+}
+
+void OcclusionBuffer::begin(const math::transform_t& viewProj)
+{
+	mViewProj = viewProj;
+	mTriangles.clear();
+	mStats = Stats();
+	std::fill(mDepth.begin(), mDepth.end(), FLT_MAX);
+	std::fill(mTileDepth.begin(), mTileDepth.end(), FLT_MAX);
+}
+
+bool OcclusionBuffer::addOccluder(const Mesh& mesh, const math::transform_t& world)
+{
+	if (mesh.occluderIndices.empty())
+		return false;
+
+	const math::mat4 mvp = mViewProj.matrix() * world.matrix();
+
+	const auto& vertices = mesh.occluderVertices;
+	const auto& indices = mesh.occluderIndices;
+	for (std::size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const math::vec4 v[3] =
+		{
+			mvp * math::vec4(vertices[indices[i]], 1.0f),
+			mvp * math::vec4(vertices[indices[i + 1]], 1.0f),
+			mvp * math::vec4(vertices[indices[i + 2]], 1.0f)
+		};
+
+		// clip against the near plane, which yields up to a quad
+		math::vec4 polygon[4];
+		std::uint32_t count = 0;
+		for (std::uint32_t j = 0; j < 3; ++j)
+		{
+			const auto& a = v[j];
+			const auto& b = v[(j + 1) % 3];
+			const bool aInside = a.w >= NearW;
+			const bool bInside = b.w >= NearW;
+			if (aInside)
+				polygon[count++] = a;
+			if (aInside != bInside)
+				polygon[count++] = lerpClip(a, b);
+		}
+
+		for (std::uint32_t j = 2; j < count; ++j)
+			setupTriangle(polygon[0], polygon[j - 1], polygon[j]);
+	}
+
+	++mStats.occluders;
+	return true;
+}
+
+void OcclusionBuffer::setupTriangle(const math::vec4& c0, const math::vec4& c1, const math::vec4& c2)
+{
+	const float width = float(mWidth);
+	const float height = float(mHeight);
+	auto toScreen = [width, height](const math::vec4& c)
+	{
+		const float invW = 1.0f / c.w;
+		return math::vec3((c.x * invW * 0.5f + 0.5f) * width, (0.5f - c.y * invW * 0.5f) * height, c.z * invW);
+	};
+
+	math::vec3 p[3] = { toScreen(c0), toScreen(c1), toScreen(c2) };
+
+	auto edge = [](const math::vec3& a, const math::vec3& b, const math::vec3& c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	};
+
+	// occluders are drawn two sided, so only the winding is normalized
+	float area = edge(p[0], p[1], p[2]);
+	if (area < 0.0f)
+	{
+		std::swap(p[1], p[2]);
+		area = -area;
+	}
+	if (area <= FLT_EPSILON)
+		return;
+
+	Triangle tri;
+	tri.minX = std::max(0, std::int32_t(std::floor(std::min({ p[0].x, p[1].x, p[2].x }))));
+	tri.minY = std::max(0, std::int32_t(std::floor(std::min({ p[0].y, p[1].y, p[2].y }))));
+	tri.maxX = std::min(std::int32_t(mWidth) - 1, std::int32_t(std::ceil(std::max({ p[0].x, p[1].x, p[2].x }))));
+	tri.maxY = std::min(std::int32_t(mHeight) - 1, std::int32_t(std::ceil(std::max({ p[0].y, p[1].y, p[2].y }))));
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+		return;
+
+	// edge i is opposite to vertex i and is its barycentric weight
+	tri.depthA = tri.depthB = tri.depthC = 0.0f;
+	for (std::uint32_t i = 0; i < 3; ++i)
+	{
+		const auto& a = p[(i + 1) % 3];
+		const auto& b = p[(i + 2) % 3];
+		tri.edgeA[i] = a.y - b.y;
+		tri.edgeB[i] = b.x - a.x;
+		tri.edgeC[i] = -(tri.edgeA[i] * a.x + tri.edgeB[i] * a.y);
+
+		tri.depthA += tri.edgeA[i] * p[i].z;
+		tri.depthB += tri.edgeB[i] * p[i].z;
+		tri.depthC += tri.edgeC[i] * p[i].z;
+	}
+
+	const float invArea = 1.0f / area;
+	tri.depthA *= invArea;
+	tri.depthB *= invArea;
+	tri.depthC *= invArea;
+
+	mTriangles.push_back(tri);
+	++mStats.triangles;
+}
+
+void OcclusionBuffer::rasterize(ThreadPool* threadPool)
+{
+	const std::uint32_t workers = threadPool ? std::uint32_t(threadPool->getWorkerCount()) : 0;
+	const std::uint32_t bands = std::max(1u, std::min(workers + 1, mTilesY));
+	if (mTriangles.empty())
+		return;
+
+	if (bands == 1)
+	{
+		rasterizeBand(0, mHeight);
+		return;
+	}
+
+	// bands are made of whole tile rows so each band builds its own tiles
+	auto parent = threadPool->createJob([]() {});
+	for (std::uint32_t band = 0; band < bands; ++band)
+	{
+		const std::uint32_t y0 = (mTilesY * band / bands) * TileSize;
+		const std::uint32_t y1 = (mTilesY * (band + 1) / bands) * TileSize;
+		threadPool->run(threadPool->createChildJob(parent, [this, y0, y1]()
+		{
+			rasterizeBand(y0, y1);
+		}));
+	}
+	threadPool->run(parent);
+	threadPool->wait(parent);
+}
+
+void OcclusionBuffer::rasterizeBand(std::uint32_t y0, std::uint32_t y1)
+{
+	const simd4f zero = simd4f_zero();
+	const simd4f penalty = simd4f_splat(OutsidePenalty);
+	const simd4f laneOffsets = simd4f_create(0.5f, 1.5f, 2.5f, 3.5f);
+
+	for (const auto& tri : mTriangles)
+	{
+		const std::int32_t rowBegin = std::max(tri.minY, std::int32_t(y0));
+		const std::int32_t rowEnd = std::min(tri.maxY, std::int32_t(y1) - 1);
+		if (rowBegin > rowEnd)
+			continue;
+
+		const simd4f edgeA0 = simd4f_splat(tri.edgeA[0]);
+		const simd4f edgeA1 = simd4f_splat(tri.edgeA[1]);
+		const simd4f edgeA2 = simd4f_splat(tri.edgeA[2]);
+		const simd4f depthA = simd4f_splat(tri.depthA);
+		const std::int32_t columnBegin = tri.minX & ~3;
+
+		for (std::int32_t y = rowBegin; y <= rowEnd; ++y)
+		{
+			const float py = float(y) + 0.5f;
+			const simd4f rowEdge0 = simd4f_splat(tri.edgeB[0] * py + tri.edgeC[0]);
+			const simd4f rowEdge1 = simd4f_splat(tri.edgeB[1] * py + tri.edgeC[1]);
+			const simd4f rowEdge2 = simd4f_splat(tri.edgeB[2] * py + tri.edgeC[2]);
+			const simd4f rowDepth = simd4f_splat(tri.depthB * py + tri.depthC);
+			float* row = &mDepth[y * mWidth];
+
+			for (std::int32_t x = columnBegin; x <= tri.maxX; x += 4)
+			{
+				const simd4f px = simd4f_add(simd4f_splat(float(x)), laneOffsets);
+				const simd4f e0 = simd4f_madd(edgeA0, px, rowEdge0);
+				const simd4f e1 = simd4f_madd(edgeA1, px, rowEdge1);
+				const simd4f e2 = simd4f_madd(edgeA2, px, rowEdge2);
+				const simd4f inside = simd4f_min(e0, simd4f_min(e1, e2));
+
+				// pixels outside the triangle get pushed behind everything
+				const simd4f outside = simd4f_mul(simd4f_max(simd4f_sub(zero, inside), zero), penalty);
+				const simd4f depth = simd4f_add(simd4f_madd(depthA, px, rowDepth), outside);
+				simd4f_ustore4(simd4f_min(simd4f_uload4(row + x), depth), row + x);
+			}
+		}
+	}
+
+	// farthest depth of every tile in the band
+	for (std::uint32_t ty = y0 / TileSize; ty < y1 / TileSize; ++ty)
+	{
+		for (std::uint32_t tx = 0; tx < mTilesX; ++tx)
+		{
+			simd4f farthest = simd4f_splat(-FLT_MAX);
+			for (std::uint32_t y = 0; y < TileSize; ++y)
+			{
+				const float* row = &mDepth[(ty * TileSize + y) * mWidth + tx * TileSize];
+				farthest = simd4f_max(farthest, simd4f_max(simd4f_uload4(row), simd4f_uload4(row + 4)));
+			}
+
+			float lanes[4];
+			simd4f_ustore4(farthest, lanes);
+			mTileDepth[ty * mTilesX + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+		}
+	}
+}
+
+bool OcclusionBuffer::isVisible(const math::bbox& bounds, const math::transform_t& world)
+{
+	++mStats.tested;
+
+	const math::mat4 mvp = mViewProj.matrix() * world.matrix();
+	const float width = float(mWidth);
+	const float height = float(mHeight);
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearest = FLT_MAX;
+	for (std::uint32_t i = 0; i < 8; ++i)
+	{
+		const math::vec3 corner(
+			(i & 1) ? bounds.max.x : bounds.min.x,
+			(i & 2) ? bounds.max.y : bounds.min.y,
+			(i & 4) ? bounds.max.z : bounds.min.z);
+		const math::vec4 clip = mvp * math::vec4(corner, 1.0f);
+
+		// crosses the near plane, assume visible
+		if (clip.w < NearW)
+			return true;
+
+		const float invW = 1.0f / clip.w;
+		const float x = (clip.x * invW * 0.5f + 0.5f) * width;
+		const float y = (0.5f - clip.y * invW * 0.5f) * height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearest = std::min(nearest, clip.z * invW);
+	}
+
+	const std::int32_t x0 = std::max(0, std::int32_t(std::floor(minX)));
+	const std::int32_t y0 = std::max(0, std::int32_t(std::floor(minY)));
+	const std::int32_t x1 = std::min(std::int32_t(mWidth) - 1, std::int32_t(std::floor(maxX)));
+	const std::int32_t y1 = std::min(std::int32_t(mHeight) - 1, std::int32_t(std::floor(maxY)));
+	if (x0 > x1 || y0 > y1)
+		return true;
+
+	for (std::int32_t ty = y0 / TileSize; ty <= y1 / std::int32_t(TileSize); ++ty)
+	{
+		for (std::int32_t tx = x0 / TileSize; tx <= x1 / std::int32_t(TileSize); ++tx)
+		{
+			// every pixel of the tile is nearer than the box
+			if (nearest > mTileDepth[ty * mTilesX + tx])
+				continue;
+
+			const std::int32_t py0 = std::max(y0, ty * std::int32_t(TileSize));
+			const std::int32_t py1 = std::min(y1, (ty + 1) * std::int32_t(TileSize) - 1);
+			const std::int32_t px0 = std::max(x0, tx * std::int32_t(TileSize));
+			const std::int32_t px1 = std::min(x1, (tx + 1) * std::int32_t(TileSize) - 1);
+			for (std::int32_t y = py0; y <= py1; ++y)
+			{
+				const float* row = &mDepth[y * mWidth];
+				for (std::int32_t x = px0; x <= px1; ++x)
+				{
+					if (nearest <= row[x])
+						return true;
+				}
+			}
+		}
+	}
+
+	++mStats.culled;
+	return false;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Core/math/math_includes.h"
+#include <cstdint>
+#include <vector>
+
+struct Mesh;
+class ThreadPool;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : OcclusionBuffer (Class)
+/// <summary>
+/// Low resolution depth buffer rasterized on the cpu from a few occluder
+/// meshes. Bounding boxes are tested against a max depth per 8x8 tile
+/// first and against the pixels only where the tile test is inconclusive.
+/// Works without a gpu, so it behaves the same on every renderer.
+/// </summary>
+//-----------------------------------------------------------------------------
+class OcclusionBuffer
+{
+public:
+	struct Stats
+	{
+		/// Occluders added since begin
+		std::uint32_t occluders = 0;
+		/// Triangles rasterized since begin
+		std::uint32_t triangles = 0;
+		/// Boxes tested since begin
+		std::uint32_t tested = 0;
+		/// Boxes found occluded since begin
+		std::uint32_t culled = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : OcclusionBuffer ()
+	/// <summary>
+	/// The size is rounded up to whole 8x8 tiles.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	OcclusionBuffer(std::uint32_t width = 256, std::uint32_t height = 128);
+
+	//-----------------------------------------------------------------------------
+	//  Name : begin ()
+	/// <summary>
+	/// Clears the buffer and the stats for a new view.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void begin(const math::transform_t& viewProj);
+
+	//-----------------------------------------------------------------------------
+	//  Name : addOccluder ()
+	/// <summary>
+	/// Transforms and clips the triangles of the mesh. Meshes without cpu
+	/// geometry are ignored. Returns true if the mesh was added.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool addOccluder(const Mesh& mesh, const math::transform_t& world);
+
+	//-----------------------------------------------------------------------------
+	//  Name : rasterize ()
+	/// <summary>
+	/// Rasterizes the added occluders and builds the tile depths. The buffer
+	/// is split in horizontal bands rasterized in parallel when a thread
+	/// pool is given.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rasterize(ThreadPool* threadPool);
+
+	//-----------------------------------------------------------------------------
+	//  Name : isVisible ()
+	/// <summary>
+	/// Tests an object space box with its world transform. Returns false only
+	/// if the box is completely hidden behind the occluders.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool isVisible(const math::bbox& bounds, const math::transform_t& world);
+
+	//-----------------------------------------------------------------------------
+	//  Name : getStats ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	const Stats& getStats() const { return mStats; }
+
+private:
+	struct Triangle
+	{
+		/// Edge functions, e = a * x + b * y + c
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		/// Depth plane, z = a * x + b * y + c
+		float depthA;
+		float depthB;
+		float depthC;
+		/// Screen rectangle, inclusive
+		std::int32_t minX;
+		std::int32_t minY;
+		std::int32_t maxX;
+		std::int32_t maxY;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : setupTriangle ()
+	/// <summary>
+	/// Projects a clip space triangle to the screen and stores its setup.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setupTriangle(const math::vec4& v0, const math::vec4& v1, const math::vec4& v2);
+
+	//-----------------------------------------------------------------------------
+	//  Name : rasterizeBand ()
+	/// <summary>
+	/// Rasterizes every triangle into the rows [y0, y1) and updates the tile
+	/// depths of these rows.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void rasterizeBand(std::uint32_t y0, std::uint32_t y1);
+
+	/// Size in pixels, multiples of the tile size
+	std::uint32_t mWidth;
+	std::uint32_t mHeight;
+	/// Size in tiles
+	std::uint32_t mTilesX;
+	std::uint32_t mTilesY;
+	/// View projection of the current view
+	math::transform_t mViewProj;
+	/// Nearest occluder depth per pixel
+	std::vector<float> mDepth;
+	/// Farthest pixel depth per tile
+	std::vector<float> mTileDepth;
+	/// Screen space triangles of the occluders
+	std::vector<Triangle> mTriangles;
+	/// Counters since begin
+	Stats mStats;
+};
@@ -3,6 +3,9 @@
 #include "FrameBuffer.h"
 #include "Texture.h"
 #include "Uniform.h"
+#include "Core/common/assert.hpp"
+#include <algorithm>
+#include <cstring>
 
 Program::Program(AssetHandle<Shader> computeShader)
 {
@@ -33,48 +36,62 @@ bool Program::isValid() const
 	return gfx::isValid(handle);
 }
 
-void Program::setTexture(std::uint8_t _stage, const std::string& _sampler, FrameBuffer* frameBuffer, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Program::setTexture(std::uint8_t _stage, const UniformId& _sampler, FrameBuffer* frameBuffer, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	if (!frameBuffer)
 		return;
 
-	gfx::setTexture(_stage, getUniform(_sampler)->handle, gfx::getTexture(frameBuffer->handle, _attachment), _flags);
+	setTexture(_stage, _sampler, frameBuffer->handle, _attachment, _flags);
 }
-void Program::setTexture(std::uint8_t _stage, const std::string& _sampler, gfx::FrameBufferHandle frameBuffer, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Program::setTexture(std::uint8_t _stage, const UniformId& _sampler, gfx::FrameBufferHandle frameBuffer, uint8_t _attachment /*= 0 */, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
-	gfx::setTexture(_stage, getUniform(_sampler)->handle, gfx::getTexture(frameBuffer, _attachment), _flags);
+	setTexture(_stage, _sampler, gfx::getTexture(frameBuffer, _attachment), _flags);
 }
-void Program::setTexture(std::uint8_t _stage, const std::string& _sampler, Texture* _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Program::setTexture(std::uint8_t _stage, const UniformId& _sampler, Texture* _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
 	if (!_texture)
 		return;
 
-	gfx::setTexture(_stage, getUniform(_sampler)->handle, _texture->handle, _flags);
+	setTexture(_stage, _sampler, _texture->handle, _flags);
 }
 
-void Program::setTexture(std::uint8_t _stage, const std::string& _sampler, gfx::TextureHandle _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
+void Program::setTexture(std::uint8_t _stage, const UniformId& _sampler, gfx::TextureHandle _texture, std::uint32_t _flags /*= std::numeric_limits<std::uint32_t>::max()*/)
 {
-	gfx::setTexture(_stage, getUniform(_sampler)->handle, _texture, _flags);
+	const auto hUniform = getUniformHandle(_sampler);
+
+	if (gfx::isValid(hUniform))
+		gfx::setTexture(_stage, hUniform, _texture, _flags);
 }
 
-void Program::setUniform(const std::string& _name, const void* _value, uint16_t _num)
+void Program::setUniform(const UniformId& _name, const void* _value, uint16_t _num)
 {
-	auto hUniform = getUniform(_name);
+	const auto hUniform = getUniformHandle(_name);
 
-	if (hUniform)
-		gfx::setUniform(hUniform->handle, _value, _num);
+	if (gfx::isValid(hUniform))
+		gfx::setUniform(hUniform, _value, _num);
+}
+
+gfx::UniformHandle Program::getUniformHandle(const UniformId& _name) const
+{
+	auto it = std::lower_bound(std::begin(uniforms), std::end(uniforms), _name.hash,
+		[](const UniformSlot& slot, std::uint32_t hash) { return slot.hash < hash; });
+
+	if (it != std::end(uniforms) && it->hash == _name.hash)
+		return it->handle;
+
+	return { gfx::invalidHandle };
 }
 
 std::shared_ptr<Uniform> Program::getUniform(const std::string& _name)
 {
-	std::shared_ptr<Uniform> hUniform;
-	auto it = uniforms.find(_name);
-	if (it != uniforms.end())
-	{
-		hUniform = it->second;
-	}
+	const UniformId id(_name);
+	auto it = std::lower_bound(std::begin(uniforms), std::end(uniforms), id.hash,
+		[](const UniformSlot& slot, std::uint32_t hash) { return slot.hash < hash; });
+
+	if (it != std::end(uniforms) && it->hash == id.hash)
+		return it->uniform;
 
-	return hUniform;
+	return nullptr;
 }
 
 void Program::addShader(AssetHandle<Shader> shader)
@@ -83,7 +100,20 @@ void Program::addShader(AssetHandle<Shader> shader)
 	shadersCached.push_back(shader->handle.idx);
 	for (auto& uniform : shader->uniforms)
 	{
-		uniforms[uniform->info.name] = uniform;
+		const UniformSlot slot = { core::fnv1a(uniform->info.name), uniform->handle, uniform };
+		auto it = std::lower_bound(std::begin(uniforms), std::end(uniforms), slot.hash,
+			[](const UniformSlot& other, std::uint32_t hash) { return other.hash < hash; });
+
+		if (it != std::end(uniforms) && it->hash == slot.hash)
+		{
+			// the same uniform used by several stages
+			Expects(std::strcmp(it->uniform->info.name, uniform->info.name) == 0);
+			*it = slot;
+		}
+		else
+		{
+			uniforms.insert(it, slot);
+		}
 	}
 }
 
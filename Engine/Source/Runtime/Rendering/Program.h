@@ -2,14 +2,14 @@
 
 #include "../Assets/AssetHandle.h"
 #include "Graphics/graphics.h"
+#include "Uniform.h"
 #include <vector>
-#include <unordered_map>
+#include <memory>
 #include <limits>
 
 struct FrameBuffer;
 struct Texture;
 struct Shader;
-struct Uniform;
 
 struct Program
 {
@@ -82,7 +82,7 @@ struct Program
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, FrameBuffer* _handle
 		, uint8_t _attachment = 0
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
@@ -96,7 +96,7 @@ struct Program
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, gfx::FrameBufferHandle _handle
 		, uint8_t _attachment = 0
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
@@ -110,7 +110,7 @@ struct Program
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, Texture* _texture
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
 	
@@ -123,7 +123,7 @@ struct Program
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void setTexture(std::uint8_t _stage
-		, const std::string& _sampler
+		, const UniformId& _sampler
 		, gfx::TextureHandle _texture
 		, std::uint32_t _flags = std::numeric_limits<std::uint32_t>::max());
 	
@@ -135,7 +135,7 @@ struct Program
 	/// 
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void setUniform(const std::string& _name, const void* _value, std::uint16_t _num = 1);
+	void setUniform(const UniformId& _name, const void* _value, std::uint16_t _num = 1);
 
 	//-----------------------------------------------------------------------------
 	//  Name : getUniform ()
@@ -147,6 +147,15 @@ struct Program
 	//-----------------------------------------------------------------------------
 	std::shared_ptr<Uniform> getUniform(const std::string& _name);
 
+	//-----------------------------------------------------------------------------
+	//  Name : getUniformHandle ()
+	/// <summary>
+	/// Finds the uniform slot by name hash. Returns an invalid handle if the
+	/// program does not use the uniform.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	gfx::UniformHandle getUniformHandle(const UniformId& _name) const;
+
 	//-----------------------------------------------------------------------------
 	//  Name : addShader ()
 	/// <summary>
@@ -181,8 +190,17 @@ struct Program
 	std::vector<AssetHandle<Shader>> shaders;
 	/// Shaders that created this program.
 	std::vector<std::uint16_t> shadersCached;
-	/// All uniforms for this program.
-	std::unordered_map<std::string, std::shared_ptr<Uniform>> uniforms;
+	struct UniformSlot
+	{
+		/// Hash of the uniform name.
+		std::uint32_t hash;
+		/// Handle used on the per draw path.
+		gfx::UniformHandle handle;
+		/// Keeps the uniform alive.
+		std::shared_ptr<Uniform> uniform;
+	};
+	/// All uniforms for this program sorted by name hash.
+	std::vector<UniformSlot> uniforms;
 	/// Internal handle
 	gfx::ProgramHandle handle = { gfx::invalidHandle };
 };
\ No newline at end of file
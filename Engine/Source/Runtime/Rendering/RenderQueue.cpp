@@ -0,0 +1,256 @@
+#include "RenderQueue.h"
+#include "Mesh.h"
+#include "Material.h"
+#include "Program.h"
+#include "Camera.h"
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	/// Upper bound of instances submitted with a single draw call
+	const std::size_t MaxInstancesPerDraw = 1024;
+	/// Instance data is the world matrix
+	const std::uint16_t InstanceStride = sizeof(math::mat4);
+
+	constexpr UniformId u_camera_wpos = "u_camera_wpos";
+	constexpr UniformId u_camera_clip_planes = "u_camera_clip_planes";
+	constexpr UniformId u_lod_params = "u_lod_params";
+
+	// Key layout, most significant bits first.
+	// opaque  : 0 | program 10 | material 12 | mesh 12 | states 5 | depth 24
+	// blended : 1 | ~depth 24  | program 10  | material 12 | mesh 12 | states 5
+	const std::uint32_t DepthBits = 24;
+	// program handles stay below bgfx's limit of 512 programs
+	const std::uint32_t ProgramBits = 10;
+	const std::uint32_t MaterialBits = 12;
+	const std::uint32_t MeshBits = 12;
+	const std::uint32_t StateBits = 5;
+	const std::uint64_t BlendedBit = std::uint64_t(1) << 63;
+
+	inline std::uint64_t field(std::uint32_t value, std::uint32_t bits)
+	{
+		return std::uint64_t(value) & ((std::uint64_t(1) << bits) - 1);
+	}
+
+	// ids past the width of their field share its last value, runs compare
+	// the pointers so such draws stay correct but are no longer grouped
+	template<typename Key>
+	std::uint32_t getId(std::unordered_map<Key, std::uint32_t>& ids, Key key, std::uint32_t bits)
+	{
+		auto it = ids.find(key);
+		if (it != ids.end())
+			return it->second;
+
+		const auto maxId = (std::uint32_t(1) << bits) - 1;
+		const auto id = std::min(static_cast<std::uint32_t>(ids.size()), maxId);
+		ids.emplace(key, id);
+		return id;
+	}
+
+	bool isBlended(std::uint64_t states)
+	{
+		return (states & BGFX_STATE_BLEND_MASK) != 0;
+	}
+}
+
+void RenderQueue::add(const Mesh* mesh, Material* material, std::uint64_t states, const math::transform_t& transform, float depth, const math::vec3& lodParams)
+{
+	if (!mesh || !material || !material->isValid())
+		return;
+
+	mItems.push_back({ mesh, material, states, transform, lodParams, depth });
+}
+
+void RenderQueue::clear()
+{
+	mItems.clear();
+	mKeys.clear();
+	mRuns.clear();
+	mMaterialIds.clear();
+	mMeshIds.clear();
+	mStateIds.clear();
+}
+
+void RenderQueue::buildKeys(float farClip)
+{
+	const float maxDepth = float((1 << DepthBits) - 1);
+	const float depthScale = farClip > 0.0f ? maxDepth / farClip : 0.0f;
+
+	mKeys.resize(mItems.size());
+	for (std::size_t i = 0; i < mItems.size(); ++i)
+	{
+		const auto& item = mItems[i];
+		const auto program = std::uint32_t(item.material->getProgram()->handle.idx);
+		const auto material = getId<const void*>(mMaterialIds, item.material, MaterialBits);
+		const auto mesh = getId<const void*>(mMeshIds, item.mesh, MeshBits);
+		const auto state = getId<std::uint64_t>(mStateIds, item.states, StateBits);
+		const auto depth = static_cast<std::uint32_t>(math::clamp(item.depth * depthScale, 0.0f, maxDepth));
+
+		std::uint64_t key = 0;
+		if (isBlended(item.states))
+		{
+			// back to front
+			key = BlendedBit;
+			key |= field(~depth, DepthBits) << (ProgramBits + MaterialBits + MeshBits + StateBits);
+			key |= field(program, ProgramBits) << (MaterialBits + MeshBits + StateBits);
+			key |= field(material, MaterialBits) << (MeshBits + StateBits);
+			key |= field(mesh, MeshBits) << StateBits;
+			key |= field(state, StateBits);
+		}
+		else
+		{
+			// grouped by state, front to back inside a group
+			key |= field(program, ProgramBits) << (MaterialBits + MeshBits + StateBits + DepthBits);
+			key |= field(material, MaterialBits) << (MeshBits + StateBits + DepthBits);
+			key |= field(mesh, MeshBits) << (StateBits + DepthBits);
+			key |= field(state, StateBits) << DepthBits;
+			key |= field(depth, DepthBits);
+		}
+
+		mKeys[i] = { key, static_cast<std::uint32_t>(i) };
+	}
+}
+
+void RenderQueue::sort()
+{
+	// least significant digit radix sort, one byte per pass
+	const std::size_t count = mKeys.size();
+	mScratch.resize(count);
+
+	SortEntry* src = mKeys.data();
+	SortEntry* dst = mScratch.data();
+	for (std::uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::size_t histogram[256] = {};
+		for (std::size_t i = 0; i < count; ++i)
+			++histogram[(src[i].key >> shift) & 0xff];
+
+		// every key shares this digit, nothing to reorder
+		if (histogram[(src[0].key >> shift) & 0xff] == count)
+			continue;
+
+		std::size_t offset = 0;
+		for (auto& bucket : histogram)
+		{
+			const auto size = bucket;
+			bucket = offset;
+			offset += size;
+		}
+
+		for (std::size_t i = 0; i < count; ++i)
+			dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+
+		std::swap(src, dst);
+	}
+
+	if (src != mKeys.data())
+		std::memcpy(mKeys.data(), src, count * sizeof(SortEntry));
+}
+
+void RenderQueue::buildRuns()
+{
+	const auto count = mKeys.size();
+	for (std::size_t begin = 0; begin < count;)
+	{
+		const auto& first = mItems[mKeys[begin].item];
+		std::size_t end = begin + 1;
+		while (end < count && end - begin < MaxInstancesPerDraw)
+		{
+			const auto& item = mItems[mKeys[end].item];
+			if (item.material != first.material ||
+				item.mesh != first.mesh ||
+				item.states != first.states ||
+				item.lodParams != first.lodParams)
+			{
+				break;
+			}
+			++end;
+		}
+
+		mRuns.push_back({ begin, end });
+		begin = end;
+	}
+}
+
+void RenderQueue::flush(std::uint8_t passId, const Camera& camera)
+{
+	if (mItems.empty())
+	{
+		clear();
+		return;
+	}
+
+	buildKeys(camera.getFarClip());
+	sort();
+	buildRuns();
+
+	const bool instancingSupported = (gfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0;
+	const auto cameraPosition = camera.getPosition();
+	const auto clipPlanes = math::vec2(camera.getNearClip(), camera.getFarClip());
+
+	// material whose uniforms and textures are currently bound
+	Material* boundMaterial = nullptr;
+	const math::vec3* boundLodParams = nullptr;
+
+	for (std::size_t r = 0; r < mRuns.size(); ++r)
+	{
+		const auto& run = mRuns[r];
+		const auto& first = mItems[mKeys[run.begin].item];
+		auto material = first.material;
+
+		if (material != boundMaterial)
+		{
+			material->beginPass();
+			material->setUniform(u_camera_wpos, &cameraPosition);
+			material->setUniform(u_camera_clip_planes, &clipPlanes);
+			material->submit();
+			boundMaterial = material;
+			boundLodParams = nullptr;
+		}
+
+		if (!boundLodParams || *boundLodParams != first.lodParams)
+		{
+			material->setUniform(u_lod_params, &first.lodParams);
+			boundLodParams = &first.lodParams;
+		}
+
+		// texture bindings are kept alive while the next run uses the same material
+		const bool nextSameMaterial = r + 1 < mRuns.size() &&
+			mItems[mKeys[mRuns[r + 1].begin].item].material == material;
+
+		const auto instances = static_cast<std::uint32_t>(run.end - run.begin);
+		const auto instancedProgram = material->getInstancedProgram();
+		if (instances > 1 &&
+			instancingSupported &&
+			instancedProgram && instancedProgram->isValid() &&
+			gfx::checkAvailInstanceDataBuffer(instances, InstanceStride))
+		{
+			const auto idb = gfx::allocInstanceDataBuffer(instances, InstanceStride);
+			auto data = idb->data;
+			for (std::size_t i = run.begin; i < run.end; ++i)
+			{
+				std::memcpy(data, static_cast<const float*>(mItems[mKeys[i].item].transform), InstanceStride);
+				data += InstanceStride;
+			}
+
+			// the instance buffer must not leak into the next draw
+			first.mesh->submitInstanced(passId, instancedProgram->handle, idb, first.states);
+			boundMaterial = nullptr;
+		}
+		else
+		{
+			for (std::size_t i = run.begin; i < run.end; ++i)
+			{
+				const auto& item = mItems[mKeys[i].item];
+				const bool preserve = i + 1 < run.end || nextSameMaterial;
+				item.mesh->submit(passId, material->getProgram()->handle, item.transform, item.states, preserve);
+			}
+
+			if (!nextSameMaterial)
+				boundMaterial = nullptr;
+		}
+	}
+
+	clear();
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Core/math/math_includes.h"
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+
+struct Mesh;
+class Material;
+class Camera;
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : RenderQueue (Class)
+/// <summary>
+/// Collects the draws of a view and submits them ordered by a packed 64 bit
+/// sort key. Opaque draws are grouped by program, material and mesh and
+/// drawn front to back, blended draws are drawn back to front. Consecutive
+/// draws of the same mesh and material are submitted as a single instanced
+/// draw call and material state is only applied when the material changes.
+/// </summary>
+//-----------------------------------------------------------------------------
+class RenderQueue
+{
+public:
+	//-----------------------------------------------------------------------------
+	//  Name : add ()
+	/// <summary>
+	/// Queues a draw. The mesh and material must stay alive until flush.
+	/// Depth is the distance to the camera and is used for ordering only.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void add(const Mesh* mesh
+		, Material* material
+		, std::uint64_t states
+		, const math::transform_t& transform
+		, float depth
+		, const math::vec3& lodParams);
+
+	//-----------------------------------------------------------------------------
+	//  Name : flush ()
+	/// <summary>
+	/// Sorts the queued draws, submits them to the pass and clears the queue.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void flush(std::uint8_t passId, const Camera& camera);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : empty ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool empty() const { return mItems.empty(); }
+
+private:
+	struct Item
+	{
+		/// Mesh lod to draw
+		const Mesh* mesh;
+		/// Material of the draw
+		Material* material;
+		/// Render states of the draw
+		std::uint64_t states;
+		/// World transform of the draw
+		math::transform_t transform;
+		/// Lod transition parameters
+		math::vec3 lodParams;
+		/// Distance to the camera
+		float depth;
+	};
+
+	struct SortEntry
+	{
+		/// Packed sort key
+		std::uint64_t key;
+		/// Index into mItems
+		std::uint32_t item;
+	};
+
+	struct Run
+	{
+		/// First sorted entry of the run
+		std::size_t begin;
+		/// One past the last sorted entry of the run
+		std::size_t end;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : buildKeys ()
+	/// <summary>
+	/// Packs the sort key of every queued draw.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void buildKeys(float farClip);
+
+	//-----------------------------------------------------------------------------
+	//  Name : sort ()
+	/// <summary>
+	/// Radix sorts mKeys.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void sort();
+
+	//-----------------------------------------------------------------------------
+	//  Name : buildRuns ()
+	/// <summary>
+	/// Splits the sorted draws into runs that share mesh, material, states
+	/// and lod parameters.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void buildRuns();
+
+	/// Queued draws in submission order
+	std::vector<Item> mItems;
+	/// Sort keys of the queued draws
+	std::vector<SortEntry> mKeys;
+	/// Scratch buffer of the radix sort
+	std::vector<SortEntry> mScratch;
+	/// Runs of sorted draws
+	std::vector<Run> mRuns;
+	/// Per flush ids of the materials
+	std::unordered_map<const void*, std::uint32_t> mMaterialIds;
+	/// Per flush ids of the meshes
+	std::unordered_map<const void*, std::uint32_t> mMeshIds;
+	/// Per flush ids of the render states
+	std::unordered_map<std::uint64_t, std::uint32_t> mStateIds;
+};
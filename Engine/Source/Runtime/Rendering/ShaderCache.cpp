@@ -0,0 +1,200 @@
+#include "ShaderCache.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+void ShaderCache::setDirectory(const fs::path& directory)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mDirectory = directory;
+	mEntries.clear();
+	mStats.bytes = 0;
+	if (mDirectory.empty())
+		return;
+
+	fs::create_directories(mDirectory, std::error_code{});
+
+	// entries found on disk are ordered by the time they were last used
+	std::vector<std::pair<fs::file_time_type, std::uint64_t>> found;
+	fs::directory_iterator end;
+	for (fs::directory_iterator it(mDirectory, std::error_code{}); it != end; ++it)
+	{
+		const auto& p = it->path();
+		if (!fs::is_regular_file(p, std::error_code{}))
+			continue;
+
+		// leftovers of interrupted writes
+		if (p.extension() == ".tmp")
+		{
+			fs::remove(p, std::error_code{});
+			continue;
+		}
+
+		const auto name = p.stem().string();
+		if (p.extension() != ".bin" || name.size() != 16 || name.find_first_not_of("0123456789abcdef") != std::string::npos)
+			continue;
+
+		const std::uint64_t id = std::stoull(name, nullptr, 16);
+		Entry entry;
+		entry.size = fs::file_size(p, std::error_code{});
+		mEntries[id] = entry;
+		mStats.bytes += entry.size;
+		found.emplace_back(fs::last_write_time(p, std::error_code{}), id);
+	}
+
+	std::sort(found.begin(), found.end());
+	for (const auto& pair : found)
+		mEntries[pair.second].lastUse = ++mUseCounter;
+
+	evict();
+}
+
+fs::path ShaderCache::getDirectory() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mDirectory;
+}
+
+void ShaderCache::setMaxSize(std::uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMaxSize = bytes;
+	evict();
+}
+
+std::uint32_t ShaderCache::readSize(std::uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mEntries.find(id);
+	if (it == mEntries.end())
+	{
+		mStats.misses++;
+		return 0;
+	}
+
+	mStats.hits++;
+	return static_cast<std::uint32_t>(it->second.size);
+}
+
+bool ShaderCache::read(std::uint64_t id, void* data, std::uint32_t size)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto it = mEntries.find(id);
+	if (it == mEntries.end())
+		return false;
+
+	const auto path = getPath(id);
+	std::ifstream stream(path.string(), std::ios::in | std::ios::binary);
+	if (it->second.size != size || !stream.read(static_cast<char*>(data), size))
+	{
+		stream.close();
+		remove(id);
+		return false;
+	}
+	stream.close();
+
+	// the file time carries the use order over to the next launch
+	it->second.lastUse = ++mUseCounter;
+	fs::last_write_time(path, fs::file_time_type::clock::now(), std::error_code{});
+	return true;
+}
+
+void ShaderCache::write(std::uint64_t id, const void* data, std::uint32_t size)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (mDirectory.empty() || size > mMaxSize)
+		return;
+
+	const auto path = getPath(id);
+	auto temp = path;
+	temp.replace_extension(".tmp");
+	{
+		std::ofstream stream(temp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!stream.write(static_cast<const char*>(data), size))
+		{
+			stream.close();
+			fs::remove(temp, std::error_code{});
+			return;
+		}
+	}
+
+	std::error_code err;
+	fs::rename(temp, path, err);
+	if (err)
+	{
+		// renaming over an existing file is not supported everywhere
+		fs::remove(path, std::error_code{});
+		err.clear();
+		fs::rename(temp, path, err);
+		if (err)
+		{
+			fs::remove(temp, std::error_code{});
+			remove(id);
+			return;
+		}
+	}
+
+	auto& entry = mEntries[id];
+	mStats.bytes -= entry.size;
+	entry.size = size;
+	entry.lastUse = ++mUseCounter;
+	mStats.bytes += entry.size;
+	mStats.writes++;
+
+	evict();
+}
+
+void ShaderCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	while (!mEntries.empty())
+		remove(mEntries.begin()->first);
+}
+
+ShaderCache::Stats ShaderCache::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	Stats stats = mStats;
+	stats.entries = mEntries.size();
+	return stats;
+}
+
+fs::path ShaderCache::getPath(std::uint64_t id) const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016" PRIx64 ".bin", id);
+	return mDirectory / name;
+}
+
+void ShaderCache::remove(std::uint64_t id)
+{
+	auto it = mEntries.find(id);
+	if (it == mEntries.end())
+		return;
+
+	fs::remove(getPath(id), std::error_code{});
+	mStats.bytes -= it->second.size;
+	mEntries.erase(it);
+}
+
+void ShaderCache::evict()
+{
+	if (mStats.bytes <= mMaxSize)
+		return;
+
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> order;
+	order.reserve(mEntries.size());
+	for (const auto& pair : mEntries)
+		order.emplace_back(pair.second.lastUse, pair.first);
+	std::sort(order.begin(), order.end());
+
+	for (const auto& pair : order)
+	{
+		if (mStats.bytes <= mMaxSize)
+			break;
+		remove(pair.second);
+		mStats.evictions++;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "../System/FileSystem.h"
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+//-----------------------------------------------------------------------------
+// Main Class Declarations
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//  Name : ShaderCache (Class)
+/// <summary>
+/// Disk backed store for the compiled programs the renderer hands out through
+/// its cache callbacks, so drivers do not compile and link every program on
+/// every launch. Entries are files named after the cache id. They are written
+/// to a temporary file first and renamed into place, so a crash never leaves
+/// a truncated entry behind. Once the cache grows over its size limit the
+/// least recently used entries are removed. Safe to call from any thread.
+/// </summary>
+//-----------------------------------------------------------------------------
+class ShaderCache
+{
+public:
+	struct Stats
+	{
+		/// Entries on disk
+		std::size_t entries = 0;
+		/// Size of all entries
+		std::uint64_t bytes = 0;
+		/// Reads that found an entry
+		std::size_t hits = 0;
+		/// Reads that did not
+		std::size_t misses = 0;
+		std::size_t writes = 0;
+		std::size_t evictions = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : setDirectory ()
+	/// <summary>
+	/// Directory of the entries. Existing entries in it are picked up. An
+	/// empty path disables the cache.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setDirectory(const fs::path& directory);
+
+	//-----------------------------------------------------------------------------
+	//  Name : getDirectory ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	fs::path getDirectory() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : setMaxSize ()
+	/// <summary>
+	/// Size in bytes the entries are kept under. Evicts right away if the
+	/// cache is over the new limit.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void setMaxSize(std::uint64_t bytes);
+
+	//-----------------------------------------------------------------------------
+	//  Name : readSize ()
+	/// <summary>
+	/// Size of the entry, 0 if there is none. Counts as a hit or a miss.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::uint32_t readSize(std::uint64_t id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : read ()
+	/// <summary>
+	/// Reads the entry into data. Fails if the entry is gone or its size
+	/// changed, the entry is then dropped.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool read(std::uint64_t id, void* data, std::uint32_t size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : write ()
+	/// <summary>
+	/// Stores or replaces the entry and evicts old entries if needed.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void write(std::uint64_t id, const void* data, std::uint32_t size);
+
+	//-----------------------------------------------------------------------------
+	//  Name : clear ()
+	/// <summary>
+	/// Removes all entries.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void clear();
+
+	//-----------------------------------------------------------------------------
+	//  Name : getStats ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Stats getStats() const;
+
+private:
+	struct Entry
+	{
+		/// Size of the file
+		std::uint64_t size = 0;
+		/// Higher values were used more recently
+		std::uint64_t lastUse = 0;
+	};
+
+	//-----------------------------------------------------------------------------
+	//  Name : getPath ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	fs::path getPath(std::uint64_t id) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : remove ()
+	/// <summary>
+	/// Deletes the entry file and forgets about it. Expects the lock held.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void remove(std::uint64_t id);
+
+	//-----------------------------------------------------------------------------
+	//  Name : evict ()
+	/// <summary>
+	/// Removes the least recently used entries until the cache fits its
+	/// limit. Expects the lock held.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void evict();
+
+	/// Guards everything below
+	mutable std::mutex mMutex;
+	/// Directory of the entries
+	fs::path mDirectory;
+	/// Entries by cache id
+	std::unordered_map<std::uint64_t, Entry> mEntries;
+	/// Size limit of the entries
+	std::uint64_t mMaxSize = 64 * 1024 * 1024;
+	/// Use counter, entries found on disk start ordered by their file time
+	std::uint64_t mUseCounter = 0;
+	/// Hit and miss counters
+	Stats mStats;
+};
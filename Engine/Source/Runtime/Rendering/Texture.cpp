@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include <algorithm>
 
 Texture::~Texture()
 {
@@ -134,3 +135,33 @@ uSize Texture::getSize() const
 
 	} // End if Relative
 }
+
+void Texture::requestResolution(float texels, std::uint32_t frame)
+{
+	if (!streaming.enabled)
+		return;
+
+	// the smallest mip whose larger side still covers the requested texels
+	std::uint8_t skip = 0;
+	float size = static_cast<float>(std::max(streaming.width, streaming.height));
+	while (skip + 1 < streaming.mipCount && size * 0.5f >= texels)
+	{
+		size *= 0.5f;
+		++skip;
+	}
+
+	if (streaming.requestedFrame != frame)
+	{
+		streaming.requestedFrame = frame;
+		streaming.requestedMips = skip;
+		streaming.requestedTexels = texels;
+	}
+	else
+	{
+		streaming.requestedMips = std::min(streaming.requestedMips, skip);
+		streaming.requestedTexels = std::max(streaming.requestedTexels, texels);
+	}
+
+	if (skip <= streaming.skippedMips)
+		streaming.neededFrame = frame;
+}
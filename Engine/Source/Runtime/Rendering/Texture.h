@@ -252,6 +252,49 @@ struct Texture : public ITexture
 	//-----------------------------------------------------------------------------
 	inline bool isRenderTarget() const { return 0 != (flags & BGFX_TEXTURE_RT_MASK); }
 
+	//-----------------------------------------------------------------------------
+	//  Name : requestResolution ()
+	/// <summary>
+	/// Called by the renderer with the number of texels the texture spans on
+	/// screen. The largest request of a frame decides which top mips the
+	/// TextureStreamer keeps resident.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void requestResolution(float texels, std::uint32_t frame);
+
+	struct Streaming
+	{
+		/// Whether the top mips of this texture are streamed on demand
+		bool enabled = false;
+		/// Size of the full texture
+		std::uint16_t width = 0;
+		std::uint16_t height = 0;
+		/// Mips of the full texture
+		std::uint8_t mipCount = 1;
+		/// Top mips left out of the resident texture
+		std::uint8_t skippedMips = 0;
+		/// Top mips left out when only the low resolution tail is resident
+		std::uint8_t tailMips = 0;
+		/// Top mips the next load leaves out, set by the streamer
+		std::uint8_t targetMips = 0;
+		/// Fewest top mips left out by a request of the last requested frame
+		std::uint8_t requestedMips = 0;
+		/// Largest request of the last requested frame
+		float requestedTexels = 0.0f;
+		std::uint32_t requestedFrame = 0;
+		/// Last frame the resident top mip was needed
+		std::uint32_t neededFrame = 0;
+		/// Video memory of the full texture
+		std::uint32_t fullSize = 0;
+		/// Set by the streamer when it reloads the texture. A successful
+		/// reload replaces the texture, so it is only still set on failure
+		bool reloading = false;
+		/// Failed reloads in a row
+		std::uint8_t failures = 0;
+		/// Frame before which a failed reload is not retried
+		std::uint32_t retryFrame = 0;
+	};
+
 	/// Texture detail info.
 	gfx::TextureInfo info;
 	/// Creation flags.
@@ -260,4 +303,6 @@ struct Texture : public ITexture
 	gfx::BackbufferRatio::Enum ratio = gfx::BackbufferRatio::Count;
 	/// Internal handle
 	gfx::TextureHandle handle = { gfx::invalidHandle };
+	/// Mip streaming state, only used by textures loaded from files
+	Streaming streaming;
 };
\ No newline at end of file
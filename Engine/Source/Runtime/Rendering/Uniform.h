@@ -1,6 +1,25 @@
 #pragma once
 
 #include "Graphics/graphics.h"
+#include "Core/common/hash.hpp"
+#include <string>
+
+//-----------------------------------------------------------------------------
+//  Name : UniformId
+/// <summary>
+/// Identifies a uniform by the hash of its name. Declare ids as constexpr
+/// so the name is hashed at compile time and the per draw lookups do not
+/// touch any strings.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct UniformId
+{
+	constexpr UniformId(const char* _name) : hash(core::fnv1a(_name)) {}
+	UniformId(const std::string& _name) : hash(core::fnv1a(_name.c_str())) {}
+
+	/// Hash of the uniform name.
+	std::uint32_t hash;
+};
 
 struct Uniform
 {
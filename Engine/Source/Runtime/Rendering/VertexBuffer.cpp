@@ -11,6 +11,7 @@ void VertexBuffer::dispose()
 		gfx::destroyVertexBuffer(handle);
 
 	handle = { bgfx::invalidHandle };
+	size = 0;
 }
 
 bool VertexBuffer::isValid() const
@@ -22,5 +23,8 @@ void VertexBuffer::populate(const gfx::Memory* _mem, const gfx::VertexDecl& _dec
 {
 	dispose();
 
+	// bgfx owns the memory once the buffer is created
+	const auto memSize = _mem ? _mem->size : 0;
 	handle = gfx::createVertexBuffer(_mem, _decl, _flags);
+	size = memSize;
 }
@@ -48,4 +48,6 @@ struct VertexBuffer
 
 	/// Internal handle
 	gfx::VertexBufferHandle handle = { gfx::invalidHandle };
+	/// Size of the data in bytes
+	std::uint32_t size = 0;
 };
\ No newline at end of file
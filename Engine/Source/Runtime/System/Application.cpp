@@ -6,16 +6,25 @@
 #include "../System/FileSystem.h"
 #include "../System/MessageBox.h"
 #include "../Threading/ThreadPool.h"
+#include "../Assets/AssetStreamer.h"
+#include "../Assets/TextureStreamer.h"
 #include "../Assets/AssetManager.h"
 #include "../Assets/AssetReader.h"
 #include "../Assets/AssetWriter.h"
 #include "../Rendering/RenderPass.h"
+#include "../Rendering/ShaderCache.h"
+#include "../Rendering/Texture.h"
+#include "../Rendering/Mesh.h"
+#include "../Rendering/VertexBuffer.h"
+#include "../Rendering/IndexBuffer.h"
 #include "../Rendering/Debug/DebugDraw.h"
 #include "../Rendering/RenderWindow.h"
 #include "../Input/InputContext.h"
 #include "../Ecs/World.h"
 #include "../Ecs/Prefab.h"
+#include "../Ecs/SceneLoader.h"
 #include "../Ecs/Systems/TransformSystem.h"
+#include "../Ecs/Systems/SpatialSystem.h"
 #include "../Ecs/Systems/CameraSystem.h"
 #include "../Ecs/Systems/RenderingSystem.h"
 
@@ -38,18 +47,22 @@ struct GfxCallback : public gfx::CallbackI
 		logger->error() << _str;
 	}
 
-	virtual uint32_t cacheReadSize(uint64_t /*_id*/) BX_OVERRIDE
+	virtual uint32_t cacheReadSize(uint64_t _id) BX_OVERRIDE
 	{
-		return 0;
+		auto& app = Singleton<Application>::getInstance();
+		return app.getShaderCache().readSize(_id);
 	}
 
-	virtual bool cacheRead(uint64_t /*_id*/, void* /*_data*/, uint32_t /*_size*/) BX_OVERRIDE
+	virtual bool cacheRead(uint64_t _id, void* _data, uint32_t _size) BX_OVERRIDE
 	{
-		return false;
+		auto& app = Singleton<Application>::getInstance();
+		return app.getShaderCache().read(_id, _data, _size);
 	}
 
-	virtual void cacheWrite(uint64_t /*_id*/, const void* /*_data*/, uint32_t /*_size*/) BX_OVERRIDE
+	virtual void cacheWrite(uint64_t _id, const void* _data, uint32_t _size) BX_OVERRIDE
 	{
+		auto& app = Singleton<Application>::getInstance();
+		app.getShaderCache().write(_id, _data, _size);
 	}
 
 	virtual void screenShot(const char* _filePath, uint32_t _width, uint32_t _height, uint32_t _pitch, const void* _data, uint32_t _size, bool _yflip) BX_OVERRIDE
@@ -80,6 +93,10 @@ Application::Application()
 	mAssetManager = std::make_unique<AssetManager>();
 	mTimer = std::make_unique<Timer>();
 	mThreadPool = std::make_unique<ThreadPool>();
+	mAssetStreamer = std::make_unique<AssetStreamer>(*mThreadPool);
+	mTextureStreamer = std::make_unique<TextureStreamer>();
+	mSceneLoader = std::make_unique<SceneLoader>(*mThreadPool, mWorld->entities);
+	mShaderCache = std::make_unique<ShaderCache>();
 	mActionMapper = std::make_unique<ActionMapper>();
 }
 
@@ -151,6 +168,10 @@ bool Application::registerMainWindow(RenderWindow& window)
 
 	gfx::setPlatformData(pd);
 
+	// programs the driver compiled on earlier launches are reused
+	if (mShaderCache->getDirectory().empty())
+		mShaderCache->setDirectory(fs::resolve_protocol("engine://Cache/Shaders"));
+
 	if (!gfx::init(gfx::RendererType::Count, 0, 0, &sGfxCallback))
 		return false;
 
@@ -217,6 +238,7 @@ bool Application::initAssetManager()
 	auto& manager = getAssetManager();
 	{
 		auto storage = manager.add<Shader>();
+		storage->name = "Shader";
 		storage->loadFromFile = AssetReader::loadShaderFromFile;
 		storage->loadFromMemory = AssetReader::loadShaderFromMemory;
 		storage->subdir = "runtime/";
@@ -249,28 +271,61 @@ bool Application::initAssetManager()
 	}
 	{
 		auto storage = manager.add<Texture>();
+		storage->name = "Texture";
 		storage->subdir = "runtime/";
+		storage->measure = [](const Texture& texture)
+		{
+			AssetSize size;
+			size.gpu = texture.info.storageSize;
+			return size;
+		};
 		storage->loadFromFile = AssetReader::loadTextureFromFile;
 		//storage->loadFromMemory = AssetReader::loadTextureFromMemory;
 	}
 	{
 		auto storage = manager.add<Mesh>();
+		storage->name = "Mesh";
 		storage->subdir = "runtime/";
+		storage->measure = [](const Mesh& mesh)
+		{
+			AssetSize size;
+			size.cpu = mesh.occluderVertices.size() * sizeof(math::vec3) + mesh.occluderIndices.size() * sizeof(std::uint32_t);
+			for (const auto& group : mesh.groups)
+			{
+				if (group.vertexBuffer)
+					size.gpu += group.vertexBuffer->size;
+				if (group.indexBuffer)
+					size.gpu += group.indexBuffer->size;
+			}
+			return size;
+		};
 		storage->loadFromFile = AssetReader::loadMeshFromFile;
 		//storage->loadFromMemory = AssetReader::loadMeshFromMemory;
 	}
 	{
 		auto storage = manager.add<Material>();
+		storage->name = "Material";
 		storage->subdir = "";
 		storage->loadFromFile = AssetReader::loadMaterialFromFile;
 		//storage->loadFromMemory = AssetReader::loadMaterialFromMemory;
 	}
 	{
 		auto storage = manager.add<Prefab>();
+		storage->name = "Prefab";
 		storage->subdir = "";
 		storage->loadFromFile = AssetReader::loadPrefabFromFile;
 	}
 
+	// a shipped application reads its assets from the pack built by the
+	// editor, the editor has no app: protocol yet and keeps the loose files
+	const auto packPath = fs::resolve_protocol("app://data.pack");
+	std::error_code err;
+	if (!packPath.empty() && fs::exists(packPath, err))
+	{
+		if (!manager.mountPack(packPath))
+			logging::get("Log")->error().write("Failed to mount asset pack {0}", packPath.string());
+	}
+
 	return true;
 }
 
@@ -313,6 +368,7 @@ bool Application::initSystems()
 {
 	auto& world = getWorld();
 	world.systems.add<TransformSystem>();
+	world.systems.add<SpatialSystem>();
 	world.systems.add<CameraSystem>();
 	world.systems.add<RenderingSystem>();
 	// Success!!
@@ -323,6 +379,7 @@ bool Application::initApplication()
 {
 	auto& world = getWorld();
 
+	world.systems.set_thread_pool(mThreadPool.get());
 	world.systems.configure();
 
 	ddInit();
@@ -382,12 +439,16 @@ bool Application::shutDown()
 	logger->info() << "Shutting down main application.";
 
 	mWindows.clear();
+	mSceneLoader.reset();
 	mWorld.reset();
 	mThreadPool.reset();
+	mAssetStreamer.reset();
+	mTextureStreamer.reset();
 	mAssetManager.reset();
 	mTimer.reset();
 
 	gfx::shutdown();
+	mShaderCache.reset();
 
 	// Shutdown Success
 	return true;
@@ -437,6 +498,8 @@ bool Application::frameBegin(bool bRunSimulation /* = true */)
 	mTimer->incrementFrameCounter();
 
 	mThreadPool->poll();
+	mAssetStreamer->update();
+	mSceneLoader->update();
 
 	// Success, continue on to render
 	return true;
@@ -501,4 +564,10 @@ void Application::frameEnd()
 	mRenderFrame = gfx::frame();
 
 	RenderPass::reset();
+
+	// stream texture mips for what was drawn this frame
+	mTextureStreamer->update(*mAssetManager, mTimer->getFrameCounter());
+
+	// evict unused assets when over budget
+	mAssetManager->update(mTimer->getFrameCounter());
 }
\ No newline at end of file
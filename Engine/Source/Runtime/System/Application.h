@@ -12,6 +12,10 @@
 class Timer;
 class AssetManager;
 class ThreadPool;
+class AssetStreamer;
+class TextureStreamer;
+class SceneLoader;
+class ShaderCache;
 class InputContext;
 class RenderWindow;
 struct World;
@@ -108,6 +112,38 @@ public:
 	//-----------------------------------------------------------------------------
 	inline ThreadPool& getThreadPool() { return *mThreadPool; }
 
+	//-----------------------------------------------------------------------------
+	//  Name : getAssetStreamer ()
+	/// <summary>
+	/// Schedules the asynchronous asset loads.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline AssetStreamer& getAssetStreamer() { return *mAssetStreamer; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getTextureStreamer ()
+	/// <summary>
+	/// Streams the top mips of textures in and out.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline TextureStreamer& getTextureStreamer() { return *mTextureStreamer; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getSceneLoader ()
+	/// <summary>
+	/// Loads scenes on the workers and merges them into the world.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline SceneLoader& getSceneLoader() { return *mSceneLoader; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : getShaderCache ()
+	/// <summary>
+	/// Keeps the programs compiled by the driver across launches.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	inline ShaderCache& getShaderCache() { return *mShaderCache; }
+
 	//-----------------------------------------------------------------------------
 	//  Name : getAssetManager ()
 	/// <summary>
@@ -392,6 +428,14 @@ protected:
 	std::unique_ptr<Timer> mTimer;
 	/// The Application's ThreadPool
 	std::unique_ptr<ThreadPool> mThreadPool;
+	/// The Application's Asset Streamer
+	std::unique_ptr<AssetStreamer> mAssetStreamer;
+	/// The Application's Texture Streamer
+	std::unique_ptr<TextureStreamer> mTextureStreamer;
+	/// The Application's Scene Loader
+	std::unique_ptr<SceneLoader> mSceneLoader;
+	/// The Application's Shader Cache
+	std::unique_ptr<ShaderCache> mShaderCache;
 	/// The Application's ActionMapper
 	std::unique_ptr<ActionMapper> mActionMapper;
 };
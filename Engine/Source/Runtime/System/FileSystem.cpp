@@ -183,3 +183,165 @@ namespace fs
 	}
 }
 #endif
+
+namespace fs
+{
+	mapped_file::mapped_file(const path& file_path)
+	{
+		open(file_path);
+	}
+
+	mapped_file::mapped_file(mapped_file&& other)
+	{
+		*this = std::move(other);
+	}
+
+	mapped_file& mapped_file::operator=(mapped_file&& other)
+	{
+		if (this != &other)
+		{
+			close();
+			std::swap(data_, other.data_);
+			std::swap(size_, other.size_);
+			std::swap(handle_, other.handle_);
+			std::swap(is_open_, other.is_open_);
+		}
+		return *this;
+	}
+
+	mapped_file::~mapped_file()
+	{
+		close();
+	}
+
+	void mapped_file::prefetch(std::size_t offset, std::size_t count) const
+	{
+		if (offset >= size_)
+			return;
+
+		const std::size_t page_size = 4096;
+		const std::size_t end = count < size_ - offset ? offset + count : size_;
+		volatile std::uint8_t sink = 0;
+		for (std::size_t i = offset; i < end; i += page_size)
+			sink = sink + data_[i];
+		// the range does not have to start on a page boundary
+		sink = sink + data_[end - 1];
+	}
+}
+
+#if defined(_WIN32)
+
+namespace fs
+{
+	bool mapped_file::open(const path& file_path)
+	{
+		close();
+
+		HANDLE file = CreateFileW(file_path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		is_open_ = true;
+		if (file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return true;
+		}
+
+		// the mapping keeps the file open, the file handle is not needed
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+		if (mapping == NULL)
+		{
+			is_open_ = false;
+			return false;
+		}
+
+		data_ = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (data_ == nullptr)
+		{
+			CloseHandle(mapping);
+			is_open_ = false;
+			return false;
+		}
+
+		handle_ = mapping;
+		size_ = static_cast<std::size_t>(file_size.QuadPart);
+		return true;
+	}
+
+	void mapped_file::close()
+	{
+		if (data_)
+			UnmapViewOfFile(data_);
+		if (handle_)
+			CloseHandle(static_cast<HANDLE>(handle_));
+
+		data_ = nullptr;
+		handle_ = nullptr;
+		size_ = 0;
+		is_open_ = false;
+	}
+}
+#else
+
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+namespace fs
+{
+	bool mapped_file::open(const path& file_path)
+	{
+		close();
+
+		const int fd = ::open(file_path.string().c_str(), O_RDONLY);
+		if (fd == -1)
+			return false;
+
+		struct stat file_stat;
+		if (fstat(fd, &file_stat) == -1)
+		{
+			::close(fd);
+			return false;
+		}
+
+		is_open_ = true;
+		if (file_stat.st_size == 0)
+		{
+			::close(fd);
+			return true;
+		}
+
+		// the mapping keeps the file alive, the descriptor is not needed
+		void* view = mmap(nullptr, static_cast<std::size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (view == MAP_FAILED)
+		{
+			is_open_ = false;
+			return false;
+		}
+
+		data_ = static_cast<const std::uint8_t*>(view);
+		size_ = static_cast<std::size_t>(file_stat.st_size);
+		return true;
+	}
+
+	void mapped_file::close()
+	{
+		if (data_)
+			munmap(const_cast<std::uint8_t*>(data_), size_);
+
+		data_ = nullptr;
+		size_ = 0;
+		is_open_ = false;
+	}
+}
+#endif
@@ -3,6 +3,8 @@
 #include <unordered_map>
 #include <istream>
 #include <filesystem>
+#include <vector>
+#include <cstdint>
 
 namespace fs
 {
@@ -40,6 +42,68 @@ namespace fs
 	//-----------------------------------------------------------------------------
 	ByteArray read_stream(std::istream& stream);
 
+	//-----------------------------------------------------------------------------
+	//  Name : mapped_file (Class)
+	/// <summary>
+	/// Read only view of a whole file mapped into memory. Pages are loaded by
+	/// the os on first access and can be dropped again under memory pressure,
+	/// so the file contents never have to be copied into a heap buffer.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+		explicit mapped_file(const path& file_path);
+		mapped_file(mapped_file&& other);
+		mapped_file& operator=(mapped_file&& other);
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		~mapped_file();
+
+		//-----------------------------------------------------------------------------
+		//  Name : open ()
+		/// <summary>
+		/// Maps the file, closing any previous mapping. Returns false if the
+		/// file could not be mapped. Empty files map to an empty view.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		bool open(const path& file_path);
+
+		//-----------------------------------------------------------------------------
+		//  Name : close ()
+		/// <summary>
+		/// 
+		/// 
+		/// 
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void close();
+
+		//-----------------------------------------------------------------------------
+		//  Name : prefetch ()
+		/// <summary>
+		/// Touches every page of the range so the reads from disk happen on the
+		/// calling thread instead of on the first access by the consumer.
+		/// </summary>
+		//-----------------------------------------------------------------------------
+		void prefetch(std::size_t offset = 0, std::size_t count = std::size_t(-1)) const;
+
+		bool is_open() const { return is_open_; }
+		const std::uint8_t* data() const { return data_; }
+		std::size_t size() const { return size_; }
+
+	private:
+		/// Start of the view
+		const std::uint8_t* data_ = nullptr;
+		/// Size of the view in bytes
+		std::size_t size_ = 0;
+		/// Platform mapping handle
+		void* handle_ = nullptr;
+		/// Was the file opened successfully
+		bool is_open_ = false;
+	};
+
 	//-----------------------------------------------------------------------------
 	//  Name : resolve_protocol()
 	/// <summary>
@@ -0,0 +1,374 @@
+#include "ThreadPool.h"
+#include "Core/common/spin.hpp"
+
+#include <deque>
+#include <algorithm>
+
+namespace
+{
+	/// pool the current thread is a worker of
+	thread_local const ThreadPool* sWorkerPool = nullptr;
+	/// queue index of the current worker
+	thread_local std::size_t sWorkerIndex = 0;
+	/// is the current thread executing a background job
+	thread_local bool sBackground = false;
+
+	/// Number of jobs moved between the thread local and the shared free list
+	const std::size_t JobBatchSize = 32;
+
+	// Free lists for recycling job memory. Each thread keeps a small local
+	// cache and exchanges whole batches with the shared list.
+	struct JobFreeList
+	{
+		~JobFreeList()
+		{
+			for (auto job : jobs)
+				::operator delete(job);
+		}
+
+		core::spin_mutex mutex;
+		std::vector<void*> jobs;
+	};
+
+	JobFreeList& getSharedFreeList()
+	{
+		static JobFreeList freeList;
+		return freeList;
+	}
+
+	struct JobCache
+	{
+		~JobCache()
+		{
+			auto& shared = getSharedFreeList();
+			std::lock_guard<core::spin_mutex> lock(shared.mutex);
+			shared.jobs.insert(shared.jobs.end(), jobs.begin(), jobs.end());
+		}
+
+		void* pop()
+		{
+			if (jobs.empty())
+			{
+				auto& shared = getSharedFreeList();
+				std::lock_guard<core::spin_mutex> lock(shared.mutex);
+				const auto count = std::min(JobBatchSize, shared.jobs.size());
+				jobs.insert(jobs.end(), shared.jobs.end() - count, shared.jobs.end());
+				shared.jobs.resize(shared.jobs.size() - count);
+			}
+
+			if (jobs.empty())
+				return ::operator new(sizeof(Job));
+
+			void* job = jobs.back();
+			jobs.pop_back();
+			return job;
+		}
+
+		void push(void* job)
+		{
+			jobs.push_back(job);
+			if (jobs.size() >= JobBatchSize * 2)
+			{
+				auto& shared = getSharedFreeList();
+				std::lock_guard<core::spin_mutex> lock(shared.mutex);
+				shared.jobs.insert(shared.jobs.end(), jobs.end() - JobBatchSize, jobs.end());
+				jobs.resize(jobs.size() - JobBatchSize);
+			}
+		}
+
+		std::vector<void*> jobs;
+	};
+
+	JobCache& getJobCache()
+	{
+		static thread_local JobCache cache;
+		return cache;
+	}
+}
+
+//-----------------------------------------------------------------------------
+//  Name : WorkQueue
+/// <summary>
+/// Per worker job deque. The owner pushes and pops at the back, thieves take
+/// from the front so the oldest work gets distributed first.
+/// </summary>
+//-----------------------------------------------------------------------------
+class WorkQueue
+{
+public:
+	void push(Job* job)
+	{
+		std::lock_guard<core::spin_mutex> lock(mMutex);
+		mJobs.push_back(job);
+	}
+
+	Job* pop()
+	{
+		std::lock_guard<core::spin_mutex> lock(mMutex);
+		if (mJobs.empty())
+			return nullptr;
+
+		Job* job = mJobs.back();
+		mJobs.pop_back();
+		return job;
+	}
+
+	Job* steal()
+	{
+		std::lock_guard<core::spin_mutex> lock(mMutex);
+		if (mJobs.empty())
+			return nullptr;
+
+		Job* job = mJobs.front();
+		mJobs.pop_front();
+		return job;
+	}
+
+private:
+	/// Guards the deque, held only for a push or a pop
+	core::spin_mutex mMutex;
+	/// Queued jobs
+	std::deque<Job*> mJobs;
+};
+
+Job* Job::allocate()
+{
+	return new (getJobCache().pop()) Job();
+}
+
+void Job::release(Job* job)
+{
+	if (job->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	Job* parent = job->parent;
+	job->~Job();
+	getJobCache().push(job);
+
+	if (parent)
+		release(parent);
+}
+
+ThreadPool::ThreadPool(unsigned int threads)
+	: mPendingJobs(0)
+	, mSleepingWorkers(0)
+	, mStopped(false)
+{
+	// the last queue is shared by all threads outside the pool
+	for (unsigned int i = 0; i < threads + 1; ++i)
+		mQueues.emplace_back(std::make_unique<WorkQueue>());
+	mBackgroundQueue = std::make_unique<WorkQueue>();
+
+	for (unsigned int i = 0; i < threads; ++i)
+	{
+		auto worker = std::thread([this, i]
+		{
+			workerLoop(i);
+		});
+		thread_utils::setThreadName(&worker, string_utils::format("Worker_Thread_%d", i));
+		mWorkers.emplace_back(std::move(worker));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	shutdown();
+}
+
+void ThreadPool::workerLoop(std::size_t index)
+{
+	sWorkerPool = this;
+	sWorkerIndex = index;
+
+	for (;;)
+	{
+		Job* job = getJob(true);
+		if (job)
+		{
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		++mSleepingWorkers;
+		mCondition.wait(lock, [this]()
+		{
+			return mStopped || mPendingJobs > 0;
+		});
+		--mSleepingWorkers;
+
+		if (mStopped && mPendingJobs <= 0)
+			return;
+	}
+}
+
+std::size_t ThreadPool::getQueueIndex() const
+{
+	return sWorkerPool == this ? sWorkerIndex : mQueues.size() - 1;
+}
+
+bool ThreadPool::isBackground()
+{
+	return sBackground;
+}
+
+Job* ThreadPool::getJob(bool background)
+{
+	const auto index = getQueueIndex();
+	const auto count = mQueues.size();
+	const bool isWorker = index != count - 1;
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto& queue = *mQueues[(index + i) % count];
+		Job* job = (i == 0 && isWorker) ? queue.pop() : queue.steal();
+		if (job)
+		{
+			--mPendingJobs;
+			return job;
+		}
+	}
+
+	if (background)
+	{
+		Job* job = mBackgroundQueue->steal();
+		if (job)
+		{
+			--mPendingJobs;
+			return job;
+		}
+	}
+
+	return nullptr;
+}
+
+void ThreadPool::run(const JobHandle& job)
+{
+	Expects(job);
+
+	Job::addRef(job.get());
+
+	// counted before the push so a worker never sleeps on a queued job
+	++mPendingJobs;
+	// without workers nobody else would pick up a background job
+	if (job.get()->background && !mWorkers.empty())
+		mBackgroundQueue->push(job.get());
+	else
+		mQueues[getQueueIndex()]->push(job.get());
+
+	if (mSleepingWorkers > 0)
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mCondition.notify_one();
+	}
+}
+
+void ThreadPool::execute(Job* job)
+{
+	const bool background = sBackground;
+	sBackground = job->background;
+	job->execute();
+	sBackground = background;
+	finish(job);
+	// reference taken by run
+	Job::release(job);
+}
+
+void ThreadPool::finish(Job* job)
+{
+	if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+	{
+		if (job->parent)
+			finish(job->parent);
+	}
+}
+
+void ThreadPool::wait(const JobHandle& job)
+{
+	// a short job never waits behind a long one
+	const bool background = job && job.get()->background;
+	while (!isFinished(job))
+	{
+		Job* pending = getJob(background);
+		if (pending)
+			execute(pending);
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool ThreadPool::tryExecute()
+{
+	Job* job = getJob(false);
+	if (!job)
+		return false;
+
+	execute(job);
+	return true;
+}
+
+bool ThreadPool::isFinished(const JobHandle& job) const
+{
+	if (!job)
+		return true;
+
+	return job.get()->unfinished.load(std::memory_order_acquire) == 0;
+}
+
+std::size_t ThreadPool::getWorkerCount() const
+{
+	return mWorkers.size();
+}
+
+void ThreadPool::notifyCompleted(std::shared_ptr<ITask> task)
+{
+	std::lock_guard<std::mutex> lock(mCompletedMutex);
+	mCompleted.emplace_back(std::move(task));
+}
+
+void ThreadPool::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopped = true;
+	}
+	mCondition.notify_all();
+
+	for (auto &worker : mWorkers)
+		worker.join();
+
+	mWorkers.clear();
+}
+
+void ThreadPool::poll()
+{
+	// only the tasks completed since the last poll are touched here
+	std::vector<std::shared_ptr<ITask>> completed;
+	{
+		std::lock_guard<std::mutex> lock(mCompletedMutex);
+		completed.swap(mCompleted);
+	}
+
+	for (auto& result : completed)
+	{
+		// the task reports before its job has finished, the callback
+		// waits for the next poll then
+		if (!result->isReady())
+		{
+			std::lock_guard<std::mutex> lock(mCompletedMutex);
+			mCompleted.emplace_back(std::move(result));
+			continue;
+		}
+
+		if (result->claimCallback())
+			result->invokeCallback();
+	}
+}
+
+void ThreadPool::poll(std::shared_ptr<ITask> result)
+{
+	if (result->isReady() && result->claimCallback())
+	{
+		result->invokeCallback();
+	}
+}
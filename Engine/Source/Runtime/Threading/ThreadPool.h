@@ -4,281 +4,297 @@
 #include "Core/common/assert.hpp"
 
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-#include <future>
 #include <functional>
-#include <stdexcept>
-
-struct ITask
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+class ThreadPool;
+class WorkQueue;
+
+//-----------------------------------------------------------------------------
+//  Name : Job
+/// <summary>
+/// Unit of work executed by the ThreadPool. Small callables are stored inline
+/// to avoid a heap allocation per job. A job is finished once its own
+/// function and all of its child jobs have completed.
+/// </summary>
+//-----------------------------------------------------------------------------
+struct Job
 {
-	virtual ~ITask() = default;
+	/// Size of the inline callable storage
+	static constexpr std::size_t StorageSize = 88;
+	using Function = void(*)(void*);
+
 	//-----------------------------------------------------------------------------
-	//  Name : isReady (virtual )
+	//  Name : ~Job ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Destroys the stored callable if the job was never executed.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual bool isReady() const = 0;
+	~Job()
+	{
+		if (destroy)
+			destroy(callable);
+	}
 
 	//-----------------------------------------------------------------------------
-	//  Name : invokeCallback (virtual )
+	//  Name : setFunction ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Stores the callable. Uses the inline storage when it fits and falls
+	/// back to the heap otherwise.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void invokeCallback() = 0;
+	template<typename F>
+	void setFunction(F&& function);
 
 	//-----------------------------------------------------------------------------
-	//  Name : waitUntilReady (virtual )
+	//  Name : execute ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Invokes and destroys the stored callable.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void waitUntilReady() = 0;
-};
+	void execute()
+	{
+		invoke(callable);
+		destroy(callable);
+		invoke = nullptr;
+		destroy = nullptr;
+		callable = nullptr;
+	}
 
-template<typename ReturnType>
-struct TTask : public ITask
-{
 	//-----------------------------------------------------------------------------
-	//  Name : Task ()
+	//  Name : allocate (static )
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Gets a job from the thread local cache. The returned job has a
+	/// reference count of one.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	explicit TTask(std::shared_future<ReturnType> f)
-		: sharedFuture(f)
-	{}
+	static Job* allocate();
 
 	//-----------------------------------------------------------------------------
-	//  Name : isReady (virtual )
+	//  Name : addRef (static )
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Increments the reference count of the job.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual bool isReady() const
+	static void addRef(Job* job)
 	{
-		return sharedFuture.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready;
+		job->refs.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	//-----------------------------------------------------------------------------
-	//  Name : waitUntilReady (virtual )
+	//  Name : release (static )
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Decrements the reference count of the job and recycles it (and releases
+	/// its parent) when it drops to zero.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void waitUntilReady()
-	{
-		sharedFuture.get();
-	}
+	static void release(Job* job);
+
+	/// Invokes the stored callable
+	Function invoke = nullptr;
+	/// Destroys the stored callable
+	Function destroy = nullptr;
+	/// Points either into the inline storage or to a heap allocation
+	void* callable = nullptr;
+	/// Parent job which waits on this one
+	Job* parent = nullptr;
+	/// Own work plus the number of unfinished children
+	std::atomic<std::uint32_t> unfinished{ 1 };
+	/// Reference count (handles, scheduler and children)
+	std::atomic<std::uint32_t> refs{ 1 };
+	/// Long running job, see ThreadPool::createBackgroundJob
+	bool background = false;
+	/// Inline callable storage
+	typename std::aligned_storage<StorageSize, alignof(std::max_align_t)>::type storage;
+
+private:
+	template<typename F>
+	void store(F&& function, std::true_type);
+	template<typename F>
+	void store(F&& function, std::false_type);
+};
 
+//-----------------------------------------------------------------------------
+//  Name : JobHandle
+/// <summary>
+/// Reference counted handle to a job. Keeps the job alive so it can be
+/// waited on after it has finished.
+/// </summary>
+//-----------------------------------------------------------------------------
+class JobHandle
+{
+public:
+	JobHandle() = default;
 	//-----------------------------------------------------------------------------
-	//  Name : getResult ()
+	//  Name : JobHandle ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Adopts a reference that was already taken on the job.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	ReturnType& getResult() const
+	explicit JobHandle(Job* job) : mJob(job) {}
+	JobHandle(const JobHandle& other) : mJob(other.mJob) { if (mJob) Job::addRef(mJob); }
+	JobHandle(JobHandle&& other) : mJob(other.mJob) { other.mJob = nullptr; }
+	~JobHandle() { reset(); }
+
+	JobHandle& operator=(JobHandle other)
 	{
-		return sharedFuture.get();
+		std::swap(mJob, other.mJob);
+		return *this;
 	}
 
-	//-----------------------------------------------------------------------------
-	//  Name : invokeCallback (virtual )
-	/// <summary>
-	/// 
-	/// 
-	/// 
-	/// </summary>
-	//-----------------------------------------------------------------------------
-	virtual void invokeCallback()
+	void reset()
 	{
+		if (mJob)
+			Job::release(mJob);
+		mJob = nullptr;
 	}
 
-	/// shared future holding the result
-	std::shared_future<ReturnType> sharedFuture;
+	Job* get() const { return mJob; }
+	explicit operator bool() const { return mJob != nullptr; }
+private:
+	/// The referenced job
+	Job* mJob = nullptr;
 };
 
-template<>
-struct TTask<void> : public ITask
+struct ITask;
+template<typename ReturnType, typename OnReadyFunc>
+struct Task;
+
+class ThreadPool
 {
+public:
 	//-----------------------------------------------------------------------------
-	//  Name : Task ()
+	//  Name : ThreadPool ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Launches the worker threads. Each worker owns a job queue and steals
+	/// from the others when it runs dry.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	explicit TTask(std::shared_future<void> f)
-		: sharedFuture(f)
-	{}
+	ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
 
 	//-----------------------------------------------------------------------------
-	//  Name : isReady (virtual )
+	//  Name : ~ThreadPool ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	///
+	///
+	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual bool isReady() const
-	{
-		return sharedFuture.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready;
-	}
+	~ThreadPool();
 
 	//-----------------------------------------------------------------------------
-	//  Name : waitUntilReady (virtual )
+	//  Name : createJob ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Creates a job which is not scheduled until run is called on it.
+	/// Jobs created while a background job runs are background jobs too.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void waitUntilReady()
-	{
-		sharedFuture.get();
-	}
+	template<typename F>
+	JobHandle createJob(F&& function);
 
 	//-----------------------------------------------------------------------------
-	//  Name : getResult ()
+	//  Name : createBackgroundJob ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Creates a job for long running work like scene and asset loads. Such
+	/// jobs are queued separately and only executed by the workers, or by a
+	/// thread waiting on a background job, so waiting on a short job never
+	/// stalls behind them.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	void getResult() const
-	{
-		return sharedFuture.get();
-	}
+	template<typename F>
+	JobHandle createBackgroundJob(F&& function);
 
 	//-----------------------------------------------------------------------------
-	//  Name : invokeCallback (virtual )
+	//  Name : createChildJob ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Creates a job that the parent will wait for. Must be called before the
+	/// parent has finished, usually from within the parent's function.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void invokeCallback()
-	{
-	}
-	/// shared future holding the result
-	std::shared_future<void> sharedFuture;
-};
+	template<typename F>
+	JobHandle createChildJob(const JobHandle& parent, F&& function);
 
-template<typename ReturnType, typename OnReadyFunc>
-struct Task : public TTask<ReturnType>
-{
 	//-----------------------------------------------------------------------------
-	//  Name : Task ()
+	//  Name : schedule ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Creates and runs a job.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	Task(std::shared_future<ReturnType> f, OnReadyFunc&& readyFunction)
-		: TTask<ReturnType>(f)
-		, onReady(readyFunction)
-	{}
+	template<typename F>
+	JobHandle schedule(F&& function);
 
 	//-----------------------------------------------------------------------------
-	//  Name : invokeCallback (virtual )
+	//  Name : scheduleBackground ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Creates and runs a background job.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void invokeCallback()
-	{
-		onReady();
-	}
-	/// ready callback
-	OnReadyFunc onReady;
-};
+	template<typename F>
+	JobHandle scheduleBackground(F&& function);
 
-template<typename OnReadyFunc>
-struct Task<void, OnReadyFunc> : public TTask<void>
-{
 	//-----------------------------------------------------------------------------
-	//  Name : Task ()
+	//  Name : run ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Pushes the job to the queue of the calling worker, or to the shared
+	/// queue when called from a thread outside the pool. Background jobs go
+	/// to the background queue.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	explicit Task(std::shared_future<void> f, OnReadyFunc&& readyFunction)
-		: TTask(f)
-		, onReady(readyFunction)
-	{}
+	void run(const JobHandle& job);
 
 	//-----------------------------------------------------------------------------
-	//  Name : invokeCallback (virtual )
+	//  Name : wait ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Executes other pending jobs until the given job and its children
+	/// have finished. Background jobs are only picked up while waiting on
+	/// a background job.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	virtual void invokeCallback()
-	{
-		onReady();
-	}
-	/// ready callback
-	OnReadyFunc onReady;
-};
+	void wait(const JobHandle& job);
 
-class ThreadPool
-{
-public:
 	//-----------------------------------------------------------------------------
-	//  Name : ThreadPool ()
+	//  Name : tryExecute ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Executes one pending job on the calling thread, never a background
+	/// job. Returns false if there was nothing to do.
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
+	bool tryExecute();
 
 	//-----------------------------------------------------------------------------
-	//  Name : ~ThreadPool ()
+	//  Name : isFinished ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	///
+	///
+	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
-	~ThreadPool();
+	bool isFinished(const JobHandle& job) const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : getWorkerCount ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t getWorkerCount() const;
 
 	//-----------------------------------------------------------------------------
 	//  Name : enqueue_with_callback ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Runs the function as a background job and invokes the callback from
+	/// poll on the thread that polls the pool.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	template<class F, class C, class... Args>
@@ -288,9 +304,7 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : poll ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Invokes the callbacks of the tasks completed since the last poll.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void poll();
@@ -298,9 +312,8 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : poll ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	/// Invokes the callback of the task if it is ready and the callback was
+	/// not invoked yet.
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void poll(std::shared_ptr<ITask> result);
@@ -308,134 +321,455 @@ public:
 	//-----------------------------------------------------------------------------
 	//  Name : shutdown ()
 	/// <summary>
-	/// 
-	/// 
-	/// 
+	///
+	///
+	///
 	/// </summary>
 	//-----------------------------------------------------------------------------
 	void shutdown();
 private:
+	//-----------------------------------------------------------------------------
+	//  Name : workerLoop ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void workerLoop(std::size_t index);
+
+	//-----------------------------------------------------------------------------
+	//  Name : getQueueIndex ()
+	/// <summary>
+	/// Returns the worker queue index of the calling thread or the index of the
+	/// shared queue for threads outside the pool.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	std::size_t getQueueIndex() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : isBackground (static )
+	/// <summary>
+	/// True while the calling thread executes a background job.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	static bool isBackground();
+
+	//-----------------------------------------------------------------------------
+	//  Name : getJob ()
+	/// <summary>
+	/// Pops from the local queue and steals from the others if it is empty.
+	/// The background queue is tried last when background is set.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Job* getJob(bool background);
+
+	//-----------------------------------------------------------------------------
+	//  Name : execute ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void execute(Job* job);
+
+	//-----------------------------------------------------------------------------
+	//  Name : finish ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void finish(Job* job);
+
+	//-----------------------------------------------------------------------------
+	//  Name : notifyCompleted ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void notifyCompleted(std::shared_ptr<ITask> task);
+
 	/// need to keep track of threads so we can join them
-	std::vector< std::thread > mWorkers;
-	/// the task queue
-	std::queue< std::function<void()> > mTasks;
-	/// the result array
-	std::vector<std::shared_ptr<ITask>> mResults;
-	/// Mutex for synchronization of the tasks
-	std::mutex mTaskMutex;
+	std::vector<std::thread> mWorkers;
+	/// one queue per worker plus a shared one for outside threads
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	/// queue of the background jobs
+	std::unique_ptr<WorkQueue> mBackgroundQueue;
+	/// tasks whose callbacks are waiting to be invoked
+	std::vector<std::shared_ptr<ITask>> mCompleted;
+	/// Mutex for synchronization of the completed tasks
+	std::mutex mCompletedMutex;
+	/// Mutex used by idle workers
+	std::mutex mSleepMutex;
 	/// Condition variable for notifying threads
 	std::condition_variable mCondition;
-	/// Mutex for synchronization of the results
-	std::mutex mResultMutex;
+	/// Number of jobs pushed but not yet popped
+	std::atomic<int> mPendingJobs;
+	/// Number of sleeping workers
+	std::atomic<int> mSleepingWorkers;
 	/// Is pool stopped
 	std::atomic<bool> mStopped;
 };
 
-// the constructor just launches some amount of workers
-inline ThreadPool::ThreadPool(unsigned int threads)
-	: mStopped(false)
+struct ITask
+{
+	virtual ~ITask() = default;
+	//-----------------------------------------------------------------------------
+	//  Name : isReady (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isReady() const = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : invokeCallback (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void invokeCallback() = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : waitUntilReady (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void waitUntilReady() = 0;
+
+	//-----------------------------------------------------------------------------
+	//  Name : isCancelled (virtual )
+	/// <summary>
+	/// True if the task was dropped before its callback ran. The callback of
+	/// a cancelled task is never invoked.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isCancelled() const { return false; }
+
+	//-----------------------------------------------------------------------------
+	//  Name : claimCallback ()
+	/// <summary>
+	/// Returns true only for the first caller so the callback is invoked once.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	bool claimCallback()
+	{
+		return !callbackClaimed.exchange(true);
+	}
+
+	/// whether the callback was already claimed
+	std::atomic<bool> callbackClaimed{ false };
+};
+
+template<typename ReturnType>
+struct TTask : public ITask
 {
-	for (unsigned int i = 0; i < threads; ++i)
+	//-----------------------------------------------------------------------------
+	//  Name : TTask ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit TTask(ThreadPool& pool)
+		: owner(pool)
+	{}
+
+	//-----------------------------------------------------------------------------
+	//  Name : ~TTask (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual ~TTask()
 	{
-		auto worker = std::thread([this]
-		{
-			std::function<void()> task;
-			for (;;)
-			{
-				{
-					std::unique_lock<std::mutex> lock(mTaskMutex);
-					mCondition.wait(lock,
-						[this]()
-					{
-						return mStopped || !mTasks.empty();
-					});
-					if (mStopped && mTasks.empty())
-						return;
-					task = std::move(mTasks.front());
-					mTasks.pop();
-				}
-				task();
-			}
-		});
-		thread_utils::setThreadName(&worker, string_utils::format("Worker_Thread_%d", i));
-		mWorkers.emplace_back(std::move(worker));
+		if (hasResult)
+			reinterpret_cast<ReturnType*>(&result)->~ReturnType();
 	}
-}
 
-// add new work item to the pool
-template<class F, class C, class... Args>
-inline auto ThreadPool::enqueue_with_callback(F&& f, C&& callback, Args&&... args)
--> std::shared_ptr<Task<typename std::result_of<F(Args...)>::type, C>>
+	//-----------------------------------------------------------------------------
+	//  Name : isReady (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isReady() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : waitUntilReady (virtual )
+	/// <summary>
+	/// Helps executing other jobs until this one is done.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void waitUntilReady();
+
+	//-----------------------------------------------------------------------------
+	//  Name : getResult ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	ReturnType& getResult()
+	{
+		waitUntilReady();
+		return *reinterpret_cast<ReturnType*>(&result);
+	}
+
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Invokes the function and stores its result. Called by the worker.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void run(F& function)
+	{
+		new (&result) ReturnType(function());
+		hasResult = true;
+	}
+
+	/// pool executing the task
+	ThreadPool& owner;
+	/// job executing the task
+	JobHandle job;
+	/// storage for the result
+	typename std::aligned_storage<sizeof(ReturnType), alignof(ReturnType)>::type result;
+	/// whether the result was constructed
+	bool hasResult = false;
+};
+
+template<>
+struct TTask<void> : public ITask
 {
-	Expects(!mStopped);
+	//-----------------------------------------------------------------------------
+	//  Name : TTask ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	explicit TTask(ThreadPool& pool)
+		: owner(pool)
+	{}
 
-	using return_type = typename std::result_of<F(Args...)>::type;
+	//-----------------------------------------------------------------------------
+	//  Name : isReady (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual bool isReady() const;
+
+	//-----------------------------------------------------------------------------
+	//  Name : waitUntilReady (virtual )
+	/// <summary>
+	/// Helps executing other jobs until this one is done.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void waitUntilReady();
 
-	auto task = std::make_shared< std::packaged_task<return_type()> >
-		(
-			std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-			);
+	//-----------------------------------------------------------------------------
+	//  Name : getResult ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	void getResult()
+	{
+		waitUntilReady();
+	}
 
-	std::shared_future<return_type> res = task->get_future();
+	//-----------------------------------------------------------------------------
+	//  Name : run ()
+	/// <summary>
+	/// Invokes the function. Called by the worker.
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	template<typename F>
+	void run(F& function)
 	{
-		std::unique_lock<std::mutex> lock(mTaskMutex);
-		mTasks.emplace([task]() { (*task)(); });
+		function();
 	}
-	auto sharedFutureWrapper = std::make_shared<Task<return_type, C>>(res, std::forward<C>(callback));
+
+	/// pool executing the task
+	ThreadPool& owner;
+	/// job executing the task
+	JobHandle job;
+};
+
+template<typename ReturnType, typename OnReadyFunc>
+struct Task : public TTask<ReturnType>
+{
+	//-----------------------------------------------------------------------------
+	//  Name : Task ()
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	Task(ThreadPool& pool, OnReadyFunc&& readyFunction)
+		: TTask<ReturnType>(pool)
+		, onReady(std::forward<OnReadyFunc>(readyFunction))
+	{}
+
+	//-----------------------------------------------------------------------------
+	//  Name : invokeCallback (virtual )
+	/// <summary>
+	///
+	///
+	///
+	/// </summary>
+	//-----------------------------------------------------------------------------
+	virtual void invokeCallback()
 	{
-		std::unique_lock<std::mutex> lock(mResultMutex);
-		mResults.push_back(sharedFutureWrapper);
+		onReady();
 	}
+	/// ready callback
+	typename std::decay<OnReadyFunc>::type onReady;
+};
+
+template<typename F>
+inline void Job::setFunction(F&& function)
+{
+	using function_type = typename std::decay<F>::type;
+	using fits = std::integral_constant<bool,
+		sizeof(function_type) <= StorageSize && alignof(function_type) <= alignof(std::max_align_t)>;
+
+	store(std::forward<F>(function), fits());
+}
 
-	mCondition.notify_one();
+template<typename F>
+inline void Job::store(F&& function, std::true_type)
+{
+	using function_type = typename std::decay<F>::type;
+	callable = new (&storage) function_type(std::forward<F>(function));
+	invoke = [](void* f) { (*static_cast<function_type*>(f))(); };
+	destroy = [](void* f) { static_cast<function_type*>(f)->~function_type(); };
+}
+
+template<typename F>
+inline void Job::store(F&& function, std::false_type)
+{
+	using function_type = typename std::decay<F>::type;
+	callable = new function_type(std::forward<F>(function));
+	invoke = [](void* f) { (*static_cast<function_type*>(f))(); };
+	destroy = [](void* f) { delete static_cast<function_type*>(f); };
+}
 
-	return sharedFutureWrapper;
+template<typename F>
+inline JobHandle ThreadPool::createJob(F&& function)
+{
+	Job* job = Job::allocate();
+	job->background = isBackground();
+	job->setFunction(std::forward<F>(function));
+	return JobHandle(job);
 }
 
-inline ThreadPool::~ThreadPool()
+template<typename F>
+inline JobHandle ThreadPool::createBackgroundJob(F&& function)
 {
-	shutdown();
+	auto job = createJob(std::forward<F>(function));
+	job.get()->background = true;
+	return job;
 }
 
-// the destructor joins all threads
-inline void ThreadPool::shutdown()
+template<typename F>
+inline JobHandle ThreadPool::createChildJob(const JobHandle& parent, F&& function)
 {
-	mStopped = true;
-	
-	mCondition.notify_all();
+	Expects(parent);
 
-	for (auto &worker : mWorkers)
-		worker.join();
+	Job* parentJob = parent.get();
+	parentJob->unfinished.fetch_add(1, std::memory_order_relaxed);
+	Job::addRef(parentJob);
 
-	mWorkers.clear();
+	Job* job = Job::allocate();
+	job->parent = parentJob;
+	job->background = parentJob->background;
+	job->setFunction(std::forward<F>(function));
+	return JobHandle(job);
 }
 
-inline void ThreadPool::poll()
+template<typename F>
+inline JobHandle ThreadPool::schedule(F&& function)
 {
-	std::vector<std::shared_ptr<ITask>> result_container;
-	{
-		std::unique_lock<std::mutex> lock(mResultMutex);
-		result_container = mResults;
-	}
+	auto job = createJob(std::forward<F>(function));
+	run(job);
+	return job;
+}
 
-	for (auto result : result_container)
-	{
-		poll(result);
-	}
+template<typename F>
+inline JobHandle ThreadPool::scheduleBackground(F&& function)
+{
+	auto job = createBackgroundJob(std::forward<F>(function));
+	run(job);
+	return job;
 }
 
-inline void ThreadPool::poll(std::shared_ptr<ITask> result)
+// add new work item to the pool
+template<class F, class C, class... Args>
+inline auto ThreadPool::enqueue_with_callback(F&& f, C&& callback, Args&&... args)
+-> std::shared_ptr<Task<typename std::result_of<F(Args...)>::type, C>>
 {
-	if (result->isReady())
+	Expects(!mStopped);
+
+	using return_type = typename std::result_of<F(Args...)>::type;
+
+	auto task = std::make_shared<Task<return_type, C>>(*this, std::forward<C>(callback));
+	auto function = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
+
+	task->job = createBackgroundJob([this, task, function]() mutable
 	{
-		{
-			std::unique_lock<std::mutex> lock(mResultMutex);
-			mResults.erase(std::remove_if(std::begin(mResults), std::end(mResults),
-				[result](std::shared_ptr<ITask> res)
-			{
-				return res == result;
-			}), std::end(mResults));
-		}
-		result->invokeCallback();
-	}
-}
\ No newline at end of file
+		task->run(function);
+		notifyCompleted(std::move(task));
+	});
+	run(task->job);
+
+	return task;
+}
+
+template<typename ReturnType>
+inline bool TTask<ReturnType>::isReady() const
+{
+	return owner.isFinished(job);
+}
+
+template<typename ReturnType>
+inline void TTask<ReturnType>::waitUntilReady()
+{
+	owner.wait(job);
+}
+
+inline bool TTask<void>::isReady() const
+{
+	return owner.isFinished(job);
+}
+
+inline void TTask<void>::waitUntilReady()
+{
+	owner.wait(job);
+}